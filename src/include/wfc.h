@@ -1,12 +1,18 @@
 #ifndef WFC_H_
 #define WFC_H_
 
-#include "wfc_canvas.h"
+#include "wfc_solver.h"
+#include "wfc_parser.h"
 
 #include <string>
 
 namespace wfc {
 
+class Canvas;
+class SolverThread;
+class OverlappingModel;
+class EdgeRules;
+
 /*
  * Check the health of the config file and performs necessary actions to begin processing the file
  *
@@ -20,25 +26,77 @@ namespace wfc {
 void check_config_file(const std::filesystem::path& p_config_path);
 
 /*
- * Creates a wfc::Canvas object by parsing the config at the given path
- * Also initializes SDL
+ * Creates a wfc::Solver object by parsing the config at the given path, or by loading it from a
+ * ruleset file if the path ends in .wfcb
+ * Does not need SDL
+ *
+ * Params:
+ *       String     p_config_path: Path to the config or ruleset file
+ *       CanvasInfo p_canvas_info: Filled with the canvas config
+ *
+ * Returns:
+ *        Pointer to the allocated solver object
+ */
+wfc::Solver* init(const std::string& p_config_path, wfc::CanvasInfo& p_canvas_info);
+
+/*
+ * Add the patterns of a model to the solver as one pixel tiles, showing the top left pixel of
+ * their pattern, with the patterns they overlap with as the only tiles allowed on each side
+ *
+ * Params:
+ *       Solver*          p_solver  : Solver to add the tiles to
+ *       OverlappingModel p_model   : Model learned from a sample
+ *       DirectionType    p_dir_type: Directions to add rules for
+ */
+void add_patterns(wfc::Solver* p_solver, const wfc::OverlappingModel& p_model, wfc::DirectionType p_dir_type);
+
+/*
+ * Add the rules inferred from tile edges to the tiles that asked for them. The tiles whose edges
+ * match are the only tiles allowed on each side, an edge that matches nothing allows no tile
+ *
+ * Params:
+ *       Solver*          p_solver    : Solver the tiles were added to
+ *       EdgeRules        p_edge_rules: Compiled edge rules of all tiles, in the order of p_tiles
+ *       Vector<TileInfo> p_tiles     : Parsed tiles, in the order they were added
+ */
+void add_edge_rules(wfc::Solver* p_solver, const wfc::EdgeRules& p_edge_rules,
+                    const std::vector<wfc::TileInfo>& p_tiles);
+
+/*
+ * Parse a config and compile its rules into a ruleset file that init can load without parsing
+ * Does not need SDL
  *
  * Params:
  *       String p_config_path: Path to the config file
+ *       Path   p_output     : Path of the ruleset file to write
+ *
+ * Throws:
+ *       If the config is invalid or the file can not be written
+ */
+void compile_ruleset(const std::string& p_config_path, const std::filesystem::path& p_output);
+
+/*
+ * Creates a wfc::Canvas object showing the given solver
+ * Also initializes SDL
+ *
+ * Params:
+ *       CanvasInfo p_canvas_info: Canvas config returned by init
+ *       Solver*    p_solver     : Solver to show
  *
  * Returns:
  *        Pointer to the allocated canvas object
  */
-wfc::Canvas* init(const std::string& p_config_path);
+wfc::Canvas* init_canvas(const wfc::CanvasInfo& p_canvas_info, const wfc::Solver* p_solver);
 
 /*
  * Poll SDL events
  *
  * Params:
- *       bool        p_running: Reference to the bool that controls the main loop
- *       wfc::Canvas p_canvas : Current canvas
+ *       bool              p_running: Reference to the bool that controls the main loop
+ *       wfc::SolverThread p_solver : Thread running the current solver, receives the commands
+ *       wfc::Canvas       p_canvas : Canvas showing the solver
  */
-void poll_events(bool& p_running, wfc::Canvas* p_canvas);
+void poll_events(bool& p_running, wfc::SolverThread* p_solver, wfc::Canvas* p_canvas);
 
 /*
  * Destroys the given canvas objec
@@ -49,6 +107,14 @@ void poll_events(bool& p_running, wfc::Canvas* p_canvas);
  */
 void free(wfc::Canvas* canvas);
 
+/*
+ * Destroys the given solver object
+ *
+ * Params:
+ *       wfc::Solver* solver: Pointer to the solver object to destroy
+ */
+void free(wfc::Solver* solver);
+
 };
 
 #endif // !WFC_H_
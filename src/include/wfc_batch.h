@@ -0,0 +1,103 @@
+#ifndef WFC_BATCH_H_
+#define WFC_BATCH_H_
+
+#include "wfc_solver.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdlib>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+namespace wfc {
+
+/*
+ * Solves many instances of one configured solver on a pool of worker threads
+ *
+ * Instance i is solved with seed p_seed_start + i exactly like a single run with that seed, so
+ * every output can be reproduced on its own. Workers take instances from a shared counter and
+ * each owns two solvers, so it keeps solving the next instance while the calling thread consumes
+ * the previous one.
+ */
+class Batch {
+public:
+  /*
+   * Function called with the index of an instance and its solver, or nullptr if the instance
+   * was not solved within the allowed attempts
+   */
+  using Consumer = std::function<void(size_t, const wfc::Solver*)>;
+
+  /*
+   * Construct the batch
+   *
+   * Params:
+   *       Solver p_solver : Solver with all tiles, rules, constraints and settings, it is copied
+   *                         twice per worker
+   *       size_t p_threads: Number of worker threads, at least 1
+   */
+  Batch(const wfc::Solver& p_solver, size_t p_threads);
+
+  /*
+   * Solve the instances, consuming each one on the calling thread as soon as it is done
+   *
+   * Params:
+   *       uint64_t p_seed_start  : Seed of the first instance
+   *       size_t   p_count       : Number of instances
+   *       size_t   p_max_attempts: Number of attempts per instance, 0 for no limit
+   *       Consumer p_consume     : Called once per instance, in the order they finish
+   *
+   * Returns:
+   *        Number of instances that were solved
+   */
+  size_t run(uint64_t p_seed_start, size_t p_count, size_t p_max_attempts, const Consumer& p_consume);
+
+private:
+  struct Slot {
+    wfc::Solver solver;
+    bool busy;
+  };
+
+  struct Result {
+    size_t index;
+    Slot* slot;
+    bool solved;
+  };
+
+  std::vector<std::vector<Slot>> slots__;
+  std::atomic<size_t> next_index__;
+  std::mutex mutex__;
+  std::condition_variable ready__;
+  std::condition_variable released__;
+  std::deque<Result> results__;
+
+  /*
+   * Solve instances with the solvers of the given worker until none are left
+   *
+   * Params:
+   *       size_t   p_worker      : Index of the worker in slots__
+   *       uint64_t p_seed_start  : Seed of the first instance
+   *       size_t   p_count       : Number of instances
+   *       size_t   p_max_attempts: Number of attempts per instance, 0 for no limit
+   */
+  void work__(size_t p_worker, uint64_t p_seed_start, size_t p_count, size_t p_max_attempts);
+
+  /*
+   * Solve one instance with the attempts of its seed
+   *
+   * Params:
+   *       Solver   p_solver      : Solver to use
+   *       uint64_t p_seed        : Seed of the instance
+   *       size_t   p_max_attempts: Number of attempts, 0 for no limit
+   *
+   * Returns:
+   *        true if an attempt collapsed every spot, else false
+   */
+  static bool solve__(wfc::Solver& p_solver, uint64_t p_seed, size_t p_max_attempts);
+};
+
+}
+
+#endif // !WFC_BATCH_H_
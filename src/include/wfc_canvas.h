@@ -1,201 +1,219 @@
 #ifndef WFC_CANVAS_H_
 #define WFC_CANVAS_H_
 
-#include "wfc_directions.h"
+#include "wfc_compositor.h"
+#include "wfc_solver.h"
+#include "wfc_solver_thread.h"
 #include "wfc_tile.h"
-#include "wfc_utils.h"
 
 #include <cstdint>
 #include <cstdlib>
-#include <string>
-#include <unordered_map>
-#include <filesystem>
 #include <vector>
-#include <unordered_set>
 
 #include <SDL2/SDL.h>
 
 namespace wfc {
 
-struct Spot {
-  wfc::Tile* tile;
-  std::unordered_set<wfc::Tile*> possible_tiles;
-  Spot() : tile(nullptr), possible_tiles{} {
-  }
-};
-
+/*
+ * SDL window showing snapshots of a solver
+ *
+ * The canvas only reads the size and tiles of the solver, the collapsed tiles are passed to each
+ * render so the solver can keep running on another thread. The images of all tiles are packed into a
+ * single atlas texture when the canvas is created, so spots are drawn as quads of one
+ * SDL_RenderGeometry call. The window shows the grid through a camera that can be panned and
+ * zoomed, and only the spots in view are drawn. Once spots are only a few pixels wide they are
+ * drawn as one pixel of the average colour of their tile each, scaled up to the spot size, so
+ * zoomed out views cost at most a pixel per spot in view and never more than the window size. The
+ * view is kept drawn in a target texture, so a frame only redraws the spots that changed since the
+ * last one.
+ */
 class Canvas {
 public:
   /*
    * Construct the canvas with the given specifications
    *
    * Params:
-   *       size_t p_width : Width of the canavas
-   *       size_t p_height: Height of the canvas
-   *       size_t p_rows  : Number of rows in the canvas
-   *       size_t columns : Number of columns in the canvas
+   *       size_t  p_width : Width of the canavas
+   *       size_t  p_height: Height of the canvas
+   *       Solver* p_solver: Solver to draw, must outlive the canvas and keep its tiles
    *
    * Throws:
    *       If SDL Window creation fails
    *       If SDL Renderer creation fails
+   *       If the image of a tile fails to load
+   *       If the tile images do not all have the same size
    */
-  Canvas(size_t p_width, size_t p_height, size_t p_rows, size_t p_columns);
+  Canvas(size_t p_width, size_t p_height, const wfc::Solver* p_solver);
 
   /*
    * Destroy the canvas and all the resources it holds
    */
   ~Canvas();
 
-  /*
-   * Set direction type
-   *
-   * Params:
-   *       DirectionType p_dir_type: Direction type to set
-   */
-  void set_direction_type(const wfc::DirectionType p_dir_type);
+  Canvas(const Canvas&) = delete;
+  Canvas& operator=(const Canvas&) = delete;
 
   /*
-   * Add possible tiles for the canvas
+   * Render a state of the solver using SDL window. Only the given spots are drawn again, unless
+   * a full redraw is pending
    *
    * Params:
-   *       String p_name: Name of the tile
-   *       String p_path: Path to the tile image
-   *
-   * Throws:
-   *       If tile with name p_name already exists in tiles__
+   *       Vector<uint32_t> p_tiles: Id of the tile collapsed into each spot, wfc::NO_TILE if
+   *                                 the spot is not collapsed
+   *       Vector<uint32_t> p_dirty: Indices of the spots that changed since the last render
    */
-  void add_tile(const std::string& p_name, const std::string& p_path);
+  void render(const std::vector<uint32_t>& p_tiles, const std::vector<uint32_t>& p_dirty);
 
   /*
-   * Add rule to a tile in the canvas
-   *
-   * Params:
-   *       String     p_for: Name of the tile for which to add the rule
-   *       Directions p_dir: Direction to add the rule in
-   *       String     p_to : Name of the tile in the rule
-   *
-   * Throws:
-   *       If tile with name p_for or p_to does not exist in tiles__
+   * Draw every spot on the next render, for example after the renderer lost its render targets
    */
-  void add_rule(const std::string& p_for, wfc::Directions p_dir, const std::string& p_to);
+  void redraw();
 
   /*
-   * Add more than one rule of placement for tile in the canvas
-   *
-   * Params:
-   *       String         p_for: Name of the tile for which to add the rule
-   *       Directions     p_dir: Direction to add the rule in
-   *       Vector<String> p_to : List of names of the tile in the rule
+   * Create all textures again and draw every spot on the next render, for after the renderer lost
+   * its device and with it every texture
    *
    * Throws:
-   *       If tile with name p_for or p_to does not exist in tiles__
+   *       If creation of a texture fails
    */
-  void add_rule(const std::string& p_for, wfc::Directions p_dir, const std::vector<std::string>& p_to);
+  void recreate_textures();
 
   /*
-   * Add a constraint to the canvas for edges
+   * Move the view, keeping some of the grid in the window
    *
    * Params:
-   *       Constraints p_cons: Constraint type to be added for
-   *       String      p_tile: Name of the tile for the constraint
-   *
-   * Throws:
-   *       If tile with name p_tile does not exist in tiles__
+   *       float p_dx: Distance to move the grid to the right in pixels
+   *       float p_dy: Distance to move the grid down in pixels
    */
-  void add_constraint(wfc::Constraints p_cons, const std::string& p_tile);
+  void pan(float p_dx, float p_dy);
 
   /*
-   * Add a constraint to the canvas for coordinates
+   * Zoom the view around a point of the window. The grid is never smaller than it is when fit to
+   * the window and spots are never larger than half the window
    *
    * Params:
-   *       size_t  p_x   : x coordinate of the constraint
-   *       size_t  p_y   : y coordinate of the constraint
-   *       String  p_tile: Name of the tile for the constraint
-   *
-   * Throws:
-   *       If tile with name p_tile does not exist in tiles__
-   *       If the coordinates are out of bound
+   *       float p_factor: Factor to scale the spots by, above 1 to zoom in
+   *       float p_x     : Horizontal position of the point in the window that stays in place
+   *       float p_y     : Vertical position of the point in the window that stays in place
    */
-  void add_constraint(size_t x, size_t y, const std::string& p_tile);
+  void zoom(float p_factor, float p_x, float p_y);
 
   /*
-   * Reset the canvas
+   * Go back to the initial view, with the grid fit to the window
    */
-  void reset();
+  void reset_view();
 
   /*
-   * Collapse the next tile in the canvas
-   *
-   * Returns:
-   *        true if tile was collapsed successfully, else false
+   * Get the width of the window in pixels
    */
-  bool collapse_next();
+  size_t get_width() const;
 
   /*
-   * Render the current state of buffer__ using SDL window
+   * Get the height of the window in pixels
    */
-  void render();
-
-  /*
-   * Save the current state of buffer__ to given image path
-   *
-   * Params:
-   *       String p_output: Path to output image
-   *
-   * Throws:
-   *       If surface creation fails
-   *       If image saving fails
-   */
-  void save_image(const std::string& p_output);
+  size_t get_height() const;
 
 private:
-  struct Constraints {
-    std::unordered_map<wfc::Constraints, std::unordered_set<wfc::Tile*>> others;
-    std::unordered_map<size_t, std::unordered_set<wfc::Tile*>> fixed;
+  struct View {
+    size_t row_begin;
+    size_t row_end;
+    size_t col_begin;
+    size_t col_end;
+    float spot_width;
+    float spot_height;
   };
 
   const size_t width__;
   const size_t height__;
-  const size_t rows__;
-  const size_t columns__;
-  const size_t tile_width__;
-  const size_t tile_height__;
-  wfc::DirectionType direction_type__;
-  std::unordered_map<std::string, wfc::Tile*> tiles__;
-  Constraints constraints__;
+  const wfc::Solver* solver__;
+  const float base_width__;
+  const float base_height__;
+  const float min_zoom__;
+  const float max_zoom__;
+  float zoom__;
+  float offset_x__;
+  float offset_y__;
   SDL_Window* window__;
   SDL_Renderer* renderer__;
-  std::vector<wfc::Spot> buffer__;
-  SDL_Texture* null_texture__;
-  size_t collapsed_count__;
+  const wfc::Compositor compositor__;
+  SDL_Texture* atlas__;
+  std::vector<SDL_FRect> uvs__;
+  SDL_Texture* colours_texture__;
+  std::vector<uint32_t> colours__;
+  std::vector<uint32_t> colour_pixels__;
+  SDL_Texture* frame__;
+  bool redraw__;
+  std::vector<SDL_Vertex> vertices__;
+  std::vector<int> indices__;
+
+  /*
+   * Create the frame texture, the atlas and the colour texture
+   *
+   * Throws:
+   *       If creation of a texture fails
+   */
+  void create_textures__();
+
+  /*
+   * Pack the images of all tiles of the solver into atlas__, followed by a black tile with white
+   * border representing uncollapsed spots. Tiles are drawn over black, so the atlas is opaque and
+   * redrawn spots never show what was drawn before them. The average colours of the same tiles
+   * are stored in colours__
+   *
+   * Throws:
+   *       If the atlas is larger than the renderer supports
+   *       If creation of the atlas texture fails
+   */
+  void create_atlas__();
 
   /*
-   * Create a black tile texture with white border and store it in null_texture__ to represent
-   * uncollapsed tile
+   * Get the rows and columns of spots in view and the size of a spot in the window
    */
-  void create_null_texture__();
+  View get_view__() const;
 
   /*
-   * Get the index of spot with lowest entropy. Selects a random spot if more than one spot has
-   * the same lowest entropy
+   * Draw spots in view into the current render target as quads of the atlas
    *
-   * Returns:
-   *        Index of the selected spot in buffer__
+   * Params:
+   *       Vector<uint32_t> p_tiles: Id of the tile collapsed into each spot
+   *       Vector<uint32_t> p_dirty: Spots to draw, all spots in view are drawn if redraw__ is set
+   *       View             p_view : Spots in view
+   */
+  void draw_quads__(const std::vector<uint32_t>& p_tiles, const std::vector<uint32_t>& p_dirty,
+                    const View& p_view);
+
+  /*
+   * Draw spots in view into the current render target as the average colours of their tiles,
+   * one pixel per spot, or one spot per pixel if there are more spots in view than pixels
+   *
+   * Params:
+   *       Vector<uint32_t> p_tiles: Id of the tile collapsed into each spot
+   *       Vector<uint32_t> p_dirty: Spots that changed, all spots in view are drawn if redraw__
+   *                                 is set
+   *       View             p_view : Spots in view
+   */
+  void draw_colours__(const std::vector<uint32_t>& p_tiles, const std::vector<uint32_t>& p_dirty,
+                      const View& p_view);
+
+  /*
+   * Keep the zoom within its limits and the grid within the window
    */
-  size_t get_lowest_entropy_spot_idx__();
+  void clamp_view__();
 
   /*
-   * Reduces entropy arround the given spot index using the rules
+   * Add the quad of a spot to vertices__ and indices__
    *
    * Params:
-   *       size_t p_spot_idx: Index of the spot in buffer__ to look around
+   *       size_t   p_spot_idx: Index of the spot, row * columns + column
+   *       uint32_t p_tile    : Id of the tile collapsed into the spot, or wfc::NO_TILE
+   *       View     p_view    : Spots in view
    */
-  void reduce_entropy_arround__(size_t p_spot_idx);
+  void add_spot__(size_t p_spot_idx, uint32_t p_tile, const View& p_view);
 
   /*
-   * Apply constraints defined in constraints__ to the buffer
+   * Destroy all textures held by the canvas
    */
-  void apply_constraints__();
+  void free_textures__();
 };
 
 }
@@ -0,0 +1,107 @@
+#ifndef WFC_COMPOSITOR_H_
+#define WFC_COMPOSITOR_H_
+
+#include "wfc_mip_chain.h"
+#include "wfc_solver.h"
+#include "wfc_tile.h"
+
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+namespace wfc {
+
+/*
+ * Builds output images on the CPU from the decoded pixels of the tiles
+ *
+ * Every tile image is loaded once as RGBA32 pixels with its mip chain. Images are composed by
+ * copying the rows of each collapsed tile into the output, so their size is rows x tile height by
+ * columns x tile width no matter the window size, and no renderer is needed. Images can also be
+ * composed from a smaller level of the mip chains, down to one pixel per spot taken from a flat
+ * array of average colours. Composing only reads the compositor, so several threads can compose
+ * with the same one.
+ */
+class Compositor {
+public:
+  /*
+   * Load the images of the given tiles, tiles constructed with pixels use those instead
+   *
+   * Params:
+   *       Vector<Tile*> p_tiles: Tiles indexed by their id
+   *
+   * Throws:
+   *       If IMG_Load fails to load the image of a tile
+   *       If the tile images do not all have the same size
+   */
+  Compositor(const std::vector<wfc::Tile*>& p_tiles);
+
+  /*
+   * Get the width of a tile in pixels at a level of the mip chain
+   */
+  size_t get_tile_width(size_t p_level = 0) const;
+
+  /*
+   * Get the height of a tile in pixels at a level of the mip chain
+   */
+  size_t get_tile_height(size_t p_level = 0) const;
+
+  /*
+   * Get the number of levels of the mip chain of the tiles, the last one is a single pixel
+   */
+  size_t get_level_count() const;
+
+  /*
+   * Get the mip chain of a tile
+   *
+   * Params:
+   *       size_t p_tile: Id of the tile
+   */
+  const wfc::MipChain& get_mip_chain(size_t p_tile) const;
+
+  /*
+   * Get the average colour of every tile as RGBA32, indexed by tile id
+   */
+  const std::vector<uint32_t>& get_colours() const;
+
+  /*
+   * Copy a band of rows of the solver into a pixel buffer. Spots that are not collapsed are left
+   * transparent
+   *
+   * Params:
+   *       Solver  p_solver   : Solver to compose
+   *       size_t  p_first_row: First row of spots in the band
+   *       size_t  p_row_count: Number of rows of spots in the band
+   *       uint8_t p_pixels   : RGBA32 buffer of p_row_count * get_tile_height(p_level) lines
+   *       size_t  p_pitch    : Number of bytes between two lines of p_pixels
+   *       size_t  p_level    : Level of the mip chain to compose from, below get_level_count()
+   */
+  void compose_rows(const wfc::Solver& p_solver, size_t p_first_row, size_t p_row_count,
+                    uint8_t* p_pixels, size_t p_pitch, size_t p_level = 0) const;
+
+  /*
+   * Save the whole solver as a png or ppm image. The image is composed and written one row of
+   * spots at a time, so only a few rows of pixels are held in memory
+   *
+   * Params:
+   *       Solver p_solver : Solver to compose
+   *       String p_output : Path to output image
+   *       size_t p_threads: Number of rows compressed at the same time
+   *       size_t p_level  : Level of the mip chain to compose from, the last level is used for
+   *                         any larger value
+   *
+   * Throws:
+   *       If the output format is not supported
+   *       If image saving fails
+   */
+  void save_image(const wfc::Solver& p_solver, const std::string& p_output, size_t p_threads = 1,
+                  size_t p_level = 0) const;
+
+private:
+  std::vector<wfc::MipChain> mip_chains__;
+  std::vector<uint32_t> colours__;
+};
+
+}
+
+#endif // !WFC_COMPOSITOR_H_
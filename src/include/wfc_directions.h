@@ -1,6 +1,7 @@
 #ifndef WFC_DIRECTIONS_H_
 #define WFC_DIRECTIONS_H_
 
+#include <cstddef>
 #include <ostream>
 
 namespace wfc {
@@ -34,6 +35,19 @@ enum class Constraints {
   CORNERS
 };
 
+const size_t DIRECTION_COUNT = 8;  /// Number of values in wfc::Directions
+
+/*
+ * Get the direction pointing the opposite way of the given direction
+ *
+ * Params:
+ *       Directions p_dir: Direction to invert
+ *
+ * Returns:
+ *        Opposite direction
+ */
+wfc::Directions opposite(wfc::Directions p_dir);
+
 }
 
 std::ostream& operator<<(std::ostream& out, const wfc::Directions& dir);
@@ -0,0 +1,171 @@
+#ifndef WFC_DOMAIN_H_
+#define WFC_DOMAIN_H_
+
+#include <cstdint>
+#include <cstdlib>
+#include <vector>
+
+namespace wfc {
+
+/*
+ * Packed bitsets holding the possible tiles of every spot in the canvas
+ *
+ * Each spot owns words_per_cell() 64-bit words in one contiguous array, bit i of a spot being set
+ * when the tile with id i is still possible for that spot.
+ */
+class Domains {
+public:
+  /*
+   * Construct empty domains
+   */
+  Domains();
+
+  /*
+   * Resize the domains to hold the given number of spots and tiles. All bits are cleared
+   *
+   * Params:
+   *       size_t p_cells: Number of spots
+   *       size_t p_bits : Number of tiles
+   */
+  void resize(size_t p_cells, size_t p_bits);
+
+  /*
+   * Get the number of 64-bit words needed to hold the given number of bits
+   */
+  static size_t words_for(size_t p_bits) {
+    return (p_bits + 63) / 64;
+  }
+
+  /*
+   * Get the number of 64-bit words used by each spot
+   */
+  size_t words_per_cell() const {
+    return words__;
+  }
+
+  /*
+   * Get the number of tiles each spot can hold
+   */
+  size_t bits() const {
+    return bits__;
+  }
+
+  /*
+   * Get the number of spots
+   */
+  size_t cells() const {
+    return cells__;
+  }
+
+  /*
+   * Get pointer to the words of the given spot
+   */
+  uint64_t* cell(size_t p_idx) {
+    return &data__[p_idx * words__];
+  }
+
+  const uint64_t* cell(size_t p_idx) const {
+    return &data__[p_idx * words__];
+  }
+
+  /*
+   * Check if the given tile is possible for the given spot
+   */
+  bool test(size_t p_idx, size_t p_bit) const {
+    return (cell(p_idx)[p_bit >> 6] >> (p_bit & 63)) & 1;
+  }
+
+  /*
+   * Mark the given tile as possible for the given spot
+   */
+  void set(size_t p_idx, size_t p_bit) {
+    cell(p_idx)[p_bit >> 6] |= uint64_t(1) << (p_bit & 63);
+  }
+
+  /*
+   * Mark the given tile as not possible for the given spot
+   */
+  void reset(size_t p_idx, size_t p_bit) {
+    cell(p_idx)[p_bit >> 6] &= ~(uint64_t(1) << (p_bit & 63));
+  }
+
+  /*
+   * Remove all possible tiles from the given spot
+   */
+  void clear(size_t p_idx);
+
+  /*
+   * Overwrite the possible tiles of the given spot with the given mask
+   *
+   * Params:
+   *       size_t   p_idx : Index of the spot
+   *       uint64_t p_mask: Mask of words_per_cell() words
+   */
+  void assign(size_t p_idx, const uint64_t* p_mask);
+
+  /*
+   * Overwrite the possible tiles of every spot with the given mask
+   *
+   * Params:
+   *       uint64_t p_mask: Mask of words_per_cell() words
+   */
+  void fill(const uint64_t* p_mask);
+
+  /*
+   * Intersect the possible tiles of the given spot with the given mask
+   *
+   * Params:
+   *       size_t   p_idx : Index of the spot
+   *       uint64_t p_mask: Mask of words_per_cell() words
+   *
+   * Returns:
+   *        true if any tile was removed from the spot, else false
+   */
+  bool intersect(size_t p_idx, const uint64_t* p_mask);
+
+  /*
+   * Get the number of possible tiles of the given spot
+   */
+  size_t count(size_t p_idx) const;
+
+  /*
+   * Get the id of the n-th possible tile of the given spot
+   *
+   * Params:
+   *       size_t p_idx: Index of the spot
+   *       size_t p_n  : Zero based position of the tile among the possible tiles
+   *
+   * Returns:
+   *        Id of the tile, or bits() if the spot has less than p_n + 1 possible tiles
+   */
+  size_t nth(size_t p_idx, size_t p_n) const;
+
+private:
+  size_t cells__;
+  size_t bits__;
+  size_t words__;
+  std::vector<uint64_t> data__;
+};
+
+/*
+ * Call the given function with the index of every set bit of the given words
+ *
+ * Params:
+ *       uint64_t p_words: Words to look through
+ *       size_t   p_count: Number of words
+ *       F        p_fn   : Function taking the index of the bit
+ */
+template<typename F>
+void for_each_bit(const uint64_t* p_words, size_t p_count, F p_fn) {
+  for (size_t w = 0; w < p_count; ++w) {
+    uint64_t word = p_words[w];
+    while (word) {
+      p_fn(w * 64 + __builtin_ctzll(word));
+      word &= word - 1;
+    }
+  }
+}
+
+}
+
+#endif // !WFC_DOMAIN_H_
@@ -0,0 +1,90 @@
+#ifndef WFC_EDGE_RULES_H_
+#define WFC_EDGE_RULES_H_
+
+#include "wfc_directions.h"
+#include "wfc_utils.h"
+
+#include <cstdint>
+#include <cstdlib>
+#include <vector>
+
+namespace wfc {
+
+/*
+ * Rules between tiles inferred from the pixels along the edges of their images
+ *
+ * A tile can be placed to the east of another when the first column of its image matches the
+ * last column of the other, and likewise for the other sides. Two edges match when every pair of
+ * facing pixels differs by at most the tolerance in each colour channel. Identical edges are
+ * grouped first so each distinct edge is compared once. Exact matches are then found on a hash of
+ * the edges, matches within a tolerance by a sweep over the edges sorted by the sum of their red
+ * channel, so only edges that are likely to match are compared pixel by pixel. Diagonal
+ * directions have no edge and get no rules.
+ */
+class EdgeRules {
+public:
+  /*
+   * Construct rules without tiles
+   *
+   * Params:
+   *       size_t p_tolerance: Largest difference of a colour channel between facing pixels, 0 for
+   *                           exact matches only
+   */
+  EdgeRules(size_t p_tolerance);
+
+  /*
+   * Add the edges of the next tile, tiles are numbered in the order they are added
+   *
+   * Params:
+   *       uint8_t p_pixels: RGBA32 pixels of the tile image
+   *       size_t  p_width : Width of the image in pixels
+   *       size_t  p_height: Height of the image in pixels
+   *       size_t  p_pitch : Number of bytes between two lines of p_pixels
+   */
+  void add_tile(const uint8_t* p_pixels, size_t p_width, size_t p_height, size_t p_pitch);
+
+  /*
+   * Find the compatible tiles of every tile and direction
+   *
+   * Params:
+   *       size_t p_threads: Number of threads to use, 0 for one
+   */
+  void compile(size_t p_threads);
+
+  /*
+   * Get the tiles that can be placed in the given direction of a tile, after compile()
+   *
+   * Params:
+   *       size_t     p_tile: Id of the tile
+   *       Directions p_dir : Direction to look in
+   *
+   * Returns:
+   *        Pointer to get_compatible_count(p_tile, p_dir) ids in increasing order
+   */
+  const uint32_t* get_compatible(size_t p_tile, wfc::Directions p_dir) const;
+
+  /*
+   * Get the number of tiles that can be placed in the given direction of a tile, after compile()
+   */
+  size_t get_compatible_count(size_t p_tile, wfc::Directions p_dir) const;
+
+private:
+  struct Edge {
+    std::vector<uint32_t> pixels;  /// RGBA32 colours from left to right or top to bottom
+    uint64_t hash;
+    uint64_t sums[4];              /// Sum of each colour channel over the edge
+  };
+
+  const size_t tolerance__;
+  std::vector<Edge> edges__;  /// North, east, south and west edge of every tile
+  wfc::CompatibilityLists compatible__;
+
+  /*
+   * Check if every pair of facing pixels of two edges is within the tolerance
+   */
+  bool matches__(const Edge& p_a, const Edge& p_b) const;
+};
+
+}
+
+#endif // !WFC_EDGE_RULES_H_
@@ -0,0 +1,125 @@
+#ifndef WFC_HEAP_H_
+#define WFC_HEAP_H_
+
+#include <cstdint>
+#include <cstdlib>
+#include <vector>
+
+namespace wfc {
+
+/*
+ * Indexed binary min-heap of spots keyed by their entropy
+ *
+ * Every spot index has a fixed slot so its entropy can be changed in O(log n) when its possible
+ * tiles shrink. Spots with equal entropy are ordered by a noise value given when they are pushed,
+ * which makes the choice between them random without scanning the canvas.
+ */
+class EntropyHeap {
+public:
+  /*
+   * Construct an empty heap
+   */
+  EntropyHeap();
+
+  /*
+   * Remove all spots and make room for spot indices in [0, p_capacity)
+   *
+   * Params:
+   *       size_t p_capacity: Number of spots
+   */
+  void clear(size_t p_capacity);
+
+  /*
+   * Check if the heap is empty
+   */
+  bool empty() const {
+    return heap__.empty();
+  }
+
+  /*
+   * Get the number of spots in the heap
+   */
+  size_t size() const {
+    return heap__.size();
+  }
+
+  /*
+   * Check if the given spot is in the heap
+   */
+  bool contains(size_t p_idx) const {
+    return position__[p_idx] != NPOS;
+  }
+
+  /*
+   * Get the spot with the lowest entropy
+   */
+  size_t top() const {
+    return heap__[0];
+  }
+
+  /*
+   * Add a spot to the heap
+   *
+   * Params:
+   *       size_t   p_idx    : Index of the spot
+   *       double   p_entropy: Entropy of the spot
+   *       uint32_t p_noise  : Value used to order spots with equal entropy
+   */
+  void push(size_t p_idx, double p_entropy, uint32_t p_noise);
+
+  /*
+   * Change the entropy of a spot in the heap
+   *
+   * Params:
+   *       size_t p_idx    : Index of the spot
+   *       double p_entropy: New entropy of the spot
+   */
+  void update(size_t p_idx, double p_entropy);
+
+  /*
+   * Remove a spot from the heap, does nothing if the spot is not in the heap
+   *
+   * Params:
+   *       size_t p_idx: Index of the spot
+   */
+  void remove(size_t p_idx);
+
+  /*
+   * Remove the spot with the lowest entropy
+   */
+  void pop() {
+    remove(heap__[0]);
+  }
+
+private:
+  static constexpr uint32_t NPOS = UINT32_MAX;
+
+  std::vector<uint32_t> heap__;
+  std::vector<uint32_t> position__;
+  std::vector<double> entropy__;
+  std::vector<uint32_t> noise__;
+
+  /*
+   * Check if spot p_a must be above spot p_b in the heap
+   */
+  bool before__(uint32_t p_a, uint32_t p_b) const {
+    if (entropy__[p_a] != entropy__[p_b]) {
+      return entropy__[p_a] < entropy__[p_b];
+    }
+    return noise__[p_a] < noise__[p_b];
+  }
+
+  /*
+   * Move the spot at the given heap position up until the heap is ordered
+   */
+  void sift_up__(size_t p_pos);
+
+  /*
+   * Move the spot at the given heap position down until the heap is ordered
+   */
+  void sift_down__(size_t p_pos);
+};
+
+}
+
+#endif // !WFC_HEAP_H_
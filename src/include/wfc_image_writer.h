@@ -0,0 +1,174 @@
+#ifndef WFC_IMAGE_WRITER_H_
+#define WFC_IMAGE_WRITER_H_
+
+#include <cstdint>
+#include <cstdlib>
+#include <deque>
+#include <fstream>
+#include <future>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace wfc {
+
+/*
+ * Writes an RGBA32 image to a file one band of lines at a time, from top to bottom
+ *
+ * Only the band being written is needed in memory, so images far larger than RAM can be saved.
+ */
+class ImageWriter {
+public:
+  virtual ~ImageWriter() = default;
+
+  /*
+   * Open a writer for the format given by the extension of the path, .png or .ppm
+   *
+   * Params:
+   *       String p_path   : Path to output image
+   *       size_t p_width  : Width of the image in pixels
+   *       size_t p_height : Height of the image in pixels
+   *       size_t p_threads: Number of threads compressing bands at the same time
+   *
+   * Returns:
+   *        Writer for the image
+   *
+   * Throws:
+   *       If the extension is not supported
+   *       If the file can not be opened
+   */
+  static std::unique_ptr<ImageWriter> open(const std::string& p_path, size_t p_width, size_t p_height,
+                                           size_t p_threads = 1);
+
+  /*
+   * Write the next lines of the image
+   *
+   * Params:
+   *       uint8_t p_pixels: RGBA32 pixels of the lines
+   *       size_t  p_pitch : Number of bytes between two lines of p_pixels
+   *       size_t  p_lines : Number of lines
+   *
+   * Throws:
+   *       If more lines are written than the image has
+   *       If writing to the file fails
+   */
+  virtual void write_band(const uint8_t* p_pixels, size_t p_pitch, size_t p_lines) = 0;
+
+  /*
+   * Write everything that is left and close the file
+   *
+   * Throws:
+   *       If fewer lines were written than the image has
+   *       If writing to the file fails
+   */
+  virtual void finish() = 0;
+};
+
+/*
+ * PNG writer that compresses bands in parallel
+ *
+ * Every band is deflated on its own thread with the end of the previous band as dictionary and
+ * flushed to a byte boundary, so the compressed bands can simply be concatenated into the single
+ * zlib stream of the IDAT chunks. The checksums of the bands are combined in order.
+ */
+class PngWriter : public ImageWriter {
+public:
+  /*
+   * Open the file and write the png header
+   *
+   * Params:
+   *       String p_path   : Path to output image
+   *       size_t p_width  : Width of the image in pixels
+   *       size_t p_height : Height of the image in pixels
+   *       size_t p_threads: Number of bands compressed at the same time
+   *
+   * Throws:
+   *       If the file can not be opened
+   */
+  PngWriter(const std::string& p_path, size_t p_width, size_t p_height, size_t p_threads);
+
+  void write_band(const uint8_t* p_pixels, size_t p_pitch, size_t p_lines) override;
+
+  void finish() override;
+
+private:
+  struct Band {
+    std::vector<uint8_t> data;
+    uint32_t adler;
+    size_t size;
+  };
+
+  std::ofstream file__;
+  const std::string path__;
+  const size_t width__;
+  const size_t height__;
+  const size_t threads__;
+  size_t lines__;
+  uint32_t adler__;
+  std::shared_ptr<const std::vector<uint8_t>> previous__;
+  std::deque<std::future<Band>> pending__;
+
+  /*
+   * Deflate a band of filtered lines
+   *
+   * Params:
+   *       vector<uint8_t> p_filtered  : Filtered lines of the band
+   *       vector<uint8_t> p_dictionary: Filtered lines of the previous band, or nullptr
+   *       bool            p_last      : Whether this is the last band of the image
+   *
+   * Returns:
+   *        Compressed band with the adler32 of its filtered lines
+   */
+  static Band compress__(std::shared_ptr<const std::vector<uint8_t>> p_filtered,
+                         std::shared_ptr<const std::vector<uint8_t>> p_dictionary, bool p_last);
+
+  /*
+   * Wait for the oldest pending band and write it to the file
+   */
+  void write_pending__();
+
+  /*
+   * Write a png chunk
+   *
+   * Params:
+   *       char    p_type: Four letter type of the chunk
+   *       uint8_t p_data: Data of the chunk
+   *       size_t  p_size: Number of bytes of data
+   */
+  void write_chunk__(const char* p_type, const uint8_t* p_data, size_t p_size);
+};
+
+/*
+ * Binary PPM writer, the alpha channel is dropped
+ */
+class PpmWriter : public ImageWriter {
+public:
+  /*
+   * Open the file and write the ppm header
+   *
+   * Params:
+   *       String p_path  : Path to output image
+   *       size_t p_width : Width of the image in pixels
+   *       size_t p_height: Height of the image in pixels
+   *
+   * Throws:
+   *       If the file can not be opened
+   */
+  PpmWriter(const std::string& p_path, size_t p_width, size_t p_height);
+
+  void write_band(const uint8_t* p_pixels, size_t p_pitch, size_t p_lines) override;
+
+  void finish() override;
+
+private:
+  std::ofstream file__;
+  const std::string path__;
+  const size_t width__;
+  const size_t height__;
+  size_t lines__;
+  std::vector<uint8_t> line__;
+};
+
+}
+
+#endif // !WFC_IMAGE_WRITER_H_
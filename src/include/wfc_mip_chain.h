@@ -0,0 +1,66 @@
+#ifndef WFC_MIP_CHAIN_H_
+#define WFC_MIP_CHAIN_H_
+
+#include <cstdint>
+#include <cstdlib>
+#include <vector>
+
+namespace wfc {
+
+/*
+ * Copies of an RGBA32 image, each half the size of the one before, down to a single pixel
+ *
+ * Every pixel of a level is the average of the block of up to 2x2 pixels it covers in the level
+ * above, so the last level holds the average colour of the image.
+ */
+class MipChain {
+public:
+  /*
+   * Build the chain of an image
+   *
+   * Params:
+   *       uint8_t p_pixels: RGBA32 pixels of the image
+   *       size_t  p_width : Width of the image in pixels, at least 1
+   *       size_t  p_height: Height of the image in pixels, at least 1
+   *       size_t  p_pitch : Number of bytes between two lines of p_pixels
+   */
+  MipChain(const uint8_t* p_pixels, size_t p_width, size_t p_height, size_t p_pitch);
+
+  /*
+   * Get the number of levels, level 0 is the image itself
+   */
+  size_t get_level_count() const;
+
+  /*
+   * Get the width of a level in pixels
+   */
+  size_t get_width(size_t p_level) const;
+
+  /*
+   * Get the height of a level in pixels
+   */
+  size_t get_height(size_t p_level) const;
+
+  /*
+   * Get the RGBA32 pixels of a level, get_width(p_level) * 4 bytes per line
+   */
+  const uint8_t* get_pixels(size_t p_level) const;
+
+  /*
+   * Get the average colour of the image as RGBA32, the single pixel of the last level
+   */
+  const uint8_t* get_average() const;
+
+private:
+  struct Level {
+    size_t width;
+    size_t height;
+    std::vector<uint8_t> pixels;
+  };
+
+  std::vector<Level> levels__;
+};
+
+}
+
+#endif // !WFC_MIP_CHAIN_H_
@@ -0,0 +1,100 @@
+#ifndef WFC_OVERLAPPING_H_
+#define WFC_OVERLAPPING_H_
+
+#include "wfc_directions.h"
+#include "wfc_utils.h"
+
+#include <cstdint>
+#include <cstdlib>
+#include <vector>
+
+namespace wfc {
+
+/*
+ * Patterns of an overlapping model learned from a sample image
+ *
+ * Every N x N window of the sample, optionally of its rotations and reflections too, is a
+ * pattern. Windows are found by a rolling hash over the sample and counted, so the weight of a
+ * pattern is the number of times it appears. Two patterns are compatible in a direction when
+ * they agree on every pixel they share once one is moved by one pixel in that direction, which
+ * is found by grouping the patterns on a hash of the pixels each side shares. Both steps run on
+ * several threads and give the same result for any number of threads.
+ *
+ * Patterns are numbered in the order they first appear in the sample, row by row.
+ */
+class OverlappingModel {
+public:
+  static constexpr size_t MAX_PATTERNS = UINT16_MAX;  /// Most tiles a solver supports
+
+  /*
+   * Learn the patterns of a sample image
+   *
+   * Params:
+   *       uint8_t       p_pixels  : RGBA32 pixels of the sample
+   *       size_t        p_width   : Width of the sample in pixels
+   *       size_t        p_height  : Height of the sample in pixels
+   *       size_t        p_pitch   : Number of bytes between two lines of p_pixels
+   *       size_t        p_size    : Width and height N of the patterns, at least 2
+   *       size_t        p_symmetry: Number of variants of the sample to learn from, 1 for the
+   *                                 sample only, 2 to add its reflection, up to 8 for all of its
+   *                                 rotations and reflections
+   *       bool          p_periodic: Whether windows wrap around the edges of the sample
+   *       DirectionType p_type    : Directions to find compatible patterns in, the diagonals of
+   *                                 quad directions have none
+   *       size_t        p_threads : Number of threads to use, 0 for one
+   *
+   * Throws:
+   *       If p_size is less than 2 or larger than the sample
+   *       If p_symmetry is not between 1 and 8
+   *       If the sample has more than MAX_PATTERNS distinct patterns
+   */
+  OverlappingModel(const uint8_t* p_pixels, size_t p_width, size_t p_height, size_t p_pitch, size_t p_size,
+                   size_t p_symmetry, bool p_periodic, wfc::DirectionType p_type, size_t p_threads);
+
+  /*
+   * Get the width and height N of the patterns
+   */
+  size_t get_size() const;
+
+  /*
+   * Get the number of distinct patterns
+   */
+  size_t get_pattern_count() const;
+
+  /*
+   * Get the N x N RGBA32 colours of a pattern, row by row
+   */
+  const uint32_t* get_pattern(size_t p_pattern) const;
+
+  /*
+   * Get the number of times a pattern appears in the sample and its variants
+   */
+  double get_weight(size_t p_pattern) const;
+
+  /*
+   * Get the patterns that can be placed in the given direction of a pattern
+   *
+   * Params:
+   *       size_t     p_pattern: Id of the pattern
+   *       Directions p_dir    : Direction to look in
+   *
+   * Returns:
+   *        Pointer to get_compatible_count(p_pattern, p_dir) ids in increasing order
+   */
+  const uint32_t* get_compatible(size_t p_pattern, wfc::Directions p_dir) const;
+
+  /*
+   * Get the number of patterns that can be placed in the given direction of a pattern
+   */
+  size_t get_compatible_count(size_t p_pattern, wfc::Directions p_dir) const;
+
+private:
+  size_t size__;
+  std::vector<uint32_t> patterns__;
+  std::vector<double> weights__;
+  wfc::CompatibilityLists compatible__;
+};
+
+}
+
+#endif // !WFC_OVERLAPPING_H_
@@ -2,10 +2,14 @@
 #define WFC_PARSER_H_
 
 #include "wfc_directions.h"
+#include "wfc_symmetry.h"
 #include "wfc_tile.h"
+#include "wfc_tile_registry.h"
 
 #include <filesystem>
 #include <string>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 #include "external/json.hpp"
@@ -19,20 +23,44 @@ struct CanvasInfo {
   size_t rows;
   size_t columns;
   wfc::DirectionType direction_type;
+  size_t edge_tolerance;
 };
 
 struct TileInfo {
+  uint32_t id;  /// Dense id of the tile, its index in the parsed tiles
   std::string name;
   std::string path;
+  double weight;
+  bool auto_rules;
+  wfc::Symmetry symmetry;
+  size_t transform;  /// Quarters to turn the image clockwise plus 4 to mirror it after
   std::unordered_set<wfc::Directions> directions_to_invert;
-  std::unordered_map<wfc::Directions, std::unordered_set<std::string>> rules;
+  std::unordered_map<wfc::Directions, std::vector<uint32_t>> rules;  /// Sorted ids of the tiles allowed on each side
+  std::unordered_map<wfc::Directions, std::string> sockets;  /// Socket label of each side that has one
   TileInfo(const std::string& p_name, const std::string& p_path) :
+    id(wfc::NO_TILE),
     name(p_name),
-    path(p_path) {
+    path(p_path),
+    weight(1.0),
+    auto_rules(false),
+    symmetry(wfc::Symmetry::X),
+    transform(0) {
   }
 
-  void add_rule(wfc::Directions p_dir, const std::string& p_tile_name) {
-    rules[p_dir].insert(p_tile_name);
+  void add_rule(wfc::Directions p_dir, uint32_t p_tile) {
+    rules[p_dir].push_back(p_tile);
+  }
+};
+
+struct SampleInfo {
+  std::string path;
+  size_t size;
+  size_t symmetry;
+  bool periodic;
+  SampleInfo() :
+    size(3),
+    symmetry(8),
+    periodic(true) {
   }
 };
 
@@ -83,13 +111,39 @@ public:
   void parse_canvas(wfc::CanvasInfo& p_canvas_info) const;
 
   /*
-   * Parse "tile" section of the config file and store vlaues in the given reference to vector
+   * Parse "tile" section of the config file and store vlaues in the given reference to vector.
+   * Tiles with a symmetry are followed by their turned and mirrored variants, named NAME#k for
+   * variant k, with their rules turned and mirrored the same way. The names are interned once and
+   * every tile gets its index in p_tiles as id, which its rules use to name other tiles
+   *
+   * Params:
+   *       Vector<TileInfo> p_tiles   : Store the tiles
+   *       GroupInfo        p_groups  : Parsed groups
+   *       TileRegistry     p_registry: Store the names of the tiles, the name of id i is the name of tile i
+   *
+   * Throws:
+   *       If a tile is defined more than once
+   *       If a rule names an unknown tile
+   */
+  void parse_tiles(std::vector<TileInfo>& p_tiles, const wfc::GroupInfo& p_groups,
+                   wfc::TileRegistry& p_registry) const;
+
+  /*
+   * Check if the config has a "sample" section to learn an overlapping model from instead of tiles
+   */
+  bool has_sample() const;
+
+  /*
+   * Parse "sample" section of the config file and store values in the given reference
    *
    * Params:
-   *       Vector<TileInfo> p_tiles : Store the tiles
-   *       GroupInfo        p_groups: Parsed groups
+   *       SampleInfo p_sample_info: Reference to SampleInfo struct to store parsed data
+   *
+   * Throws:
+   *       If the section or its path is missing
+   *       If the symmetry is not between 1 and 8
    */
-  void parse_tiles(std::vector<TileInfo>& p_tiles, const wfc::GroupInfo& p_groups) const;
+  void parse_sample(wfc::SampleInfo& p_sample_info) const;
 
   /*
    * Parse "groups" section of the ocnfig file and store values in the given reference to GroupInfo
@@ -128,6 +182,23 @@ private:
    */
   size_t parse_positive_int__(const json& section, const std::string& p_key, const std::string& p_path) const;
 
+  /*
+   * Get a positive number from the given section in the config
+   *
+   * Params:
+   *       json   section: Json section to search in
+   *       String p_key  : Key to search in the section
+   *       String p_path : Path of the key
+   *
+   * Returns:
+   *        positive number parsed
+   *
+   * Throws:
+   *       If value is not found
+   *       If value is not a positive number
+   */
+  double parse_positive_number__(const json& section, const std::string& p_key, const std::string& p_path) const;
+
   /*
    * Get a string from the given section in the config
    * Params:
@@ -163,11 +234,38 @@ private:
    * Parse the rules section of tiles and fill the rules property of the given tile
    *
    * Params:
-   *       TileInfo  p_tile      : Reference to the tile for which to fill the rules for
-   *       json      p_section   : Json section that contains the rules
-   *       GroupInfo p_group_info: Parsed groups
+   *       TileInfo     p_tile      : Reference to the tile for which to fill the rules for
+   *       json         p_section   : Json section that contains the rules
+   *       GroupInfo    p_group_info: Parsed groups
+   *       TileRegistry p_registry  : Ids of all tiles, including variants
+   *
+   * Throws:
+   *       If a rule names an unknown tile
+   */
+  void parse_tile_rules__(TileInfo& p_tile, const json& p_section, const wfc::GroupInfo& p_group_info,
+                          const wfc::TileRegistry& p_registry) const;
+
+  /*
+   * Parse the sockets section of a tile and fill the sockets property of the given tile
+   *
+   * Params:
+   *       TileInfo p_tile   : Reference to the tile for which to fill the sockets for
+   *       json     p_section: Json section that contains the sockets
+   *
+   * Throws:
+   *       If the section is not an object of direction names to strings
+   */
+  void parse_tile_sockets__(TileInfo& p_tile, const json& p_section) const;
+
+  /*
+   * Replace every tile with a symmetry by its variants, turning and mirroring the directions of its
+   * rules and the tiles they name along with it, as well as its sockets. The variants of a tile
+   * take the ids right after its own
+   *
+   * Params:
+   *       vector<TileInfo> p_tiles: Reference to the vector that contains all the tiles
    */
-  void parse_tile_rules__(TileInfo& p_tile, const json& p_section, const wfc::GroupInfo& p_group_info) const;
+  void add_tile_variants__(std::vector<TileInfo>& p_tiles) const;
 
   /*
    * Resolve the rules that need to be inverted
@@ -0,0 +1,83 @@
+#ifndef WFC_PORTFOLIO_H_
+#define WFC_PORTFOLIO_H_
+
+#include "wfc_solver.h"
+
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <vector>
+
+namespace wfc {
+
+/*
+ * Races copies of a solver with different random streams on several threads
+ *
+ * Attempts are numbered from 0 and attempt a solves from a reset using the random stream of the
+ * seed jumped a times. The winner is the successful attempt with the lowest number, so the result
+ * only depends on the seed and never on the number of threads or on timing. Attempts with a higher
+ * number than a finished one are stopped early.
+ */
+class Portfolio {
+public:
+  /*
+   * Construct the portfolio
+   *
+   * Params:
+   *       Solver p_solver : Solver with all tiles, rules, constraints and settings, it is copied
+   *                         once per thread
+   *       size_t p_threads: Number of threads to race on, at least 1
+   */
+  Portfolio(const wfc::Solver& p_solver, size_t p_threads);
+
+  /*
+   * Solve attempts until one succeeds
+   *
+   * Params:
+   *       uint64_t p_seed        : Seed of the random streams
+   *       size_t   p_max_attempts: Number of attempts to try, 0 for no limit
+   *
+   * Returns:
+   *        true if an attempt collapsed every spot, else false
+   */
+  bool solve(uint64_t p_seed, size_t p_max_attempts);
+
+  /*
+   * Get the solver of the winning attempt, only valid after solve() returned true
+   */
+  const wfc::Solver& get_result() const;
+
+  /*
+   * Get the number of the winning attempt, only valid after solve() returned true
+   */
+  size_t get_attempt() const;
+
+private:
+  static constexpr size_t NPOS = SIZE_MAX;
+
+  std::vector<wfc::Solver> solvers__;
+  std::vector<size_t> solved__;
+  std::atomic<size_t> next_attempt__;
+  std::atomic<size_t> best_attempt__;
+  size_t winner__;
+
+  /*
+   * Take attempts off next_attempt__ and solve them with the solver of the given thread until no
+   * attempt can beat best_attempt__
+   *
+   * Params:
+   *       size_t   p_thread      : Index of the thread in solvers__
+   *       uint64_t p_seed        : Seed of the random streams
+   *       size_t   p_max_attempts: Number of attempts to try, 0 for no limit
+   */
+  void run__(size_t p_thread, uint64_t p_seed, size_t p_max_attempts);
+
+  /*
+   * Lower best_attempt__ to the given attempt if it is lower
+   */
+  void finish__(size_t p_attempt);
+};
+
+}
+
+#endif // !WFC_PORTFOLIO_H_
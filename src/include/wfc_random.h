@@ -1,20 +1,90 @@
 #ifndef WFC_RANDOM_H_
 #define WFC_RANDOM_H_
 
-#include <random>
+#include <cstdint>
 #include <stdexcept>
 
 namespace wfc {
 
+/*
+ * xoshiro256** random number generator
+ *
+ * Every solver owns its own generator so solvers can run on different threads. Range reduction is
+ * done here instead of with std distributions, so a seed gives the same numbers with every
+ * compiler and standard library.
+ */
 class Random {
 public:
+  /*
+   * Construct the generator with a seed taken from std::random_device
+   */
+  Random();
+
+  /*
+   * Construct the generator with the given seed
+   *
+   * Params:
+   *       uint64_t p_seed: Seed value to set
+   */
+  explicit Random(uint64_t p_seed);
+
   /*
    * Set the seed for the random number generator
    *
    * Params:
-   *       unsigned int p_seed: Seed value to set
+   *       uint64_t p_seed: Seed value to set
+   */
+  void seed(uint64_t p_seed);
+
+  /*
+   * Generate the next random 64-bit integer
    */
-  static void seed(unsigned int p_seed);
+  uint64_t next() {
+    const uint64_t result = rotl__(state__[1] * 5, 7) * 9;
+    const uint64_t t = state__[1] << 17;
+
+    state__[2] ^= state__[0];
+    state__[3] ^= state__[1];
+    state__[1] ^= state__[2];
+    state__[0] ^= state__[3];
+    state__[2] ^= t;
+    state__[3] = rotl__(state__[3], 45);
+
+    return result;
+  }
+
+  /*
+   * Generate a random 32-bit integer
+   */
+  uint32_t next_u32() {
+    return static_cast<uint32_t>(next() >> 32);
+  }
+
+  /*
+   * Generate a random integer from the range [0, bound) without modulo bias
+   *
+   * Params:
+   *       uint64_t p_bound: Max value of the range, must be greater than 0
+   *
+   * Returns:
+   *        Random integer in the range
+   */
+  uint64_t int_below(uint64_t p_bound) {
+    __uint128_t product = static_cast<__uint128_t>(next()) * p_bound;
+    uint64_t low = static_cast<uint64_t>(product);
+
+    /// Reject the few values that would make the lower results more likely
+
+    if (low < p_bound) {
+      const uint64_t threshold = -p_bound % p_bound;
+      while (low < threshold) {
+        product = static_cast<__uint128_t>(next()) * p_bound;
+        low = static_cast<uint64_t>(product);
+      }
+    }
+
+    return static_cast<uint64_t>(product >> 64);
+  }
 
   /*
    * Generate a random integer from the range [min, max)
@@ -25,17 +95,47 @@ public:
    *
    * Returns:
    *        Random integer in the range
+   *
+   * Throws:
+   *       If p_min is not less than p_max
    */
-  static int int_from_range(int p_min, int p_max);
+  int int_from_range(int p_min, int p_max);
 
-private:
   /*
-   * Get the random number generator engine
+   * Generate a random real number from the range [min, max)
+   *
+   * Params:
+   *       double p_min: Min value of the range
+   *       double p_max: Max value of the range
    *
    * Returns:
-   *        Static reference to the engine
+   *        Random real number in the range
+   *
+   * Throws:
+   *       If p_min is not less than p_max
    */
-  static std::mt19937& get_engine__();
+  double real_from_range(double p_min, double p_max);
+
+  /*
+   * Advance the generator by 2^128 numbers
+   */
+  void jump();
+
+  /*
+   * Split off an independent stream. The returned generator continues from the current state and
+   * this generator jumps ahead, so repeated calls give streams that never overlap
+   *
+   * Returns:
+   *        Generator for the new stream
+   */
+  Random split();
+
+private:
+  uint64_t state__[4];
+
+  static uint64_t rotl__(uint64_t p_x, int p_k) {
+    return (p_x << p_k) | (p_x >> (64 - p_k));
+  }
 };
 
 }
@@ -0,0 +1,130 @@
+#ifndef WFC_RULES_H_
+#define WFC_RULES_H_
+
+#include "wfc_directions.h"
+#include "wfc_tile.h"
+
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
+namespace wfc {
+
+/*
+ * Compiled compatibility table and weights of a set of tiles
+ *
+ * For every tile and direction the table holds a mask with the ids of the tiles that can be placed
+ * next to it in that direction. A pair of tiles is compatible only if the rules of both tiles allow
+ * each other, so the table is symmetric: b is in get(a, dir) exactly when a is in
+ * get(b, opposite(dir)).
+ *
+ * The table is immutable once built and shared between copies. It is either owned by the rules
+ * or a view of memory kept alive by an owner, such as a mapped ruleset file.
+ */
+class Rules {
+public:
+  /*
+   * Construct an empty table
+   */
+  Rules();
+
+  /*
+   * Compile the rules__, sockets and weights of the given tiles into the table
+   *
+   * Params:
+   *       Vector<Tile*>  p_tiles: Tiles indexed by their id
+   *       DirectionType  p_type : Directions to compile, diagonals allow every tile for quad
+   */
+  void compile(const std::vector<wfc::Tile*>& p_tiles, wfc::DirectionType p_type);
+
+  /*
+   * Use a table compiled before instead of compiling the rules of the tiles
+   *
+   * Params:
+   *       Vector<Tile*>          p_tiles: Tiles indexed by their id, for their weights
+   *       uint64_t               p_table: table_size() words laid out like the table of compile()
+   *       shared_ptr<const void> p_owner: Keeps p_table alive for as long as the rules use it
+   */
+  void load(const std::vector<wfc::Tile*>& p_tiles, const uint64_t* p_table, std::shared_ptr<const void> p_owner);
+
+  /*
+   * Get the words of the whole table, tile by tile and direction by direction
+   */
+  const uint64_t* data() const {
+    return table__;
+  }
+
+  /*
+   * Get the number of words in the table
+   */
+  size_t table_size() const {
+    return tile_count__ * wfc::DIRECTION_COUNT * words__;
+  }
+
+  /*
+   * Get the number of tiles in the table
+   */
+  size_t tile_count() const {
+    return tile_count__;
+  }
+
+  /*
+   * Get the number of 64-bit words in each mask
+   */
+  size_t words() const {
+    return words__;
+  }
+
+  /*
+   * Get the mask of tiles that can be placed in the given direction of the given tile
+   *
+   * Params:
+   *       size_t     p_tile: Id of the tile
+   *       Directions p_dir : Direction to look in
+   *
+   * Returns:
+   *        Pointer to words() words of the mask
+   */
+  const uint64_t* get(size_t p_tile, wfc::Directions p_dir) const {
+    return &table__[(p_tile * wfc::DIRECTION_COUNT + static_cast<size_t>(p_dir)) * words__];
+  }
+
+  /*
+   * Get the weight of the given tile
+   */
+  double weight(size_t p_tile) const {
+    return weights__[p_tile];
+  }
+
+  /*
+   * Get weight * log(weight) of the given tile
+   */
+  double weight_log_weight(size_t p_tile) const {
+    return weight_log_weights__[p_tile];
+  }
+
+  /*
+   * Check if tile p_to can be placed in the given direction of tile p_for
+   */
+  bool check(size_t p_for, wfc::Directions p_dir, size_t p_to) const {
+    return (get(p_for, p_dir)[p_to >> 6] >> (p_to & 63)) & 1;
+  }
+
+private:
+  size_t tile_count__;
+  size_t words__;
+  const uint64_t* table__;
+  std::shared_ptr<const void> owner__;  /// Keeps table__ alive
+  std::vector<double> weights__;
+  std::vector<double> weight_log_weights__;
+
+  /*
+   * Store the weights of the tiles and size the masks for their count
+   */
+  void set_tiles__(const std::vector<wfc::Tile*>& p_tiles);
+};
+
+}
+
+#endif // !WFC_RULES_H_
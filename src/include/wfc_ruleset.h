@@ -0,0 +1,63 @@
+#ifndef WFC_RULESET_H_
+#define WFC_RULESET_H_
+
+#include "wfc_parser.h"
+#include "wfc_solver.h"
+
+#include <cstdint>
+#include <filesystem>
+
+namespace wfc {
+
+/*
+ * A ruleset file holds the canvas, tiles, compiled compatibility table and constraints of a
+ * config, so a run can start without parsing the config or compiling its rules.
+ *
+ * The file starts with a header with a magic number, the format version and the canvas, followed
+ * by the table of wfc::Rules word for word, the tile and constraint records and the names, paths
+ * and pixels they point to. Sections are 64 byte aligned. Numbers are stored in the byte order of
+ * the machine that wrote the file, files from a machine with another byte order are rejected.
+ * Loading maps the file read-only and the solver uses the table in place, so it costs the same
+ * however many rules there are.
+ */
+
+const uint32_t RULESET_VERSION = 1;  /// Version of the ruleset file format, bumped on every change
+
+/*
+ * Write the compiled rules of a solver to a ruleset file
+ *
+ * Params:
+ *       Path           p_path       : Path of the file to write
+ *       CanvasInfo     p_canvas_info: Canvas config of the solver
+ *       Solver         p_solver     : Solver with its tiles added and rules compiled
+ *       ConstraintInfo p_constraints: Constraints to store, naming tiles of the solver
+ *
+ * Throws:
+ *       If the rules of the solver are not compiled
+ *       If a constraint names an unknown tile
+ *       If the file can not be written
+ */
+void save_ruleset(const std::filesystem::path& p_path, const wfc::CanvasInfo& p_canvas_info,
+                  const wfc::Solver& p_solver, const wfc::ConstraintInfo& p_constraints);
+
+/*
+ * Create a solver from a ruleset file. The file stays mapped for as long as the solver or any of
+ * its copies use its table
+ *
+ * Params:
+ *       Path       p_path       : Path to the ruleset file
+ *       CanvasInfo p_canvas_info: Filled with the canvas config of the file
+ *
+ * Returns:
+ *        Pointer to the allocated solver object
+ *
+ * Throws:
+ *       If the file can not be mapped
+ *       If the file is not a ruleset file of RULESET_VERSION or is truncated
+ *       If the canvas, a tile record, a constraint or the padding bits of the table are corrupt
+ */
+wfc::Solver* load_ruleset(const std::filesystem::path& p_path, wfc::CanvasInfo& p_canvas_info);
+
+}
+
+#endif // !WFC_RULESET_H_
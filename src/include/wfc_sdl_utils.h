@@ -1,6 +1,12 @@
 #ifndef  WFC_SDL_UTILS_H_
 #define WFC_SDL_UTILS_H_
 
+#include <filesystem>
+#include <string>
+#include <unordered_map>
+
+struct SDL_Surface;
+
 namespace wfc {
 
 /*
@@ -17,6 +23,53 @@ void init_sdl();
  */
 void free_sdl();
 
+/*
+ * Load an image file as RGBA32 pixels, does not need SDL to be initialized
+ *
+ * Params:
+ *       Path p_path: Path to the image file
+ *
+ * Returns:
+ *        Surface with the pixels, to be freed with SDL_FreeSurface
+ *
+ * Throws:
+ *       If IMG_Load fails to load the image
+ *       If the image can not be converted to RGBA32
+ */
+SDL_Surface* load_image(const std::filesystem::path& p_path);
+
+/*
+ * Images loaded with load_image, each file is only decoded once however many tiles use it
+ */
+class ImageCache {
+public:
+  ImageCache() = default;
+  ImageCache(const ImageCache&) = delete;
+  ImageCache& operator=(const ImageCache&) = delete;
+
+  /*
+   * Free the loaded images
+   */
+  ~ImageCache();
+
+  /*
+   * Get the image at a path, loading it the first time
+   *
+   * Params:
+   *       Path p_path: Path to the image file
+   *
+   * Returns:
+   *        Surface with RGBA32 pixels, owned by the cache
+   *
+   * Throws:
+   *       If the image can not be loaded
+   */
+  SDL_Surface* get(const std::filesystem::path& p_path);
+
+private:
+  std::unordered_map<std::string, SDL_Surface*> surfaces__;
+};
+
 }
 
 #endif // !WFC_SDL_UTILS_H_
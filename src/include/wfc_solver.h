@@ -0,0 +1,643 @@
+#ifndef WFC_SOLVER_H_
+#define WFC_SOLVER_H_
+
+#include "wfc_directions.h"
+#include "wfc_domain.h"
+#include "wfc_heap.h"
+#include "wfc_random.h"
+#include "wfc_rules.h"
+#include "wfc_tile.h"
+#include "wfc_tile_registry.h"
+#include "wfc_utils.h"
+
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <unordered_map>
+#include <filesystem>
+#include <memory>
+#include <vector>
+#include <unordered_set>
+
+namespace wfc {
+
+struct Spot {
+  uint32_t tile;  /// Id of the collapsed tile, NO_TILE while the spot is not collapsed
+  Spot() : tile(wfc::NO_TILE) {
+  }
+};
+
+/*
+ * Wave function collapse solver over a grid of spots
+ *
+ * Holds the tiles, rules and constraints of a run together with all the state used while
+ * collapsing. The solver does not depend on SDL, tile images are only loaded by whoever draws it.
+ */
+class Solver {
+public:
+  /*
+   * Construct the solver for a grid of the given size
+   *
+   * Params:
+   *       size_t p_rows   : Number of rows in the grid
+   *       size_t p_columns: Number of columns in the grid
+   */
+  Solver(size_t p_rows, size_t p_columns);
+
+  /*
+   * Construct a copy of the solver with its own collapse state. The copy shares the tiles and
+   * their rules with the original until either of them changes its tiles
+   */
+  Solver(const Solver& p_other) = default;
+
+  Solver& operator=(const Solver&) = delete;
+
+  /*
+   * Set direction type
+   *
+   * Params:
+   *       DirectionType p_dir_type: Direction type to set
+   */
+  void set_direction_type(const wfc::DirectionType p_dir_type);
+
+  /*
+   * Add possible tiles for the solver. Tiles get dense ids in the order they are added, starting
+   * from 0
+   *
+   * Params:
+   *       String p_name     : Name of the tile
+   *       String p_path     : Path to the tile image
+   *       double p_weight   : Relative frequency of the tile
+   *       size_t p_transform: Quarters to turn the image clockwise plus 4 to mirror it after
+   *
+   * Returns:
+   *        Id of the tile
+   *
+   * Throws:
+   *       If tile with name p_name already exists
+   */
+  uint32_t add_tile(const std::string& p_name, const std::string& p_path, double p_weight = 1.0,
+                size_t p_transform = 0);
+
+  /*
+   * Add a possible tile for the solver whose image is given as pixels
+   *
+   * Params:
+   *       String          p_name  : Name of the tile
+   *       Vector<uint8_t> p_pixels: RGBA32 pixels of the tile image, p_width * 4 bytes per line
+   *       size_t          p_width : Width of the tile image in pixels
+   *       size_t          p_height: Height of the tile image in pixels
+   *       double          p_weight: Relative frequency of the tile
+   *
+   * Returns:
+   *        Id of the tile
+   *
+   * Throws:
+   *       If tile with name p_name already exists
+   */
+  uint32_t add_tile(const std::string& p_name, const std::vector<uint8_t>& p_pixels, size_t p_width,
+                size_t p_height, double p_weight = 1.0);
+
+  /*
+   * Add the tiles of a registry that interned their names already, tile i gets id i and the name
+   * of id i, so no name is interned again
+   *
+   * Params:
+   *       TileRegistry p_registry: Names of the tiles, one for every tile
+   *       Vector<Tile> p_tiles   : Tiles in the order of their ids, with their weights set
+   *
+   * Throws:
+   *       If the solver has tiles already
+   *       If p_registry does not have one name for every tile
+   */
+  void add_tiles(wfc::TileRegistry&& p_registry, std::vector<wfc::Tile>&& p_tiles);
+
+  /*
+   * Add rule to a tile in the solver
+   *
+   * Params:
+   *       String     p_for: Name of the tile for which to add the rule
+   *       Directions p_dir: Direction to add the rule in
+   *       String     p_to : Name of the tile in the rule
+   *
+   * Throws:
+   *       If tile with name p_for or p_to does not exist
+   */
+  void add_rule(const std::string& p_for, wfc::Directions p_dir, const std::string& p_to);
+
+  /*
+   * Add rule to a tile in the solver by the ids of the tiles
+   *
+   * Params:
+   *       uint32_t   p_for: Id of the tile for which to add the rule
+   *       Directions p_dir: Direction to add the rule in
+   *       uint32_t   p_to : Id of the tile in the rule
+   *
+   * Throws:
+   *       If tile with id p_for or p_to does not exist
+   */
+  void add_rule(uint32_t p_for, wfc::Directions p_dir, uint32_t p_to);
+
+  /*
+   * Add more than one rule of placement for tile in the solver
+   *
+   * Params:
+   *       String         p_for: Name of the tile for which to add the rule
+   *       Directions     p_dir: Direction to add the rule in
+   *       Vector<String> p_to : List of names of the tile in the rule
+   *
+   * Throws:
+   *       If tile with name p_for or p_to does not exist
+   */
+  void add_rule(const std::string& p_for, wfc::Directions p_dir, const std::vector<std::string>& p_to);
+
+  /*
+   * Make the rules of a side of a tile the only tiles allowed there, so a side left without rules
+   * allows no tile instead of every tile
+   *
+   * Params:
+   *       uint32_t   p_tile: Id of the tile
+   *       Directions p_dir : Side of the tile
+   *
+   * Throws:
+   *       If tile with id p_tile does not exist
+   */
+  void close_rules(uint32_t p_tile, wfc::Directions p_dir);
+
+  /*
+   * Give a side of a tile a socket. Tiles fit next to each other where the sockets of the facing
+   * sides are mirrors of each other, see wfc::mirror_socket. A side with a socket allows the tiles
+   * with a matching socket as well as the tiles named by its rules
+   *
+   * Params:
+   *       String     p_tile  : Name of the tile
+   *       Directions p_dir   : Side of the tile
+   *       String     p_socket: Label of the socket
+   *
+   * Throws:
+   *       If tile with name p_tile does not exist
+   */
+  void add_socket(const std::string& p_tile, wfc::Directions p_dir, const std::string& p_socket);
+
+  /*
+   * Give a side of a tile a socket by the id of the tile
+   *
+   * Params:
+   *       uint32_t   p_tile  : Id of the tile
+   *       Directions p_dir   : Side of the tile
+   *       String     p_socket: Label of the socket
+   *
+   * Throws:
+   *       If tile with id p_tile does not exist
+   */
+  void add_socket(uint32_t p_tile, wfc::Directions p_dir, const std::string& p_socket);
+
+  /*
+   * Add a constraint to the solver for edges
+   *
+   * Params:
+   *       Constraints p_cons: Constraint type to be added for
+   *       String      p_tile: Name of the tile for the constraint
+   *
+   * Throws:
+   *       If tile with name p_tile does not exist
+   */
+  void add_constraint(wfc::Constraints p_cons, const std::string& p_tile);
+
+  /*
+   * Add a constraint to the solver for edges by the id of the tile
+   *
+   * Params:
+   *       Constraints p_cons: Constraint type to be added for
+   *       uint32_t    p_tile: Id of the tile for the constraint
+   *
+   * Throws:
+   *       If tile with id p_tile does not exist
+   */
+  void add_constraint(wfc::Constraints p_cons, uint32_t p_tile);
+
+  /*
+   * Add a constraint to the solver for coordinates
+   *
+   * Params:
+   *       size_t  p_x   : x coordinate of the constraint
+   *       size_t  p_y   : y coordinate of the constraint
+   *       String  p_tile: Name of the tile for the constraint
+   *
+   * Throws:
+   *       If tile with name p_tile does not exist
+   *       If the coordinates are out of bound
+   */
+  void add_constraint(size_t x, size_t y, const std::string& p_tile);
+
+  /*
+   * Add a constraint to the solver for coordinates by the id of the tile
+   *
+   * Params:
+   *       size_t   p_x   : x coordinate of the constraint
+   *       size_t   p_y   : y coordinate of the constraint
+   *       uint32_t p_tile: Id of the tile for the constraint
+   *
+   * Throws:
+   *       If tile with id p_tile does not exist
+   *       If the coordinates are out of bound
+   */
+  void add_constraint(size_t x, size_t y, uint32_t p_tile);
+
+  /*
+   * Enable backtracking on contradictions. Removals are recorded on a trail so the solver can be
+   * undone to the last collapsed spot, banning the tile that led to the contradiction
+   *
+   * Params:
+   *       size_t p_budget: Maximum number of backtracks before collapse_next() gives up,
+   *                        0 disables backtracking
+   */
+  void set_backtrack_budget(size_t p_budget);
+
+  /*
+   * Enable local repair of contradictions that backtracking could not resolve. The block of spots
+   * around the spot left without possible tiles is cleared and solved again against the spots
+   * around it, leaving the rest of the grid untouched. The block grows if it cannot be solved
+   *
+   * Params:
+   *       size_t p_radius: Number of spots the block extends on each side of the contradiction,
+   *                        0 disables local repair
+   */
+  void set_repair_radius(size_t p_radius);
+
+  /*
+   * Seed the random number generator of the solver. Solvers with the same tiles, rules and seed
+   * produce the same result
+   *
+   * Params:
+   *       uint64_t p_seed: Seed value to set
+   */
+  void set_seed(uint64_t p_seed);
+
+  /*
+   * Replace the random number generator of the solver, for example with a stream split off
+   * another generator
+   *
+   * Params:
+   *       Random p_random: Generator to copy
+   */
+  void set_random(const wfc::Random& p_random);
+
+  /*
+   * Compile the rules of all tiles into the compatibility table used while collapsing.
+   * Does nothing unless tiles or rules were added since the rules were last compiled or loaded,
+   * so a table from load_rules() is kept. Called by reset()
+   */
+  void compile_rules();
+
+  /*
+   * Use a compatibility table compiled before, for example mapped from a ruleset file, instead of
+   * compiling the rules of the tiles
+   *
+   * Params:
+   *       uint64_t               p_table: Table laid out like get_rules().data() for the tiles of the solver
+   *       shared_ptr<const void> p_owner: Keeps p_table alive for as long as the solver or its copies use it
+   *
+   * Throws:
+   *       If the solver has more tiles than it supports
+   */
+  void load_rules(const uint64_t* p_table, std::shared_ptr<const void> p_owner);
+
+  /*
+   * Get the compiled rules, after compile_rules() or load_rules()
+   */
+  const wfc::Rules& get_rules() const;
+
+  /*
+   * Reset the solver, clearing all collapsed spots
+   */
+  void reset();
+
+  /*
+   * Collapse the next tile in the grid. On a contradiction the solver backtracks if a backtrack
+   * budget is set and then repairs the block around the contradiction if a repair radius is set
+   *
+   * Returns:
+   *        true if tile was collapsed successfully, else false
+   */
+  bool collapse_next();
+
+  /*
+   * Check if every spot of the grid is collapsed
+   */
+  bool is_collapsed() const;
+
+  /*
+   * Get the number of rows in the grid
+   */
+  size_t get_rows() const;
+
+  /*
+   * Get the number of columns in the grid
+   */
+  size_t get_columns() const;
+
+  /*
+   * Get all tiles of the solver indexed by their id. The tiles stay where they are until tiles are
+   * added or changed
+   */
+  const std::vector<wfc::Tile*>& get_tiles() const;
+
+  /*
+   * Get the names of all tiles of the solver indexed by their id
+   */
+  const std::vector<std::string>& get_tile_names() const;
+
+  /*
+   * Get the id of a tile by its name
+   *
+   * Params:
+   *       String p_name: Name of the tile
+   *
+   * Returns:
+   *        Id of the tile, NO_TILE if the solver has no tile with that name
+   */
+  uint32_t get_tile_id(const std::string& p_name) const;
+
+  /*
+   * Get the tile collapsed into a spot
+   *
+   * Params:
+   *       size_t p_spot_idx: Index of the spot, row * columns + column
+   *
+   * Returns:
+   *        Collapsed tile, or nullptr if the spot is not collapsed yet
+   */
+  const wfc::Tile* get_tile(size_t p_spot_idx) const;
+
+  /*
+   * Take the spots whose collapsed tile changed since the last call, so a viewer only has to
+   * redraw those. Each spot is listed once, in the order it first changed
+   *
+   * Params:
+   *       Vector<uint32_t> p_out: Replaced with the indices of the changed spots
+   */
+  void take_dirty(std::vector<uint32_t>& p_out);
+
+  /*
+   * Check the support counters against a count from the domains, and that every possible tile is
+   * supported on every side with a neighbour. Goes through every counter, meant for tests
+   *
+   * Returns:
+   *        true if the counters and domains agree, false also while a contradiction is pending
+   */
+  bool check_supports() const;
+
+private:
+  struct Constraints {
+    std::unordered_map<wfc::Constraints, std::unordered_set<uint32_t>> others;
+    std::unordered_map<size_t, std::unordered_set<uint32_t>> fixed;
+  };
+
+  struct TileStore {
+    std::vector<wfc::Tile> tiles;  /// Tiles indexed by their id
+    wfc::TileRegistry registry;    /// Names of the tiles
+  };
+
+  struct Removal {
+    uint32_t spot;
+    uint32_t tile;
+  };
+
+  struct Decision {
+    size_t trail_size;
+    uint32_t spot;
+    uint32_t tile;
+  };
+
+  const size_t rows__;
+  const size_t columns__;
+  wfc::DirectionType direction_type__;
+  std::shared_ptr<TileStore> tiles__;  /// Shared by copies of the solver until one of them changes it
+  std::vector<wfc::Tile*> tile_list__;  /// Points into tiles__
+  std::unordered_map<std::string, uint32_t> socket_ids__;  /// Dense id of every socket label
+  wfc::Rules rules__;
+  bool rules_dirty__;
+  Constraints constraints__;
+  std::vector<wfc::Spot> buffer__;
+  wfc::Domains domains__;
+  wfc::Domains root_domains__;
+  std::vector<uint64_t> mask__;
+  std::vector<wfc::Directions> directions__;
+  std::vector<uint16_t> supports__;
+  std::vector<double> sum_weights__;
+  std::vector<double> sum_weight_logs__;
+  std::vector<Removal> removals__;
+  std::vector<Decision> decisions__;
+  size_t backtrack_budget__;
+  size_t backtrack_count__;
+  size_t repair_radius__;
+  size_t repair_count__;
+  size_t attempt_trail__;       /// Trail size before the last collapse or backtrack ban was propagated
+  size_t attempt_idx__;         /// Spot collapsed by that attempt, SIZE_MAX for a backtrack ban
+  size_t last_repair_idx__;     /// Center of the last repaired block, SIZE_MAX before any repair
+  size_t last_repair_radius__;  /// Radius the last repaired block needed
+  wfc::EntropyHeap heap__;
+  wfc::Random random__;
+  size_t propagated__;
+  bool contradiction__;
+  size_t contradiction_idx__;
+  size_t collapsed_count__;
+  std::vector<uint32_t> dirty__;
+  std::vector<uint8_t> dirty_flags__;
+
+  /*
+   * Record that the collapsed tile of a spot changed
+   */
+  void mark_dirty__(size_t p_spot_idx) {
+    if (!dirty_flags__[p_spot_idx]) {
+      dirty_flags__[p_spot_idx] = 1;
+      dirty__.push_back(p_spot_idx);
+    }
+  }
+
+  /*
+   * Give a new tile the next id and add it to tiles__ and tile_list__
+   *
+   * Params:
+   *       String    p_name  : Name of the tile
+   *       Tile      p_tile  : Tile to add
+   *       double    p_weight: Relative frequency of the tile
+   *
+   * Returns:
+   *        Id of the tile
+   *
+   * Throws:
+   *       If tile with name p_name already exists in tiles__
+   */
+  uint32_t insert_tile__(const std::string& p_name, wfc::Tile&& p_tile, double p_weight);
+
+  /*
+   * Get a tile to change, first copying tiles__ if it is shared with another solver
+   *
+   * Params:
+   *       uint32_t p_id: Id of the tile
+   *
+   * Throws:
+   *       If tile with id p_id does not exist
+   */
+  wfc::Tile& edit_tile__(uint32_t p_id);
+
+  /*
+   * Copy tiles__ if it is shared with another solver, so changing it leaves the other solver as it is
+   */
+  void own_tiles__();
+
+  /*
+   * Get the id of a tile by its name
+   *
+   * Throws:
+   *       If tile with name p_name does not exist
+   */
+  uint32_t find_tile__(const std::string& p_name) const;
+
+  /*
+   * Check that a tile id is in range
+   *
+   * Throws:
+   *       If tile with id p_id does not exist
+   */
+  void check_tile_id__(uint32_t p_id) const;
+
+  /*
+   * Point tile_list__ at the tiles of tiles__ again after they moved
+   */
+  void list_tiles__();
+
+  /*
+   * Take the uncollapsed spot with lowest entropy out of heap__. Spots with the same lowest
+   * entropy are ordered randomly
+   *
+   * Returns:
+   *        Index of the selected spot in buffer__
+   */
+  size_t get_lowest_entropy_spot_idx__();
+
+  /*
+   * Get the index of the neighbour of a spot
+   *
+   * Params:
+   *       size_t p_spot_idx: Index of the spot in buffer__
+   *       size_t p_dir_idx : Index of the direction in directions__
+   *       size_t p_out     : Set to the index of the neighbour
+   *
+   * Returns:
+   *        true if the neighbour exists, else false
+   */
+  bool neighbour__(size_t p_spot_idx, size_t p_dir_idx, size_t& p_out) const;
+
+  /*
+   * Get the support counter of a tile in a spot, the number of tiles still possible in the
+   * neighbour in the given direction that are compatible with it
+   */
+  uint16_t& support__(size_t p_spot_idx, size_t p_tile, size_t p_dir_idx) {
+    return supports__[(p_spot_idx * tile_list__.size() + p_tile) * directions__.size() + p_dir_idx];
+  }
+
+  /*
+   * Get the Shannon entropy of the possible tiles of a spot from its running weight sums
+   */
+  double entropy__(size_t p_spot_idx) const;
+
+  /*
+   * Remove a tile from the possible tiles of a spot and queue the removal for propagation
+   *
+   * Params:
+   *       size_t p_spot_idx: Index of the spot in buffer__
+   *       size_t p_tile    : Id of the tile to remove
+   */
+  void ban__(size_t p_spot_idx, size_t p_tile);
+
+  /*
+   * Propagate all queued removals through the support counters until no more tiles lose their
+   * last support
+   *
+   * Returns:
+   *        false if a spot was left without possible tiles, else true
+   */
+  bool propagate__();
+
+  /*
+   * Put back all removals after the given position of removals__, restoring possible tiles,
+   * weight sums and the support counters of removals that were already propagated
+   *
+   * Params:
+   *       size_t p_trail_size: Number of removals to keep
+   */
+  void undo__(size_t p_trail_size);
+
+  /*
+   * Undo decisions until banning the failed tile of a decision propagates without contradiction
+   *
+   * Returns:
+   *        false if the backtrack budget ran out or no decision is left to undo, else true
+   */
+  bool backtrack__();
+
+  /*
+   * Set the support counters of every tile of a spot from the possible tiles of its neighbours
+   *
+   * Params:
+   *       size_t p_spot_idx: Index of the spot in buffer__
+   */
+  void recount_supports__(size_t p_spot_idx);
+
+  /*
+   * Clear a square block of spots back to the possible tiles they had after reset() and remove
+   * the tiles that the spots around the block do not support
+   *
+   * Params:
+   *       size_t p_spot_idx: Index of the spot at the center of the block
+   *       size_t p_radius  : Number of spots the block extends on each side of the center
+   */
+  void reset_block__(size_t p_spot_idx, size_t p_radius);
+
+  /*
+   * Repair the contradiction at contradiction_idx__ by solving the block around it again,
+   * doubling the block until propagation succeeds. A contradiction next to the last repaired
+   * block starts one spot wider than it, so an area that keeps failing is cleared wider each time
+   *
+   * Returns:
+   *        false if local repair is disabled, its budget ran out or the block covered the whole
+   *        grid without success, else true
+   */
+  bool repair__();
+
+  /*
+   * Apply constraints defined in constraints__ to the buffer
+   */
+  void apply_constraints__();
+
+  /*
+   * Check that the solver does not have more tiles than its 16 bit support counters allow
+   *
+   * Throws:
+   *       If there are more than UINT16_MAX tiles
+   */
+  void check_tile_count__() const;
+
+  /*
+   * Collect the directions of the canvas after the rules were compiled or loaded
+   */
+  void use_rules__();
+
+  /*
+   * Fill mask__ with the given tile ids
+   *
+   * Params:
+   *       unordered_set<uint32_t> p_tiles: Ids of the tiles to set in the mask
+   *
+   * Returns:
+   *        Pointer to the words of mask__
+   */
+  const uint64_t* make_mask__(const std::unordered_set<uint32_t>& p_tiles);
+};
+
+}
+
+#endif // !WFC_SOLVER_H_
@@ -0,0 +1,114 @@
+#ifndef WFC_SOLVER_THREAD_H_
+#define WFC_SOLVER_THREAD_H_
+
+#include "wfc_solver.h"
+
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <thread>
+#include <vector>
+
+namespace wfc {
+
+/*
+ * State of a solver as seen by the viewer
+ */
+struct Snapshot {
+  std::vector<uint32_t> tiles;  /// Id of the tile collapsed into each spot, wfc::NO_TILE if uncollapsed
+  std::vector<uint32_t> dirty;  /// Spots that changed since the previous snapshot
+  bool collapsed;               /// Whether every spot is collapsed
+};
+
+/*
+ * Runs a solver on its own thread and publishes snapshots of it for the viewer
+ *
+ * Snapshots are triple buffered: the worker fills a back buffer and swaps it with the middle one,
+ * the viewer swaps its front buffer with the middle one when a new snapshot is there. Both swaps
+ * are a single atomic exchange, so neither thread ever waits for the other. The worker only
+ * publishes once the viewer took the previous snapshot, so the dirty spots of every snapshot are
+ * relative to the one the viewer had before. Commands from the viewer are atomic flags the worker
+ * checks between collapses.
+ */
+class SolverThread {
+public:
+  /*
+   * Start solving on a new thread. Spots are collapsed until the grid is done, a failed collapse
+   * resets the solver
+   *
+   * Params:
+   *       Solver*  p_solver  : Solver to run, must not be used by anyone else until stop()
+   *       uint32_t p_interval: Time to wait after each collapse in ms, 0 to solve at full speed
+   */
+  SolverThread(wfc::Solver* p_solver, uint32_t p_interval);
+
+  /*
+   * Stop the thread if it is still running
+   */
+  ~SolverThread();
+
+  SolverThread(const SolverThread&) = delete;
+  SolverThread& operator=(const SolverThread&) = delete;
+
+  /*
+   * Ask the solver to reset, clearing all collapsed spots
+   */
+  void reset();
+
+  /*
+   * Take the newest snapshot if the solver published one since the last call
+   *
+   * Returns:
+   *        true if get_snapshot() changed, else false
+   */
+  bool update();
+
+  /*
+   * Get the snapshot taken by the last update(). It stays the same until update() returns true
+   */
+  const wfc::Snapshot& get_snapshot() const;
+
+  /*
+   * Stop the thread and wait for it, after which the solver can be used again
+   *
+   * Throws:
+   *       The exception that stopped the solver thread, if any
+   */
+  void stop();
+
+private:
+  enum Command : uint32_t {
+    COMMAND_RESET = 1,
+    COMMAND_STOP = 2
+  };
+
+  static constexpr uint8_t FRESH = 4;
+  static constexpr uint8_t INDEX_MASK = 3;
+
+  wfc::Solver* solver__;
+  const uint32_t interval__;
+  wfc::Snapshot buffers__[3];
+  std::vector<uint32_t> pending__[3];
+  std::vector<uint32_t> dirty__;
+  std::atomic<uint8_t> middle__;
+  uint8_t back__;
+  uint8_t front__;
+  std::atomic<uint32_t> commands__;
+  std::exception_ptr error__;
+  std::thread thread__;
+
+  /*
+   * Collapse spots and publish snapshots until a stop command arrives
+   */
+  void work__();
+
+  /*
+   * Publish the changes since the last snapshot if the viewer took it
+   */
+  void publish__();
+};
+
+}
+
+#endif // !WFC_SOLVER_THREAD_H_
@@ -0,0 +1,110 @@
+#ifndef WFC_SYMMETRY_H_
+#define WFC_SYMMETRY_H_
+
+#include "wfc_directions.h"
+
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+namespace wfc {
+
+/*
+ * Symmetry of a tile image, named after a letter with the same symmetry. It decides how many
+ * distinct variants turning and mirroring the image gives, and which variant each of them is
+ *
+ *  X: Looks the same turned or mirrored, 1 variant
+ *  I: Looks the same turned upside down or mirrored left to right, like a vertical line, 2 variants
+ *  \: Looks the same turned upside down, mirrored left to right it looks turned a quarter, 2 variants
+ *  T: Looks the same mirrored left to right, like a T, 4 variants
+ *  L: Mirrored left to right it looks turned a quarter clockwise, like a corner joining north and
+ *     west, 4 variants
+ *  F: No symmetry, 8 variants
+ */
+enum class Symmetry {
+  X,
+  I,
+  BACKSLASH,
+  T,
+  L,
+  F
+};
+
+const size_t TRANSFORM_COUNT = 8;  /// Number of ways to turn and mirror an image
+
+/*
+ * Get the number of distinct variants of a tile. Variant k of a tile is its image turned k % 4
+ * quarters clockwise and then mirrored left to right if k >= 4
+ */
+size_t variant_count(wfc::Symmetry p_symmetry);
+
+/*
+ * Get the variant of a tile that a variant becomes when turned a quarter clockwise
+ *
+ * Params:
+ *       Symmetry p_symmetry: Symmetry of the tile
+ *       size_t   p_variant : Variant to turn, less than variant_count(p_symmetry)
+ */
+size_t rotate_variant(wfc::Symmetry p_symmetry, size_t p_variant);
+
+/*
+ * Get the variant of a tile that a variant becomes when mirrored left to right
+ *
+ * Params:
+ *       Symmetry p_symmetry: Symmetry of the tile
+ *       size_t   p_variant : Variant to mirror, less than variant_count(p_symmetry)
+ */
+size_t reflect_variant(wfc::Symmetry p_symmetry, size_t p_variant);
+
+/*
+ * Get the variant of a tile that a variant becomes under a transform
+ *
+ * Params:
+ *       Symmetry p_symmetry : Symmetry of the tile
+ *       size_t   p_variant  : Variant to transform, less than variant_count(p_symmetry)
+ *       size_t   p_transform: Quarters to turn clockwise plus 4 to mirror after, less than TRANSFORM_COUNT
+ */
+size_t transform_variant(wfc::Symmetry p_symmetry, size_t p_variant, size_t p_transform);
+
+/*
+ * Get the direction a direction points in after a transform
+ *
+ * Params:
+ *       Directions p_dir      : Direction to transform
+ *       size_t     p_transform: Quarters to turn clockwise plus 4 to mirror after, less than TRANSFORM_COUNT
+ */
+wfc::Directions transform_direction(wfc::Directions p_dir, size_t p_transform);
+
+/*
+ * Get the label a socket has when it is mirrored. Sockets are read clockwise around their tile, so
+ * the facing side of a neighbour reads the same edge the other way. A socket that looks the same
+ * both ways is its own mirror, a label ending in '>' has the same label ending in '<' as its mirror
+ * and the other way around
+ *
+ * Params:
+ *       String p_socket: Label of the socket
+ */
+std::string mirror_socket(const std::string& p_socket);
+
+/*
+ * Turn and mirror an RGBA32 image
+ *
+ * Params:
+ *       uint8_t p_pixels    : RGBA32 pixels of the image
+ *       size_t  p_width     : Width of the image in pixels
+ *       size_t  p_height    : Height of the image in pixels
+ *       size_t  p_pitch     : Number of bytes between two lines of p_pixels
+ *       size_t  p_transform : Quarters to turn clockwise plus 4 to mirror after, less than TRANSFORM_COUNT
+ *       size_t  p_out_width : Set to the width of the transformed image
+ *       size_t  p_out_height: Set to the height of the transformed image
+ *
+ * Returns:
+ *        RGBA32 pixels of the transformed image, p_out_width * 4 bytes per line
+ */
+std::vector<uint8_t> transform_image(const uint8_t* p_pixels, size_t p_width, size_t p_height, size_t p_pitch,
+                                     size_t p_transform, size_t& p_out_width, size_t& p_out_height);
+
+}
+
+#endif // !WFC_SYMMETRY_H_
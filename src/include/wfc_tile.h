@@ -3,15 +3,16 @@
 
 #include "wfc_directions.h"
 
+#include <cstdint>
 #include <string>
-#include <unordered_set>
-#include <unordered_map>
+#include <vector>
 #include <initializer_list>
 #include <filesystem>
-#include <SDL2/SDL.h>
 
 namespace wfc {
 
+const uint32_t NO_SOCKET = UINT32_MAX;  /// Socket id of a side without a socket
+
 class Tile {
 public:
 
@@ -19,83 +20,163 @@ public:
    * Construct the tile object with the path to the tile image
    *
    * Params:
-   *       String p_path    : Path to the image file of the tile
+   *       String p_path     : Path to the image file of the tile
+   *       size_t p_transform: Quarters to turn the image clockwise plus 4 to mirror it after, see
+   *                           wfc_symmetry.h
    */
-  Tile(const std::string& p_path);
+  Tile(const std::string& p_path, size_t p_transform = 0);
 
   /*
-   * Construct the tile object with the path to the tile image and use the given renderer
-   * to load the image
+   * Construct the tile object with the pixels of its image instead of a path
    *
    * Params:
-   *       String        p_path     : Path to the image file of the tile
-   *       SDL_Renderer* p_renderer : Renderer to use to load the image
+   *       Vector<uint8_t> p_pixels: RGBA32 pixels of the image, p_width * 4 bytes per line
+   *       size_t          p_width : Width of the image in pixels
+   *       size_t          p_height: Height of the image in pixels
    */
-  Tile(const std::string& p_path, SDL_Renderer* renderer);
+  Tile(const std::vector<uint8_t>& p_pixels, size_t p_width, size_t p_height);
 
   /*
-   * Load the image from its path
-   *
-   * Params:
-   *       SDL_Renderer* p_renderer: Renderer to use to load the texture for the tile
-   *
-   * Throws:
-   *       If Img_Load fails to load image at p_path
-   *       If conversion from SDL Surface to SDL Texture fails
+   * Get the path to the image file of the tile, empty if the tile was given its pixels
+   */
+  const std::filesystem::path& get_path() const;
+
+  /*
+   * Get how the image file is turned and mirrored to get the image of the tile
+   */
+  size_t get_transform() const;
+
+  /*
+   * Get the RGBA32 pixels the tile was constructed with, empty if it has an image file
+   */
+  const std::vector<uint8_t>& get_pixels() const;
+
+  /*
+   * Get the width of the pixels the tile was constructed with
+   */
+  size_t get_width() const;
+
+  /*
+   * Get the height of the pixels the tile was constructed with
    */
-  void load(SDL_Renderer* p_renderer);
+  size_t get_height() const;
 
   /*
    * Add a rule of placement for this tile in the given direction
    *
    * Params:
    *       Directions p_dir : Direction of the rule
-   *       Tile*      p_tile: Pointer to the tile that can be placed in the direction of this tile
+   *       uint32_t   p_tile: Id of the tile that can be placed in the direction of this tile
    */
-  void add_rule(wfc::Directions p_direction, Tile* p_tile);
+  void add_rule(wfc::Directions p_direction, uint32_t p_tile);
 
   /*
    * Add more than one rule of placement for this tile in the given direction
    *
    * Params:
-   *       Directions              p_dir : Direction of the rule
-   *       initializer_list<Tile*> p_tile: List of pointers to the tile that can be placed in the
-   *                                       direction of this tile
+   *       Directions                 p_dir : Direction of the rule
+   *       initializer_list<uint32_t> p_tile: List of ids of the tiles that can be placed in the
+   *                                          direction of this tile
    */
-  void add_rule(wfc::Directions p_direction, const std::initializer_list<Tile*>& p_list);
+  void add_rule(wfc::Directions p_direction, const std::initializer_list<uint32_t>& p_list);
 
   /*
-   * Get the set of possible tiles from the rules__ for the given direction
+   * Get the ids of the possible tiles from the rules__ for the given direction, in the order they
+   * were added and possibly repeated
    *
    * Params:
    *       Directions p_dir: Direction of the rule to get
    *
    * Returns:
-   *        Unordered set of pointers to possible tiles that can be placed in the given direction
+   *        Ids of the tiles that can be placed in the given direction
    */
-  std::unordered_set<Tile*> get_rules(wfc::Directions p_dir);
+  const std::vector<uint32_t>& get_rules(wfc::Directions p_dir) const;
 
   /*
    * Check if the given tile can be placed in the given direction
    *
    * Params:
    *       Directions p_dir : Direction to check in
-   *       Tile*      p_tile: Tile to check
+   *       uint32_t   p_tile: Id of the tile to check
    *
    * Return:
    *       true if tile can be placed else false
    */
-  bool check_rule(wfc::Directions p_direction, Tile* p_tile);
+  bool check_rule(wfc::Directions p_direction, uint32_t p_tile) const;
+
+  /*
+   * Make the rules of a side the only tiles allowed there, even when it has none. A side without
+   * rules or socket otherwise allows every tile
+   *
+   * Params:
+   *       Directions p_dir: Side of the tile
+   */
+  void close_rules(wfc::Directions p_dir);
+
+  /*
+   * Check if a side allows only the tiles of its rules and socket, see close_rules
+   */
+  bool are_rules_closed(wfc::Directions p_dir) const;
+
+  /*
+   * Give a side of the tile a socket. Another tile fits on that side when the socket of its facing
+   * side is the mirror of this one
+   *
+   * Params:
+   *       Directions p_dir   : Side of the tile
+   *       uint32_t   p_socket: Id of the socket
+   *       uint32_t   p_mirror: Id of the mirror of the socket, p_socket for a symmetric socket
+   */
+  void set_socket(wfc::Directions p_dir, uint32_t p_socket, uint32_t p_mirror);
+
+  /*
+   * Get the id of the socket of a side, NO_SOCKET if it has none
+   */
+  uint32_t get_socket(wfc::Directions p_dir) const;
+
+  /*
+   * Get the id of the socket a facing side needs to fit a side, NO_SOCKET if it has none
+   */
+  uint32_t get_mirror_socket(wfc::Directions p_dir) const;
+
+  /*
+   * Set the dense integer id of the tile used to index the domains of the canvas
+   *
+   * Params:
+   *       uint32_t p_id: Id of the tile
+   */
+  void set_id(uint32_t p_id);
+
+  /*
+   * Get the dense integer id of the tile
+   */
+  uint32_t get_id() const;
+
+  /*
+   * Set the weight of the tile, the relative frequency with which it is chosen when collapsing
+   *
+   * Params:
+   *       double p_weight: Weight of the tile
+   */
+  void set_weight(double p_weight);
 
   /*
-   * Get the texture of the tile
+   * Get the weight of the tile
    */
-  SDL_Texture* get_texture() const;
+  double get_weight() const;
 
 private:
-  const std::filesystem::path path__;
-  std::unordered_map<wfc::Directions, std::unordered_set<Tile*>> rules__;
-  SDL_Texture* texture__;
+  std::filesystem::path path__;
+  size_t transform__;
+  std::vector<uint8_t> pixels__;
+  size_t width__;
+  size_t height__;
+  uint32_t id__;
+  double weight__;
+  std::vector<uint32_t> rules__[wfc::DIRECTION_COUNT];  /// Ids of the tiles allowed on every side
+  bool closed__[wfc::DIRECTION_COUNT];              /// Sides that allow nothing beyond their rules
+  uint32_t sockets__[wfc::DIRECTION_COUNT];         /// Socket id of every side
+  uint32_t mirror_sockets__[wfc::DIRECTION_COUNT];  /// Socket id the facing side needs
 };
 
 }
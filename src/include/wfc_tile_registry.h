@@ -0,0 +1,76 @@
+#ifndef WFC_TILE_REGISTRY_H_
+#define WFC_TILE_REGISTRY_H_
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace wfc {
+
+const uint32_t NO_TILE = UINT32_MAX;  /// Id of no tile, for unknown names and empty spots
+
+/*
+ * Interns tile names to dense ids, the first name gets id 0, the next id 1 and so on
+ *
+ * Names are hashed once when they are interned, after that tiles are referred to by id and the
+ * name of an id is a plain index.
+ */
+class TileRegistry {
+public:
+  /*
+   * Get the id of a name, giving it the next id if it is new
+   *
+   * Params:
+   *       String p_name: Name of the tile
+   *
+   * Returns:
+   *        Id of the name
+   */
+  uint32_t intern(const std::string& p_name);
+
+  /*
+   * Get the id of a name
+   *
+   * Params:
+   *       String p_name: Name of the tile
+   *
+   * Returns:
+   *        Id of the name, NO_TILE if it was not interned
+   */
+  uint32_t find(const std::string& p_name) const;
+
+  /*
+   * Get the name of an id
+   */
+  const std::string& name(uint32_t p_id) const {
+    return names__[p_id];
+  }
+
+  /*
+   * Get the names of all ids, indexed by id
+   */
+  const std::vector<std::string>& names() const {
+    return names__;
+  }
+
+  /*
+   * Get the number of interned names
+   */
+  size_t size() const {
+    return names__.size();
+  }
+
+  /*
+   * Make room for p_count names
+   */
+  void reserve(size_t p_count);
+
+private:
+  std::vector<std::string> names__;
+  std::unordered_map<std::string, uint32_t> ids__;
+};
+
+}
+
+#endif // !WFC_TILE_REGISTRY_H_
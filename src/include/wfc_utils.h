@@ -1,9 +1,15 @@
 #ifndef WFC_UTILS_H_
 #define WFC_UTILS_H_
 
+#include "wfc_directions.h"
+
+#include <algorithm>
+#include <cstdint>
 #include <cstdlib>
 #include <iterator>
+#include <thread>
 #include <unordered_set>
+#include <vector>
 
 namespace wfc {
 
@@ -47,6 +53,119 @@ auto select_from(const S &s, size_t n) {
   return it;
 }
 
+/*
+ * Split [0, p_count) into one range per thread and call p_work(begin, end, thread) on each,
+ * the first range on the calling thread
+ */
+template<typename Work>
+void parallel_for(size_t p_count, size_t p_threads, Work p_work) {
+  size_t threads = std::max<size_t>(1, std::min(p_threads, p_count));
+
+  std::vector<std::thread> workers;
+  for (size_t t = 1; t < threads; ++t) {
+    workers.emplace_back(p_work, p_count * t / threads, p_count * (t + 1) / threads, t);
+  }
+  p_work(0, p_count / threads, 0);
+
+  for (std::thread& worker : workers) {
+    worker.join();
+  }
+}
+
+/*
+ * Ids of the items that can be placed in every direction of every item, for the overlapping model
+ * and the edge rules. The ids of all directions and items are stored back to back, direction by
+ * direction, with the offset of each list
+ */
+class CompatibilityLists {
+public:
+  /*
+   * Construct lists of no items
+   */
+  CompatibilityLists() :
+    count__(0) {
+  }
+
+  /*
+   * Find the lists of p_count items on several threads. For each direction d that is a multiple of
+   * p_dir_step, p_prepare(d) is called once and returns find(item, out), which appends the ids
+   * that can be placed in direction d of item to out. The lists do not depend on the number of
+   * threads. Other directions are left empty
+   *
+   * Params:
+   *       size_t  p_count   : Number of items
+   *       size_t  p_threads : Number of threads to use, 0 for one
+   *       size_t  p_dir_step: 1 for all directions, 2 to leave the diagonals empty
+   *       Prepare p_prepare : Called with each direction, returns the finder of that direction
+   */
+  template<typename Prepare>
+  void build(size_t p_count, size_t p_threads, size_t p_dir_step, Prepare p_prepare) {
+    size_t threads = std::max<size_t>(p_threads, 1);
+    count__ = p_count;
+    ids__.clear();
+    offsets__.assign(wfc::DIRECTION_COUNT * p_count + 1, 0);
+    std::vector<std::vector<uint32_t>> found(threads);
+
+    for (size_t d = 0; d < wfc::DIRECTION_COUNT; ++d) {
+
+      /// Directions that are not used repeat the last offset
+
+      size_t* counts = &offsets__[d * p_count + 1];
+      if (d % p_dir_step != 0) {
+        std::fill(counts, counts + p_count, counts[-1]);
+        continue;
+      }
+
+      /// Each thread collects the ids of its items, the offsets briefly hold the counts
+
+      auto find = p_prepare(d);
+      for (std::vector<uint32_t>& out : found) {
+        out.clear();
+      }
+      wfc::parallel_for(p_count, threads, [&](size_t p_begin, size_t p_end, size_t p_thread) {
+        std::vector<uint32_t>& out = found[p_thread];
+        for (size_t item = p_begin; item < p_end; ++item) {
+          size_t before = out.size();
+          find(item, out);
+          counts[item] = out.size() - before;
+        }
+      });
+
+      /// Append the ids in thread order, which is item order, and turn the counts into offsets
+
+      for (const std::vector<uint32_t>& out : found) {
+        ids__.insert(ids__.end(), out.begin(), out.end());
+      }
+      for (size_t i = 0; i < p_count; ++i) {
+        counts[i] += counts[i - 1];
+      }
+    }
+  }
+
+  /*
+   * Get the ids that can be placed in the given direction of an item
+   *
+   * Returns:
+   *        Pointer to get_count(p_item, p_dir) ids
+   */
+  const uint32_t* get(size_t p_item, wfc::Directions p_dir) const {
+    return ids__.data() + offsets__[static_cast<size_t>(p_dir) * count__ + p_item];
+  }
+
+  /*
+   * Get the number of ids that can be placed in the given direction of an item
+   */
+  size_t get_count(size_t p_item, wfc::Directions p_dir) const {
+    size_t idx = static_cast<size_t>(p_dir) * count__ + p_item;
+    return offsets__[idx + 1] - offsets__[idx];
+  }
+
+private:
+  size_t count__;
+  std::vector<uint32_t> ids__;     /// Ids of every direction and item, back to back
+  std::vector<size_t> offsets__;  /// Start of the ids of direction d and item i at d * count + i
+};
+
 }
 
 #endif // !WFC_UTILS_H_
@@ -1,21 +1,205 @@
 #include "wfc.h"
 #include "wfc_canvas.h"
-#include "wfc_random.h"
+#include "wfc_portfolio.h"
+#include "wfc_batch.h"
+#include "wfc_compositor.h"
+#include "wfc_solver_thread.h"
 #include "wfc_log.h"
 
 #include <unistd.h>
+#include <getopt.h>
 #include <string>
+#include <vector>
 #include <filesystem>
+#include <chrono>
+#include <algorithm>
+#include <random>
+#include <sstream>
+#include <iomanip>
+#include <regex>
+#include <memory>
 
-#define USAGE "Usage: ./wfc [-s seed] [-t delay_time_in_ms] [-o /path/to/output_image.png] </path/to/config.json>"
+#define USAGE "Usage: ./wfc [-s seed] [-t delay_time_in_ms] [-b backtrack_budget] [-m repair_radius] [-f | --fast] [-r max_restarts] [-j threads] [-o /path/to/output_image.png|ppm] [--lod level] [--count N --seed-start S --out-pattern out_%05d.png] </path/to/config.json|rules.wfcb>\n       ./wfc compile [-o /path/to/rules.wfcb] </path/to/config.json>"
 
 namespace fs = std::filesystem;
 
 const uint32_t TARGET_FPS = 60;                  /// FPS to run the SDL window in
 const uint32_t FRAME_DELAY = 1000 / TARGET_FPS;  /// Frame Delay in ms for the set FSP
-uint32_t COLLAPSE_INTERVAL = 10;                 /// Time between each collapse in ms
+uint32_t COLLAPSE_INTERVAL = 0;                  /// Time between each collapse in ms, 0 for full speed
 std::string OUTPUT_IMAGE_PATH = "";              /// Path to store the file image
-int32_t SEED = -1;                               /// Seed to use for random number generation, random seed if -1
+int64_t SEED = -1;                               /// Seed to use for random number generation, random seed if -1
+size_t BACKTRACK_BUDGET = 0;                     /// Number of backtracks allowed before resetting, 0 to always reset
+size_t REPAIR_RADIUS = 0;                        /// Radius of the block repaired on contradiction, 0 to disable
+bool FAST = false;                               /// Solve to completion without a window, then exit
+size_t MAX_RESTARTS = 100;                       /// Number of restarts allowed in fast mode, 0 for no limit
+size_t THREADS = 1;                              /// Number of threads racing seeds in fast mode
+size_t COUNT = 0;                                /// Number of images to generate in batch mode, 0 to disable
+uint64_t SEED_START = 0;                         /// Seed of the first image in batch mode
+std::string OUTPUT_PATTERN = "";                 /// Output path of batch images with a %d for the index
+size_t OUTPUT_LEVEL = 0;                         /// Mip level of the tiles in output images, each level halves them
+
+/// Exit status of fast mode when no solution was found within MAX_RESTARTS
+const int EXIT_UNSOLVED = 2;
+
+/// Options that only have a long form
+enum LongOptions {
+  OPT_COUNT = 256,
+  OPT_SEED_START,
+  OPT_OUT_PATTERN,
+  OPT_LOD
+};
+
+/*
+ * Check if the given path has the extension of an image format the output can be saved in
+ */
+bool is_image_path(const std::string& p_path) {
+  fs::path extension = fs::path(p_path).extension();
+  return extension == ".png" || extension == ".ppm";
+}
+
+/*
+ * Build the output path of a batch image by replacing the %d, %5d or %05d in OUTPUT_PATTERN with
+ * the index of the image
+ *
+ * Params:
+ *       size_t p_index: Index of the image
+ *
+ * Returns:
+ *        Path to the image
+ */
+std::string format_output_path(size_t p_index) {
+  static const std::regex conversion("%(0?)([0-9]*)d");
+  std::smatch match;
+  std::regex_search(OUTPUT_PATTERN, match, conversion);
+
+  std::stringstream path;
+  path << match.prefix()
+       << std::setfill(match[1].length() ? '0' : ' ')
+       << std::setw(match[2].length() ? std::stoi(match[2]) : 0)
+       << p_index
+       << match.suffix();
+  return path.str();
+}
+
+/*
+ * Solve COUNT images with seeds from SEED_START on THREADS workers and save them using
+ * OUTPUT_PATTERN. Images are saved on the calling thread while the workers keep solving
+ *
+ * Params:
+ *       Solver* p_solver: Configured solver to copy for every worker
+ *
+ * Returns:
+ *        Exit status of the process
+ */
+int run_batch(const wfc::Solver* p_solver) {
+  std::unique_ptr<wfc::Compositor> compositor;
+  if (OUTPUT_PATTERN != "") {
+    try {
+      compositor = std::make_unique<wfc::Compositor>(p_solver->get_tiles());
+    }
+    catch (const std::runtime_error& err) {
+      wfc::Log::error(err.what());
+      return 1;
+    }
+  }
+
+  wfc::Log::info("Solving " + std::to_string(COUNT) + " images on " + std::to_string(THREADS) + " threads...");
+  auto start = std::chrono::steady_clock::now();
+  size_t saved = 0;
+
+  /// Save every image on this thread while the workers solve the next ones
+
+  auto save = [&compositor, &saved](size_t index, const wfc::Solver* result) {
+    if (!result) {
+      wfc::Log::warn("No solution found for seed " + std::to_string(SEED_START + index));
+      return;
+    }
+    if (!compositor) {
+      return;
+    }
+
+    std::string path = format_output_path(index);
+    if (fs::exists(path)) {
+      wfc::Log::warn("Image file " + path + " already exists");
+      return;
+    }
+
+    try {
+      compositor->save_image(*result, path, 1, OUTPUT_LEVEL);
+      ++saved;
+    }
+    catch (const std::runtime_error& err) {
+      wfc::Log::error(err.what());
+    }
+  };
+
+  wfc::Batch batch(*p_solver, THREADS);
+  size_t solved = batch.run(SEED_START, COUNT, MAX_RESTARTS > 0 ? MAX_RESTARTS + 1 : 0, save);
+
+  auto elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start);
+  wfc::Log::info("Solved " + std::to_string(solved) + " of " + std::to_string(COUNT) + " images in " +
+                 std::to_string(elapsed.count()) + " ms");
+
+  if (compositor && saved != solved) {
+    return 1;
+  }
+
+  return solved == COUNT ? 0 : EXIT_UNSOLVED;
+}
+
+/*
+ * Compile a config into a ruleset file, the arguments follow the "compile" command
+ *
+ * Params:
+ *       int    argc: Number of arguments, the first being "compile"
+ *       char** argv: Arguments
+ *
+ * Returns:
+ *        Exit status of the process
+ */
+int run_compile(int argc, char* argv[]) {
+  std::string output = "";
+
+  int opt;
+  while ((opt = getopt(argc, argv, "o:")) != -1) {
+    if (opt == 'o') {
+      output = optarg;
+    }
+    else {
+      wfc::Log::info(USAGE);
+      return 1;
+    }
+  }
+
+  if (optind >= argc) {
+    wfc::Log::error("Missing path to config file");
+    wfc::Log::info(USAGE);
+    return 1;
+  }
+
+  /// Write next to the config by default, resolve the output before moving to the config directory
+
+  fs::path config_path(argv[optind]);
+  fs::path output_path = fs::absolute(output != "" ? fs::path(output) : fs::path(config_path).replace_extension(".wfcb"));
+
+  try {
+    wfc::check_config_file(config_path);
+    if (config_path.has_parent_path()) {
+      fs::current_path(config_path.parent_path());
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    wfc::compile_ruleset(config_path.filename(), output_path);
+    auto elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start);
+    wfc::Log::info("Compiled ruleset in " + std::to_string(elapsed.count()) + " ms");
+  }
+  catch (const std::runtime_error& err) {
+    wfc::Log::error(err.what());
+    return 1;
+  }
+
+  return 0;
+}
 
 int main(int argc, char* argv[]) {
   /// Check if sufficient arguments
@@ -25,25 +209,77 @@ int main(int argc, char* argv[]) {
     exit(0);
   }
 
+  /// Compile a config into a ruleset file instead of running it
+
+  if (std::string(argv[1]) == "compile") {
+    return run_compile(argc - 1, argv + 1);
+  }
+
   wfc::Log::info("Parsing arguments and flags...");
 
   /// Parse flags
 
+  const struct option long_options[] = {
+    {"fast", no_argument, nullptr, 'f'},
+    {"threads", required_argument, nullptr, 'j'},
+    {"count", required_argument, nullptr, OPT_COUNT},
+    {"seed-start", required_argument, nullptr, OPT_SEED_START},
+    {"out-pattern", required_argument, nullptr, OPT_OUT_PATTERN},
+    {"lod", required_argument, nullptr, OPT_LOD},
+    {nullptr, 0, nullptr, 0}
+  };
+
   int opt;
-  while ((opt = getopt(argc, argv, "s:t:o:")) != -1) {
+  while ((opt = getopt_long(argc, argv, "s:t:b:m:r:j:fo:", long_options, nullptr)) != -1) {
     switch (opt) {
       case 's':
-        SEED = std::atoi(optarg);
+        SEED = std::atoll(optarg);
         break;
 
       case 't':
         COLLAPSE_INTERVAL = std::atoi(optarg);
         break;
 
+      case 'b':
+        BACKTRACK_BUDGET = std::atoi(optarg);
+        break;
+
+      case 'm':
+        REPAIR_RADIUS = std::atoi(optarg);
+        break;
+
+      case 'r':
+        MAX_RESTARTS = std::atoi(optarg);
+        break;
+
+      case 'f':
+        FAST = true;
+        break;
+
+      case 'j':
+        THREADS = std::max(1, std::atoi(optarg));
+        break;
+
       case 'o':
         OUTPUT_IMAGE_PATH = optarg;
         break;
 
+      case OPT_COUNT:
+        COUNT = std::atoll(optarg);
+        break;
+
+      case OPT_SEED_START:
+        SEED_START = std::strtoull(optarg, nullptr, 10);
+        break;
+
+      case OPT_OUT_PATTERN:
+        OUTPUT_PATTERN = optarg;
+        break;
+
+      case OPT_LOD:
+        OUTPUT_LEVEL = std::max(0, std::atoi(optarg));
+        break;
+
       default:
         wfc::Log::error(USAGE);
         exit(1);
@@ -52,6 +288,11 @@ int main(int argc, char* argv[]) {
 
   /// Parse arguments
 
+  if (optind >= argc) {
+    wfc::Log::error(USAGE);
+    exit(1);
+  }
+
   if (OUTPUT_IMAGE_PATH != "" && !fs::exists(fs::absolute(OUTPUT_IMAGE_PATH).parent_path())) {
     std::stringstream msg;
     msg << "Path to image does not exist";
@@ -59,7 +300,9 @@ int main(int argc, char* argv[]) {
     exit(1);
   }
 
-  OUTPUT_IMAGE_PATH = fs::absolute(OUTPUT_IMAGE_PATH);
+  if (OUTPUT_IMAGE_PATH != "") {
+    OUTPUT_IMAGE_PATH = fs::absolute(OUTPUT_IMAGE_PATH);
+  }
 
   if (OUTPUT_IMAGE_PATH != "" && fs::exists(OUTPUT_IMAGE_PATH)) {
     std::stringstream msg;
@@ -68,13 +311,38 @@ int main(int argc, char* argv[]) {
     exit(1);
   }
 
-  if (OUTPUT_IMAGE_PATH != "" && fs::path(OUTPUT_IMAGE_PATH).extension() != ".png") {
-    wfc::Log::error("Output file must be a png");
+  if (OUTPUT_IMAGE_PATH != "" && !is_image_path(OUTPUT_IMAGE_PATH)) {
+    wfc::Log::error("Output file must be a png or ppm");
+    exit(1);
+  }
+
+  if (OUTPUT_PATTERN != "") {
+    if (!std::regex_match(OUTPUT_PATTERN, std::regex("[^%]*%0?[0-9]*d[^%]*"))) {
+      wfc::Log::error("Output pattern must contain exactly one %d, %Nd or %0Nd");
+      exit(1);
+    }
+
+    OUTPUT_PATTERN = fs::absolute(OUTPUT_PATTERN);
+    if (!fs::exists(fs::path(OUTPUT_PATTERN).parent_path())) {
+      wfc::Log::error("Path to output pattern does not exist");
+      exit(1);
+    }
+
+    if (!is_image_path(OUTPUT_PATTERN)) {
+      wfc::Log::error("Output pattern must end in .png or .ppm");
+      exit(1);
+    }
+  }
+
+  if (COUNT == 0 && OUTPUT_PATTERN != "") {
+    wfc::Log::error("--out-pattern needs --count");
     exit(1);
   }
 
   try {
-    wfc::check_config_file(argv[optind]);
+    if (fs::path(argv[optind]).extension() != ".wfcb") {
+      wfc::check_config_file(argv[optind]);
+    }
   }
   catch (const std::runtime_error& err) {
     wfc::Log::error(err.what());
@@ -82,29 +350,95 @@ int main(int argc, char* argv[]) {
   }
 
   fs::path config_path(argv[optind]);
-  fs::current_path(config_path.parent_path());
+  if (config_path.has_parent_path()) {
+    fs::current_path(config_path.parent_path());
+  }
   fs::path config_file = config_path.filename();
 
-  /// Set seed for random number generator
+  /// Create solver, then initialize SDL and create canvas to show it
 
-  if (SEED > 0) {
-    wfc::Random::seed(SEED);
+  wfc::CanvasInfo canvas_info;
+  wfc::Solver* solver;
+  wfc::Canvas* canvas;
+  try {
+    solver = wfc::init(config_file, canvas_info);
+  }
+  catch (const std::runtime_error& err) {
+    wfc::Log::error(err.what());
+    exit(1);
   }
 
-  /// Initialize SDL and create canvas
+  solver->set_backtrack_budget(BACKTRACK_BUDGET);
+  solver->set_repair_radius(REPAIR_RADIUS);
+
+  /// Set seed for random number generator and start over so the whole run uses it
+
+  if (SEED >= 0) {
+    solver->set_seed(SEED);
+    solver->reset();
+  }
+
+  /// In batch mode solve many images without rendering the window
+
+  if (COUNT > 0) {
+    int status = run_batch(solver);
+    wfc::free(solver);
+    return status;
+  }
+
+  /// In fast mode solve without a window, composing the result on the CPU
+
+  if (FAST) {
+
+    /// Pick a seed to log when none was given so the result can be reproduced
+
+    if (SEED < 0) {
+      std::random_device device;
+      SEED = device() & INT32_MAX;
+    }
+
+    wfc::Log::info("Solving with seed " + std::to_string(SEED) + " on " + std::to_string(THREADS) + " threads...");
+    auto start = std::chrono::steady_clock::now();
+    wfc::Portfolio portfolio(*solver, THREADS);
+    bool solved = portfolio.solve(SEED, MAX_RESTARTS > 0 ? MAX_RESTARTS + 1 : 0);
+    auto elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start);
+
+    if (!solved) {
+      wfc::Log::error("No solution found after " + std::to_string(MAX_RESTARTS) + " restarts");
+      wfc::free(solver);
+      return EXIT_UNSOLVED;
+    }
+    wfc::Log::info("Solved attempt " + std::to_string(portfolio.get_attempt()) + " in " + std::to_string(elapsed.count()) + " ms");
+
+    if (OUTPUT_IMAGE_PATH != "") {
+      try {
+        wfc::Compositor compositor(solver->get_tiles());
+        compositor.save_image(portfolio.get_result(), OUTPUT_IMAGE_PATH, THREADS, OUTPUT_LEVEL);
+      }
+      catch (const std::runtime_error& err) {
+        wfc::Log::error(err.what());
+        wfc::free(solver);
+        exit(1);
+      }
+    }
+
+    wfc::free(solver);
+    return 0;
+  }
 
-  wfc::Canvas* canvas;
   try {
-    canvas = wfc::init(config_file);
+    canvas = wfc::init_canvas(canvas_info, solver);
   }
   catch (const std::runtime_error& err) {
     wfc::Log::error(err.what());
+    wfc::free(solver);
     exit(1);
   }
 
-  /// Start app loop
+  /// Start solving on a worker thread, then start app loop
 
-  Uint32 last_collapse_time = SDL_GetTicks();
+  wfc::SolverThread worker(solver, COLLAPSE_INTERVAL);
+  const std::vector<uint32_t> no_changes;
   bool running = true;
   wfc::Log::info("Starging app loop...");
 
@@ -112,21 +446,13 @@ int main(int argc, char* argv[]) {
     /// Pre-frame actions
 
     Uint32 frame_start = SDL_GetTicks();
-    wfc::poll_events(running, canvas);
-
-    /// Check if it is time to collapse tile
-
-    Uint32 current_time = SDL_GetTicks();
-    if (current_time - last_collapse_time >= COLLAPSE_INTERVAL) {
-      if (!canvas->collapse_next()) {
-        canvas->reset();
-      }
-      last_collapse_time = current_time;
-    }
+    wfc::poll_events(running, &worker, canvas);
 
-    /// Render frame
+    /// Render the newest snapshot of the solver, redrawing the spots changed since the last one
 
-    canvas->render();
+    bool changed = worker.update();
+    const wfc::Snapshot& snapshot = worker.get_snapshot();
+    canvas->render(snapshot.tiles, changed ? snapshot.dirty : no_changes);
 
     /// Post-frame actions
 
@@ -136,15 +462,31 @@ int main(int argc, char* argv[]) {
     }
   }
 
+  /// Stop the worker so the solver can be saved
+
+  try {
+    worker.stop();
+  }
+  catch (const std::runtime_error& err) {
+    wfc::Log::error(err.what());
+  }
+
   if (OUTPUT_IMAGE_PATH != "") {
-    canvas->save_image(OUTPUT_IMAGE_PATH);
+    try {
+      wfc::Compositor compositor(solver->get_tiles());
+      compositor.save_image(*solver, OUTPUT_IMAGE_PATH, 1, OUTPUT_LEVEL);
+    }
+    catch (const std::runtime_error& err) {
+      wfc::Log::error(err.what());
+    }
   }
 
   wfc::Log::info("Shutting down app...");
 
-  /// Free canvas and deinitialize SDL
+  /// Free canvas, deinitialize SDL and free solver
 
   wfc::free(canvas);
+  wfc::free(solver);
 
   return 0;
 }
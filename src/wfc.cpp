@@ -1,12 +1,154 @@
 #include "wfc.h"
+#include "wfc_canvas.h"
+#include "wfc_solver_thread.h"
 #include "wfc_sdl_utils.h"
 #include "wfc_parser.h"
+#include "wfc_overlapping.h"
+#include "wfc_edge_rules.h"
+#include "wfc_symmetry.h"
+#include "wfc_ruleset.h"
 #include "wfc_log.h"
 
+#include <algorithm>
+#include <cmath>
+#include <memory>
 #include <sstream>
+#include <thread>
+
+#include <SDL2/SDL.h>
 
 namespace fs = std::filesystem;
 
+const float PAN_STEP = 64;     /// Distance the view moves per key press in pixels
+const float ZOOM_STEP = 1.25;  /// Factor the view zooms by per key press or wheel step
+
+/*
+ * Learn the patterns of the sample image and add them to the solver, see wfc::add_patterns
+ *
+ * Params:
+ *       Solver*       p_solver     : Solver to add the tiles to
+ *       SampleInfo    p_sample_info: Parsed sample config
+ *       DirectionType p_dir_type   : Directions to add rules for
+ *
+ * Throws:
+ *       If the sample can not be loaded
+ */
+void learn_sample(wfc::Solver* p_solver, const wfc::SampleInfo& p_sample_info, wfc::DirectionType p_dir_type) {
+
+  /// Load the sample as RGBA32 pixels
+
+  wfc::Log::info("Loading sample at " + p_sample_info.path + "...");
+  SDL_Surface* surface = wfc::load_image(p_sample_info.path);
+
+  /// Learn the patterns on every core
+
+  wfc::Log::info("Learning " + std::to_string(p_sample_info.size) + "x" + std::to_string(p_sample_info.size) +
+                 " patterns from sample...");
+  std::unique_ptr<wfc::OverlappingModel> model;
+  try {
+    model = std::make_unique<wfc::OverlappingModel>(static_cast<const uint8_t*>(surface->pixels), surface->w,
+                                                    surface->h, surface->pitch, p_sample_info.size,
+                                                    p_sample_info.symmetry, p_sample_info.periodic, p_dir_type,
+                                                    std::thread::hardware_concurrency());
+  }
+  catch (...) {
+    SDL_FreeSurface(surface);
+    throw;
+  }
+  SDL_FreeSurface(surface);
+
+  wfc::Log::info("Adding " + std::to_string(model->get_pattern_count()) + " patterns to solver...");
+  wfc::add_patterns(p_solver, *model, p_dir_type);
+}
+
+/*
+ * Infer the rules of the tiles that asked for it from the edges of all tile images, see
+ * wfc::add_edge_rules
+ *
+ * Params:
+ *       Solver*          p_solver   : Solver the tiles were added to
+ *       Vector<TileInfo> p_tiles    : Parsed tiles, in the order they were added
+ *       size_t           p_tolerance: Largest difference of a colour channel between facing edge pixels
+ *
+ * Throws:
+ *       If a tile image can not be loaded
+ */
+void match_tile_edges(wfc::Solver* p_solver, const std::vector<wfc::TileInfo>& p_tiles, size_t p_tolerance) {
+
+  /// Load every tile image, since any tile can be next to a tile with inferred rules. Variants of
+  /// a tile decode its file once and match the edges of the turned or mirrored pixels
+
+  wfc::EdgeRules edge_rules(p_tolerance);
+  wfc::ImageCache images;
+  for (const wfc::TileInfo& tile : p_tiles) {
+    SDL_Surface* surface = images.get(tile.path);
+    const uint8_t* pixels = static_cast<const uint8_t*>(surface->pixels);
+    if (tile.transform == 0) {
+      edge_rules.add_tile(pixels, surface->w, surface->h, surface->pitch);
+      continue;
+    }
+
+    size_t width, height;
+    std::vector<uint8_t> transformed = wfc::transform_image(pixels, surface->w, surface->h, surface->pitch,
+                                                            tile.transform, width, height);
+    edge_rules.add_tile(transformed.data(), width, height, width * 4);
+  }
+
+  wfc::Log::info("Matching the edges of " + std::to_string(p_tiles.size()) + " tiles...");
+  edge_rules.compile(std::thread::hardware_concurrency());
+  wfc::add_edge_rules(p_solver, edge_rules, p_tiles);
+}
+
+void wfc::add_patterns(wfc::Solver* p_solver, const wfc::OverlappingModel& p_model, wfc::DirectionType p_dir_type) {
+
+  /// Add one tile per pattern, weighted by how often it appears
+
+  size_t pattern_count = p_model.get_pattern_count();
+  std::vector<uint32_t> ids(pattern_count);
+  for (size_t p = 0; p < pattern_count; ++p) {
+    const uint8_t* pixel = reinterpret_cast<const uint8_t*>(p_model.get_pattern(p));
+    ids[p] = p_solver->add_tile("pattern_" + std::to_string(p), std::vector<uint8_t>(pixel, pixel + 4), 1, 1,
+                                p_model.get_weight(p));
+  }
+
+  /// The rules of every side are closed, so a pattern that nothing overlaps in a direction allows
+  /// no tile there instead of every tile
+
+  size_t dir_step = (p_dir_type == wfc::DirectionType::OCT_DIRECTIONS) ? 1 : 2;
+  for (size_t p = 0; p < pattern_count; ++p) {
+    for (size_t d = 0; d < wfc::DIRECTION_COUNT; d += dir_step) {
+      wfc::Directions dir = static_cast<wfc::Directions>(d);
+      p_solver->close_rules(ids[p], dir);
+      const uint32_t* others = p_model.get_compatible(p, dir);
+      for (size_t i = 0; i < p_model.get_compatible_count(p, dir); ++i) {
+        p_solver->add_rule(ids[p], dir, ids[others[i]]);
+      }
+    }
+  }
+}
+
+void wfc::add_edge_rules(wfc::Solver* p_solver, const wfc::EdgeRules& p_edge_rules,
+                         const std::vector<wfc::TileInfo>& p_tiles) {
+
+  /// The sides of tiles with inferred rules are closed, so an edge that matches nothing allows no
+  /// tile instead of every tile. Diagonals are left without rules
+
+  for (size_t t = 0; t < p_tiles.size(); ++t) {
+    if (!p_tiles[t].auto_rules) {
+      continue;
+    }
+
+    for (size_t d = 0; d < wfc::DIRECTION_COUNT; d += 2) {
+      wfc::Directions dir = static_cast<wfc::Directions>(d);
+      p_solver->close_rules(p_tiles[t].id, dir);
+      const uint32_t* others = p_edge_rules.get_compatible(t, dir);
+      for (size_t i = 0; i < p_edge_rules.get_compatible_count(t, dir); ++i) {
+        p_solver->add_rule(p_tiles[t].id, dir, p_tiles[others[i]].id);
+      }
+    }
+  }
+}
+
 void wfc::check_config_file(const fs::path& p_config_path) {
 
   /// Check if the path exists
@@ -28,54 +170,88 @@ void wfc::check_config_file(const fs::path& p_config_path) {
   }
 }
 
-wfc::Canvas* wfc::init(const std::string& p_config_path) {
-  wfc::Log::info("Initializing SDL...");
-  wfc::init_sdl();
+wfc::Solver* wfc::init(const std::string& p_config_path, wfc::CanvasInfo& p_canvas_info) {
+
+  /// Ruleset files hold everything parsing and compiling the config would give
+
+  if (fs::path(p_config_path).extension() == ".wfcb") {
+    wfc::Log::info("Loading ruleset at " + p_config_path + "...");
+    return wfc::load_ruleset(p_config_path, p_canvas_info);
+  }
 
   wfc::Log::info("Initializing parser... ");
   wfc::Parser parser(p_config_path);
 
   wfc::Log::info("Parsing canvas config at " + p_config_path + "...");
-  wfc::CanvasInfo canvas_info;
-  parser.parse_canvas(canvas_info);
-  wfc::Canvas* canvas = new wfc::Canvas(
-    canvas_info.width,
-    canvas_info.height,
-    canvas_info.rows,
-    canvas_info.columns
-  );
-  canvas->set_direction_type(canvas_info.direction_type);
-
-  wfc::Log::info("Parsing groups config at " + p_config_path + "...");
-  wfc::GroupInfo group_info;
-  parser.parse_groups(group_info);
-
-  wfc::Log::info("Parsing tiles config at " + p_config_path + "...");
-  std::vector<wfc::TileInfo> tiles;
-  parser.parse_tiles(tiles, group_info);
-
-  wfc::Log::info("Adding parsed tiles to canvas...");
-  for (wfc::TileInfo tile: tiles) {
-    canvas->add_tile(tile.name, tile.path);
+  parser.parse_canvas(p_canvas_info);
+  wfc::Solver* solver = new wfc::Solver(p_canvas_info.rows, p_canvas_info.columns);
+  solver->set_direction_type(p_canvas_info.direction_type);
+
+  if (parser.has_sample()) { /// Learn the tiles and rules from a sample image
+
+    wfc::Log::info("Parsing sample config at " + p_config_path + "...");
+    wfc::SampleInfo sample_info;
+    parser.parse_sample(sample_info);
+    learn_sample(solver, sample_info, p_canvas_info.direction_type);
   }
+  else {
+    wfc::Log::info("Parsing groups config at " + p_config_path + "...");
+    wfc::GroupInfo group_info;
+    parser.parse_groups(group_info);
 
-  wfc::Log::info("Adding parsed rules to tiles...");
-  for (wfc::TileInfo tile: tiles) {
-    for (auto& item: tile.rules) {
-      for (auto& t: item.second) {
-        canvas->add_rule(tile.name, item.first, t);
+    wfc::Log::info("Parsing tiles config at " + p_config_path + "...");
+    std::vector<wfc::TileInfo> tiles;
+    wfc::TileRegistry registry;
+    parser.parse_tiles(tiles, group_info, registry);
+
+    /// The tiles are added in the order of their parsed ids together with the names the parser
+    /// interned, so the solver gives them the same ids without interning the names again
+
+    wfc::Log::info("Adding parsed tiles to solver...");
+    std::vector<wfc::Tile> solver_tiles;
+    solver_tiles.reserve(tiles.size());
+    for (const wfc::TileInfo& tile: tiles) {
+      solver_tiles.emplace_back(fs::absolute(tile.path).string(), tile.transform);
+      solver_tiles.back().set_weight(tile.weight);
+    }
+    solver->add_tiles(std::move(registry), std::move(solver_tiles));
+
+    wfc::Log::info("Adding parsed rules to tiles...");
+    for (const wfc::TileInfo& tile: tiles) {
+      for (const auto& [dir, ids]: tile.rules) {
+        for (uint32_t id: ids) {
+          solver->add_rule(tile.id, dir, id);
+        }
+      }
+    }
+
+    wfc::Log::info("Adding parsed sockets to tiles...");
+    for (const wfc::TileInfo& tile: tiles) {
+      for (const auto& [dir, socket]: tile.sockets) {
+        solver->add_socket(tile.id, dir, socket);
       }
     }
+
+    bool auto_rules = std::any_of(tiles.begin(), tiles.end(), [](const wfc::TileInfo& tile) {
+      return tile.auto_rules;
+    });
+    if (auto_rules) {
+      wfc::Log::info("Inferring rules from tile edges...");
+      match_tile_edges(solver, tiles, p_canvas_info.edge_tolerance);
+    }
   }
 
+  wfc::Log::info("Compiling rules...");
+  solver->compile_rules();
+
   wfc::Log::info("Parsing constraints at " + p_config_path + "...");
   wfc::ConstraintInfo constraints;
   parser.parse_constraints(constraints);
 
-  wfc::Log::info("Adding constraints to canvas...");
-  auto add_constraint = [canvas](wfc::Constraints dir, const std::unordered_set<std::string>& set){
+  wfc::Log::info("Adding constraints to solver...");
+  auto add_constraint = [solver](wfc::Constraints dir, const std::unordered_set<std::string>& set){
     for (auto& tile : set) {
-      canvas->add_constraint(dir, tile);
+      solver->add_constraint(dir, tile);
     }
   };
 
@@ -90,27 +266,120 @@ wfc::Canvas* wfc::init(const std::string& p_config_path) {
 
   for (auto& fixed : constraints.fixed) {
     for (const std::string& tile : fixed.tiles) {
-      canvas->add_constraint(fixed.row, fixed.column, tile);
+      solver->add_constraint(fixed.row, fixed.column, tile);
     }
   }
 
-  wfc::Log::info("Clearing canvas buffer...");
-  canvas->reset();
+  wfc::Log::info("Clearing solver buffer...");
+  solver->reset();
+
+  return solver;
+}
+
+void wfc::compile_ruleset(const std::string& p_config_path, const fs::path& p_output) {
+  wfc::CanvasInfo canvas_info;
+  std::unique_ptr<wfc::Solver> solver(wfc::init(p_config_path, canvas_info));
+
+  /// The solver keeps its constraints as tiles, read the names from the config again
+
+  wfc::Parser parser(p_config_path);
+  wfc::ConstraintInfo constraints;
+  parser.parse_constraints(constraints);
+
+  wfc::Log::info("Writing ruleset to " + p_output.string() + "...");
+  wfc::save_ruleset(p_output, canvas_info, *solver, constraints);
+}
+
+wfc::Canvas* wfc::init_canvas(const wfc::CanvasInfo& p_canvas_info, const wfc::Solver* p_solver) {
+  wfc::Log::info("Initializing SDL...");
+  wfc::init_sdl();
 
-  return canvas;
+  wfc::Log::info("Creating canvas...");
+  try {
+    return new wfc::Canvas(p_canvas_info.width, p_canvas_info.height, p_solver);
+  }
+  catch (...) {
+    wfc::free_sdl();
+    throw;
+  }
 }
 
-void wfc::poll_events(bool& p_running, wfc::Canvas* canvas) {
+void wfc::poll_events(bool& p_running, wfc::SolverThread* solver, wfc::Canvas* canvas) {
   SDL_Event e;
   while (SDL_PollEvent(&e)) {
     if (e.type == SDL_QUIT) {
       p_running = false;
     }
     else if (e.type == SDL_KEYDOWN) {
-      if (e.key.keysym.sym == SDLK_r) {
-        canvas->reset();
+      float center_x = canvas->get_width() / 2.0f;
+      float center_y = canvas->get_height() / 2.0f;
+
+      switch (e.key.keysym.sym) {
+        case SDLK_r:
+          solver->reset();
+          break;
+
+        /// Pan with the arrow keys or WASD, zoom around the center with + and -
+
+        case SDLK_LEFT:
+        case SDLK_a:
+          canvas->pan(PAN_STEP, 0);
+          break;
+
+        case SDLK_RIGHT:
+        case SDLK_d:
+          canvas->pan(-PAN_STEP, 0);
+          break;
+
+        case SDLK_UP:
+        case SDLK_w:
+          canvas->pan(0, PAN_STEP);
+          break;
+
+        case SDLK_DOWN:
+        case SDLK_s:
+          canvas->pan(0, -PAN_STEP);
+          break;
+
+        case SDLK_EQUALS:
+        case SDLK_PLUS:
+        case SDLK_KP_PLUS:
+          canvas->zoom(ZOOM_STEP, center_x, center_y);
+          break;
+
+        case SDLK_MINUS:
+        case SDLK_KP_MINUS:
+          canvas->zoom(1 / ZOOM_STEP, center_x, center_y);
+          break;
+
+        case SDLK_0:
+        case SDLK_HOME:
+          canvas->reset_view();
+          break;
       }
     }
+    else if (e.type == SDL_MOUSEWHEEL) {
+
+      /// Zoom around the mouse
+
+      int x, y;
+      SDL_GetMouseState(&x, &y);
+      canvas->zoom(std::pow(ZOOM_STEP, e.wheel.y), x, y);
+    }
+    else if (e.type == SDL_MOUSEMOTION) {
+
+      /// Drag the grid with the left or middle mouse button
+
+      if (e.motion.state & (SDL_BUTTON_LMASK | SDL_BUTTON(SDL_BUTTON_MIDDLE))) {
+        canvas->pan(e.motion.xrel, e.motion.yrel);
+      }
+    }
+    else if (e.type == SDL_RENDER_TARGETS_RESET) {
+      canvas->redraw();
+    }
+    else if (e.type == SDL_RENDER_DEVICE_RESET) { /// Every texture is gone with the device
+      canvas->recreate_textures();
+    }
   }
 }
 
@@ -118,3 +387,7 @@ void wfc::free(wfc::Canvas* canvas) {
   delete canvas;
   wfc::free_sdl();
 }
+
+void wfc::free(wfc::Solver* solver) {
+  delete solver;
+}
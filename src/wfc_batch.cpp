@@ -0,0 +1,138 @@
+#include "wfc_batch.h"
+#include "wfc_random.h"
+
+#include <thread>
+
+wfc::Batch::Batch(const wfc::Solver& p_solver, size_t p_threads) :
+  next_index__(0) {
+
+  /// Compile the rules once before copying, the copies only read the shared tiles
+
+  wfc::Solver compiled(p_solver);
+  compiled.compile_rules();
+
+  size_t threads = p_threads > 0 ? p_threads : 1;
+  slots__.resize(threads);
+  for (std::vector<Slot>& worker : slots__) {
+    worker.reserve(2);
+    worker.push_back({compiled, false});
+    worker.push_back({compiled, false});
+  }
+}
+
+size_t wfc::Batch::run(uint64_t p_seed_start, size_t p_count, size_t p_max_attempts, const Consumer& p_consume) {
+  next_index__ = 0;
+  results__.clear();
+  for (std::vector<Slot>& worker : slots__) {
+    for (Slot& slot : worker) {
+      slot.busy = false;
+    }
+  }
+
+  std::vector<std::thread> threads;
+  for (size_t w = 0; w < slots__.size(); ++w) {
+    threads.emplace_back(&wfc::Batch::work__, this, w, p_seed_start, p_count, p_max_attempts);
+  }
+
+  /// Consume the results as they arrive and hand their solvers back to the workers
+
+  size_t solved = 0;
+  try {
+    for (size_t consumed = 0; consumed < p_count; ++consumed) {
+      Result result;
+      {
+        std::unique_lock<std::mutex> lock(mutex__);
+        ready__.wait(lock, [this]() { return !results__.empty(); });
+        result = results__.front();
+        results__.pop_front();
+      }
+
+      p_consume(result.index, result.solved ? &result.slot->solver : nullptr);
+      solved += result.solved ? 1 : 0;
+
+      {
+        std::lock_guard<std::mutex> lock(mutex__);
+        result.slot->busy = false;
+      }
+      released__.notify_all();
+    }
+  }
+  catch (...) {
+
+    /// Let the workers run out of instances before passing the error on
+
+    next_index__ = p_count;
+    {
+      std::lock_guard<std::mutex> lock(mutex__);
+      for (std::vector<Slot>& worker : slots__) {
+        for (Slot& slot : worker) {
+          slot.busy = false;
+        }
+      }
+    }
+    released__.notify_all();
+
+    for (std::thread& thread : threads) {
+      thread.join();
+    }
+    throw;
+  }
+
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+
+  return solved;
+}
+
+void wfc::Batch::work__(size_t p_worker, uint64_t p_seed_start, size_t p_count, size_t p_max_attempts) {
+  std::vector<Slot>& worker = slots__[p_worker];
+
+  while (true) {
+    size_t index = next_index__.fetch_add(1);
+    if (index >= p_count) {
+      return;
+    }
+
+    /// Wait until the consumer gave back one of the solvers of this worker
+
+    Slot* slot;
+    {
+      std::unique_lock<std::mutex> lock(mutex__);
+      released__.wait(lock, [&worker]() { return !worker[0].busy || !worker[1].busy; });
+      slot = worker[0].busy ? &worker[1] : &worker[0];
+      slot->busy = true;
+    }
+
+    bool solved = solve__(slot->solver, p_seed_start + index, p_max_attempts);
+
+    {
+      std::lock_guard<std::mutex> lock(mutex__);
+      results__.push_back({index, slot, solved});
+    }
+    ready__.notify_one();
+  }
+}
+
+bool wfc::Batch::solve__(wfc::Solver& p_solver, uint64_t p_seed, size_t p_max_attempts) {
+
+  /// Attempt a uses the stream of the seed jumped a times, the same as wfc::Portfolio
+
+  wfc::Random stream(p_seed);
+  for (size_t attempt = 0; p_max_attempts == 0 || attempt < p_max_attempts; ++attempt) {
+    if (attempt > 0) {
+      stream.jump();
+    }
+
+    p_solver.set_random(stream);
+    p_solver.reset();
+    while (!p_solver.is_collapsed() && p_solver.collapse_next()) {
+    }
+
+    if (p_solver.is_collapsed()) {
+      return true;
+    }
+  }
+
+  return false;
+}
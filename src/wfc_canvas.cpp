@@ -1,27 +1,37 @@
 #include "wfc_canvas.h"
-#include "wfc_utils.h"
-#include "wfc_random.h"
-#include "wfc_log.h"
 
+#include <algorithm>
+#include <cmath>
+#include <cstring>
 #include <sstream>
 #include <stdexcept>
-#include <filesystem>
 #include <vector>
-#include <algorithm>
-#include <iostream>
 
-#include <SDL2/SDL_image.h>
+namespace {
 
-namespace fs = std::filesystem;
+/// Size in pixels below which spots are drawn as the average colour of their tile
+const float LOD_SPOT_SIZE = 4;
 
-wfc::Canvas::Canvas(size_t p_width, size_t p_height, size_t p_rows, size_t p_columns) :
+}
+
+wfc::Canvas::Canvas(size_t p_width, size_t p_height, const wfc::Solver* p_solver) :
   width__(p_width),
   height__(p_height),
-  rows__(p_rows),
-  columns__(p_columns),
-  tile_width__(width__ / rows__),
-  tile_height__(height__ / columns__),
-  direction_type__(DirectionType::QUAD_DIRECTIONS) {
+  solver__(p_solver),
+  base_width__(static_cast<float>(width__) / p_solver->get_columns()),
+  base_height__(static_cast<float>(height__) / p_solver->get_rows()),
+  min_zoom__(1.0f),
+  max_zoom__(std::max(min_zoom__, std::min(width__, height__) / (2.0f * std::min(base_width__, base_height__)))),
+  zoom__(min_zoom__),
+  offset_x__(0),
+  offset_y__(0),
+  window__(nullptr),
+  renderer__(nullptr),
+  compositor__(p_solver->get_tiles()),
+  atlas__(nullptr),
+  colours_texture__(nullptr),
+  frame__(nullptr),
+  redraw__(true) {
 
   /// Create SDL window and renderer for the canvas
 
@@ -39,447 +49,375 @@ wfc::Canvas::Canvas(size_t p_width, size_t p_height, size_t p_rows, size_t p_col
   renderer__ = SDL_CreateRenderer(window__, -1, SDL_RENDERER_ACCELERATED);
 
   if (!renderer__) {
+    SDL_DestroyWindow(window__);
     throw std::runtime_error("SDL Renderer creation failed.\n");
   }
 
-  /// Initialize canvas values
+  /// Create the frame texture and the atlas of the tiles known to the solver
 
-  create_null_texture__();
-  buffer__.resize(rows__ * columns__);
+  try {
+    create_textures__();
+  }
+  catch (...) {
+    free_textures__();
+    SDL_DestroyRenderer(renderer__);
+    SDL_DestroyWindow(window__);
+    throw;
+  }
 }
 
 wfc::Canvas::~Canvas() {
 
-  /// Free all tiles in the canvas
-
-  for (auto& item : tiles__) {
-    delete item.second;
-  }
-
   /// Deinitialize SDL and canvas values
 
-  buffer__.clear();
+  free_textures__();
   SDL_DestroyRenderer(renderer__);
   SDL_DestroyWindow(window__);
 }
 
-void wfc::Canvas::set_direction_type(const wfc::DirectionType p_dir_type) {
-  direction_type__ = p_dir_type;
-}
+void wfc::Canvas::render(const std::vector<uint32_t>& p_tiles, const std::vector<uint32_t>& p_dirty) {
 
-void wfc::Canvas::add_tile(const std::string& p_name, const std::string& p_path) {
+  /// Draw into the frame texture, clearing it first after a redraw request
 
-  /// Check if tile is already known to the canvas
+  SDL_SetRenderTarget(renderer__, frame__);
 
-  if (tiles__.find(p_name) != tiles__.end()) {
-    std::stringstream msg;
-    msg << "Tile with name " << p_name << " already exists";
-    throw std::runtime_error(msg.str());
+  if (redraw__) {
+    SDL_SetRenderDrawColor(renderer__, 0, 0, 0, 255);
+    SDL_RenderClear(renderer__);
   }
 
-  /// Add tile to the canvas
-
-  fs::path abs_path = fs::absolute(p_path);
-  tiles__[p_name] = new wfc::Tile(abs_path, renderer__);
-}
-
-void wfc::Canvas::add_rule(const std::string& p_for, wfc::Directions p_dir, const std::string& p_to) {
+  /// Draw tiles while spots are large enough to show them, else only their average colours
 
-  /// Check if the source tile is not known to the canvas
-
-  if (tiles__.find(p_for) == tiles__.end()) {
-    std::stringstream msg;
-    msg << "Tile with name " << p_for << " does not exist";
-    throw std::runtime_error(msg.str());
+  View view = get_view__();
+  if (view.spot_width < LOD_SPOT_SIZE || view.spot_height < LOD_SPOT_SIZE) {
+    draw_colours__(p_tiles, p_dirty, view);
   }
-
-  /// Check if the destination tile is not known to the canvas
-
-  if (tiles__.find(p_to) == tiles__.end()) {
-    std::stringstream msg;
-    msg << "Tile with name " << p_to << " does not exists";
-    throw std::runtime_error(msg.str());
+  else {
+    draw_quads__(p_tiles, p_dirty, view);
   }
+  redraw__ = false;
 
-  /// Add rule to the tile
+  /// Copy the frame to the window and present it
 
-  tiles__[p_for]->add_rule(p_dir, tiles__[p_to]);
+  SDL_SetRenderTarget(renderer__, nullptr);
+  SDL_RenderCopy(renderer__, frame__, nullptr, nullptr);
+  SDL_RenderPresent(renderer__);
 }
 
-void wfc::Canvas::add_constraint(wfc::Constraints p_cons, const std::string& p_tile) {
-
-  /// Check if the source tile is not known to the canvas
-
-  if (tiles__.find(p_tile) == tiles__.end()) {
-    std::stringstream msg;
-    msg << "Tile with name " << p_tile << " does not exist";
-    throw std::runtime_error(msg.str());
-  }
-
-  /// Add the constraint to the canvas
-
-  constraints__.others[p_cons].insert(tiles__[p_tile]);
+void wfc::Canvas::redraw() {
+  redraw__ = true;
 }
 
-void wfc::Canvas::add_constraint(size_t x, size_t y, const std::string& p_tile) {
-
-  /// Check if the source tile is not known to the canvas
-
-  if (tiles__.find(p_tile) == tiles__.end()) {
-    std::stringstream msg;
-    msg << "Tile with name " << p_tile << " does not exist";
-    throw std::runtime_error(msg.str());
-  }
-
-  /// Check if the coordinate are out of bound
-
-  size_t idx = y * columns__ + x;
-  if (idx >= buffer__.size()) {
-    std::stringstream msg;
-    msg << "Coordinates" << x << ", " << y << " is out of bound";
-    throw std::runtime_error(msg.str());
-  }
-
-  /// Add the constraint to the canvas
-
-  constraints__.fixed[idx].insert(tiles__[p_tile]);
+void wfc::Canvas::recreate_textures() {
+  free_textures__();
+  create_textures__();
+  redraw__ = true;
 }
 
-void wfc::Canvas::add_rule(const std::string& p_for, wfc::Directions p_dir, const std::vector<std::string>& p_to) {
-
-  /// Call add_rule for each tile in the list
-
-  for (const std::string& tile : p_to) {
-    add_rule(p_for, p_dir, tile);
-  }
+void wfc::Canvas::pan(float p_dx, float p_dy) {
+  offset_x__ += p_dx;
+  offset_y__ += p_dy;
+  clamp_view__();
 }
 
-void wfc::Canvas::reset() {
-
-  /// Get list of all possible_tiles
-
-  std::unordered_set<Tile*> possible_tiles;
-  for (const auto& item : tiles__) {
-    possible_tiles.insert(item.second);
-  }
-
-  /// Reset the buffer__
+void wfc::Canvas::zoom(float p_factor, float p_x, float p_y) {
 
-  for (size_t i = 0, e = buffer__.size(); i < e; ++i) {
-    buffer__[i].tile = nullptr;
-    buffer__[i].possible_tiles = possible_tiles;
-  }
-
-  apply_constraints__();
+  /// Scale the distance from the point to the grid origin so the spot under the point stays there
 
-  /// Reset number of tiles collapsed
-
-  collapsed_count__ = 0;
+  float zoom = std::clamp(zoom__ * p_factor, min_zoom__, max_zoom__);
+  offset_x__ = p_x - (p_x - offset_x__) * zoom / zoom__;
+  offset_y__ = p_y - (p_y - offset_y__) * zoom / zoom__;
+  zoom__ = zoom;
+  clamp_view__();
 }
 
-bool wfc::Canvas::collapse_next() {
-  /// Check if uncollapsed tile exists
-
-  if (collapsed_count__ == rows__ * columns__) {
-    return true;
-  }
-
-  /// Collapse the tile with the lowest entropy
-
-  size_t spot_idx = get_lowest_entropy_spot_idx__();
-  wfc::Spot* spot = &buffer__[spot_idx];
-  if (spot->possible_tiles.size() == 0) {
-    return false;
-  }
-
-  /// Select a tile to collapse into
-
-  size_t tile_selection_idx = wfc::Random::int_from_range(0, spot->possible_tiles.size());
-  wfc::Tile* tile = *wfc::select_from(spot->possible_tiles, tile_selection_idx);
+void wfc::Canvas::reset_view() {
+  zoom__ = min_zoom__;
+  offset_x__ = 0;
+  offset_y__ = 0;
+  redraw__ = true;
+}
 
-  // Collapse the tile
+size_t wfc::Canvas::get_width() const {
+  return width__;
+}
 
-  spot->tile = tile;
-  spot->possible_tiles.clear();
-  reduce_entropy_arround__(spot_idx);
-  ++collapsed_count__;
-  return true;
+size_t wfc::Canvas::get_height() const {
+  return height__;
 }
 
-void wfc::Canvas::render() {
+void wfc::Canvas::clamp_view__() {
 
-  /// Clear the window
+  /// A grid larger than the window must cover it, a smaller one must stay inside it
 
-  SDL_RenderClear(renderer__);
+  float grid_width = solver__->get_columns() * base_width__ * zoom__;
+  float grid_height = solver__->get_rows() * base_height__ * zoom__;
+  float slack_x = width__ - grid_width;
+  float slack_y = height__ - grid_height;
 
-  /// Loop through buffer__ and add tiles to the window
+  offset_x__ = std::clamp(offset_x__, std::min(slack_x, 0.0f), std::max(slack_x, 0.0f));
+  offset_y__ = std::clamp(offset_y__, std::min(slack_y, 0.0f), std::max(slack_y, 0.0f));
+  redraw__ = true;
+}
 
-  for (size_t row = 0; row < rows__; ++row) {
-    for (size_t col = 0; col < columns__; ++col) {
-      size_t idx = (row * columns__) + col;
+wfc::Canvas::View wfc::Canvas::get_view__() const {
+  View view;
+  view.spot_width = base_width__ * zoom__;
+  view.spot_height = base_height__ * zoom__;
 
-      /// Calculate the position of the tile in the window
+  view.col_begin = std::max(0.0f, std::floor(-offset_x__ / view.spot_width));
+  view.col_end = std::min<float>(solver__->get_columns(), std::ceil((width__ - offset_x__) / view.spot_width));
+  view.row_begin = std::max(0.0f, std::floor(-offset_y__ / view.spot_height));
+  view.row_end = std::min<float>(solver__->get_rows(), std::ceil((height__ - offset_y__) / view.spot_height));
+  return view;
+}
 
-      SDL_Rect pos_rect = {
-        static_cast<int>((col * tile_width__)),
-        static_cast<int>((row * tile_height__)),
-        static_cast<int>(tile_width__),
-        static_cast<int>(tile_height__)
-      };
+void wfc::Canvas::draw_quads__(const std::vector<uint32_t>& p_tiles, const std::vector<uint32_t>& p_dirty,
+                               const View& p_view) {
+  size_t columns = solver__->get_columns();
 
+  /// Collect the quads of the changed spots in view, or of all spots in view after a redraw request
 
-      /// Check if the tile is collapsed or not
+  vertices__.clear();
+  indices__.clear();
 
-      wfc::Tile* tile = buffer__[idx].tile;
-      SDL_Texture* texture = tile ? tile->get_texture() : null_texture__;
-      SDL_RenderCopy(renderer__, texture, nullptr, &pos_rect);
+  if (redraw__) {
+    for (size_t row = p_view.row_begin; row < p_view.row_end; ++row) {
+      for (size_t col = p_view.col_begin; col < p_view.col_end; ++col) {
+        size_t idx = row * columns + col;
+        add_spot__(idx, p_tiles[idx], p_view);
+      }
     }
   }
-
-  /// Present the window
-
-  SDL_RenderPresent(renderer__);
-}
-
-void wfc::Canvas::save_image(const std::string& p_output) {
-  wfc::Log::info("Saving output image...");
-
-  int width, height;
-  SDL_GetRendererOutputSize(renderer__, &width, &height);
-
-  // Create surface to store pixels
-  SDL_Surface* surface = SDL_CreateRGBSurfaceWithFormat(0, width, height, 32, SDL_PIXELFORMAT_RGBA32);
-  if (!surface) {
-    std::stringstream msg;
-    msg << "Failed to create output surface";
-    throw std::runtime_error(msg.str());
+  else {
+    for (uint32_t idx : p_dirty) {
+      size_t row = idx / columns;
+      size_t col = idx % columns;
+      if (row >= p_view.row_begin && row < p_view.row_end && col >= p_view.col_begin && col < p_view.col_end) {
+        add_spot__(idx, p_tiles[idx], p_view);
+      }
+    }
   }
 
-  // Read pixels from renderer to surface
-  if (SDL_RenderReadPixels(renderer__, nullptr, SDL_PIXELFORMAT_RGBA32, surface->pixels, surface->pitch) != 0) {
-    std::stringstream msg;
-    msg << "Failed to read pixels from surface";
-    SDL_FreeSurface(surface);
-    throw std::runtime_error(msg.str());
-  }
+  /// Draw all quads in one batch
 
-  // Save surface to PNG (can also use BMP, JPG, etc.)
-  if (IMG_SavePNG(surface, p_output.c_str()) != 0) {
-    std::stringstream msg;
-    msg << "Failed to save output image";
-    SDL_FreeSurface(surface);
-    throw std::runtime_error(msg.str());
+  if (!indices__.empty()) {
+    SDL_RenderGeometry(renderer__, atlas__, vertices__.data(), vertices__.size(),
+                       indices__.data(), indices__.size());
   }
-
-  SDL_FreeSurface(surface);
 }
 
-void wfc::Canvas::create_null_texture__() {
-  /// Create a texture to represent uncollapsed tiles
-
-  null_texture__ = SDL_CreateTexture(renderer__, SDL_PIXELFORMAT_RGBA8888,
-                                     SDL_TEXTUREACCESS_TARGET, tile_width__, tile_height__);
-
-  if (!null_texture__) {
-    throw std::runtime_error("Failed to create null texture");
-  }
+void wfc::Canvas::draw_colours__(const std::vector<uint32_t>& p_tiles, const std::vector<uint32_t>& p_dirty,
+                                 const View& p_view) {
+  size_t columns = solver__->get_columns();
+  size_t view_columns = p_view.col_end - p_view.col_begin;
+  size_t view_rows = p_view.row_end - p_view.row_begin;
 
-  /// Store the current render target
+  /// Use a pixel per spot, or sample the spots if there are more of them than pixels
 
-  SDL_Texture* previous_target = SDL_GetRenderTarget(renderer__);
-
-  /// Fill the texture with color black
-
-  SDL_SetRenderTarget(renderer__, null_texture__);
-  SDL_SetRenderDrawColor(renderer__, 0, 0, 0, 0);
-  SDL_RenderClear(renderer__);
-
-  /// Draw white border around the texture
-
-  SDL_SetRenderDrawColor(renderer__, 255, 255, 255, 255);
-  SDL_Rect full_rect = {0, 0, static_cast<int>(tile_width__), static_cast<int>(tile_height__)};
-  SDL_RenderFillRect(renderer__, &full_rect);
-
-  const int border_thickness = 2;
-  SDL_SetRenderDrawColor(renderer__, 0, 0, 0, 255);
-  SDL_Rect innerRect = {
-    border_thickness,
-    border_thickness,
-    static_cast<int>(tile_width__ - 2 * border_thickness),
-    static_cast<int>(tile_height__ - 2 * border_thickness)
+  size_t pixel_columns = std::min(view_columns, width__);
+  size_t pixel_rows = std::min(view_rows, height__);
+  bool sampled = pixel_columns != view_columns || pixel_rows != view_rows;
+  auto colour = [this](uint32_t p_tile) {
+    return colours__[p_tile != wfc::NO_TILE ? p_tile : colours__.size() - 1];
   };
-  SDL_RenderFillRect(renderer__, &innerRect);
-
-  /// Restore the render target
-
-  SDL_SetRenderTarget(renderer__, previous_target);
-}
 
-size_t wfc::Canvas::get_lowest_entropy_spot_idx__() {
-  size_t min_entropy = tiles__.size();
-
-  /// Calculate the minimum entropy in the canvas
-
-  for (const auto& spot : buffer__) {
-    if (spot.tile != nullptr) {
-      continue;
+  if (redraw__ || (sampled && !p_dirty.empty())) {
+    for (size_t y = 0; y < pixel_rows; ++y) {
+      size_t row = p_view.row_begin + y * view_rows / pixel_rows;
+      uint32_t* line = &colour_pixels__[y * pixel_columns];
+      for (size_t x = 0; x < pixel_columns; ++x) {
+        line[x] = colour(p_tiles[row * columns + p_view.col_begin + x * view_columns / pixel_columns]);
+      }
     }
-    min_entropy = std::min(min_entropy, spot.possible_tiles.size());
   }
-
-  /// Collect all tiles that have the minimum entropy
-
-  std::vector<size_t> min_entropy_spots;
-  for (size_t i = 0, e = buffer__.size(); i < e; ++i) {
-    if (buffer__[i].possible_tiles.size() == min_entropy) {
-      min_entropy_spots.push_back(i);
+  else {
+    bool changed = false;
+    for (uint32_t idx : p_dirty) {
+      size_t row = idx / columns;
+      size_t col = idx % columns;
+      if (row >= p_view.row_begin && row < p_view.row_end && col >= p_view.col_begin && col < p_view.col_end) {
+        colour_pixels__[(row - p_view.row_begin) * pixel_columns + col - p_view.col_begin] = colour(p_tiles[idx]);
+        changed = true;
+      }
     }
-  }
-
-  /// Return a random spot with minimum entropy
-
-  return min_entropy_spots[wfc::Random::int_from_range(0, min_entropy_spots.size())];
-}
 
-void wfc::Canvas::reduce_entropy_arround__(size_t p_spot_idx) {
-  /// Get the spot to reduce entropy around
-
-  wfc::Spot* current_spot = &buffer__[p_spot_idx];
-
-  if (current_spot->tile == nullptr) {
-    return;
-  }
-
-  size_t row_number = p_spot_idx / columns__;
-  size_t col_number = p_spot_idx % columns__;
-
-  auto reduce_for = [](wfc::Spot* spot, wfc::Spot* current, wfc::Directions dir){
-    /// Get the rules of the tile of current spot
-
-    std::unordered_set<wfc::Tile*> rules = current->tile->get_rules(dir);
-    if (rules.size() == 0) {
+    if (!changed) {
       return;
     }
+  }
 
-    /// Get the current possibilities of reducing spot
-
-    std::unordered_set<wfc::Tile*>& current_possibilities = spot->possible_tiles;
+  /// Upload the pixels and stretch them over the spots in view
 
-    /// Find intersection
+  SDL_Rect source = {0, 0, static_cast<int>(pixel_columns), static_cast<int>(pixel_rows)};
+  SDL_UpdateTexture(colours_texture__, &source, colour_pixels__.data(), pixel_columns * 4);
 
-    spot->possible_tiles = wfc::set_intersection(current_possibilities, rules);
+  SDL_FRect target = {
+    offset_x__ + p_view.col_begin * p_view.spot_width,
+    offset_y__ + p_view.row_begin * p_view.spot_height,
+    view_columns * p_view.spot_width,
+    view_rows * p_view.spot_height
   };
+  SDL_RenderCopyF(renderer__, colours_texture__, &source, &target);
+}
 
-  if (row_number != 0) { /// Top spot exists
-    wfc::Spot* top_spot = &buffer__[p_spot_idx - columns__];
-    reduce_for(top_spot, current_spot, wfc::Directions::NORTH);
+void wfc::Canvas::create_textures__() {
+  frame__ = SDL_CreateTexture(renderer__, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, width__, height__);
+  if (!frame__) {
+    throw std::runtime_error("Failed to create frame texture");
   }
 
-  if (row_number != rows__ - 1) { /// Bottom spot exists
-    wfc::Spot* bottom_spot = &buffer__[p_spot_idx + columns__];
-    reduce_for(bottom_spot, current_spot, wfc::Directions::SOUTH);
-  }
+  create_atlas__();
 
-  if (col_number != 0) { /// Left spot exists
-    wfc::Spot* left_spot = &buffer__[p_spot_idx - 1];
-    reduce_for(left_spot, current_spot, wfc::Directions::WEST);
+  colours_texture__ = SDL_CreateTexture(renderer__, SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_STREAMING,
+                                        width__, height__);
+  if (!colours_texture__) {
+    throw std::runtime_error("Failed to create colour texture");
   }
+  SDL_SetTextureBlendMode(colours_texture__, SDL_BLENDMODE_NONE);
+  SDL_SetTextureScaleMode(colours_texture__, SDL_ScaleModeNearest);
+  colour_pixels__.resize(width__ * height__);
+}
 
-  if (col_number != columns__ - 1) { /// Right spot exists
-    wfc::Spot* right_spot = &buffer__[p_spot_idx + 1];
-    reduce_for(right_spot, current_spot, wfc::Directions::EAST);
-  }
+void wfc::Canvas::create_atlas__() {
+  size_t tile_count = solver__->get_tiles().size();
+  size_t slot_width = std::max<size_t>(compositor__.get_tile_width(), 1);
+  size_t slot_height = std::max<size_t>(compositor__.get_tile_height(), 1);
 
-  if (direction_type__ != wfc::DirectionType::OCT_DIRECTIONS) {
-    return;
-  }
+  /// Lay the tiles out in a square grid of slots, the uncollapsed tile takes the last slot
 
-  if (row_number != 0 && col_number != 0) { /// Top Left spot exists
-    wfc::Spot* top_left_spot = &buffer__[p_spot_idx - columns__ - 1];
-    reduce_for(top_left_spot, current_spot, wfc::Directions::NORTH_WEST);
-  }
+  size_t slot_count = tile_count + 1;
+  size_t slot_columns = static_cast<size_t>(std::ceil(std::sqrt(static_cast<double>(slot_count))));
+  size_t slot_rows = (slot_count + slot_columns - 1) / slot_columns;
+  size_t atlas_width = slot_columns * slot_width;
+  size_t atlas_height = slot_rows * slot_height;
 
-  if (row_number != 0 && col_number != columns__ - 1) { /// Top Right spot exists
-    wfc::Spot* top_right_spot = &buffer__[p_spot_idx - columns__ + 1];
-    reduce_for(top_right_spot, current_spot, wfc::Directions::NORTH_EAST);
+  SDL_RendererInfo info;
+  if (SDL_GetRendererInfo(renderer__, &info) == 0 && info.max_texture_width > 0 &&
+      (atlas_width > static_cast<size_t>(info.max_texture_width) ||
+       atlas_height > static_cast<size_t>(info.max_texture_height))) {
+    std::stringstream msg;
+    msg << "Tile atlas of " << atlas_width << "x" << atlas_height << " is larger than the "
+        << info.max_texture_width << "x" << info.max_texture_height << " textures the renderer supports";
+    throw std::runtime_error(msg.str());
   }
 
-  if (row_number != rows__ - 1 && col_number != 0) { /// Bottom Left spot exists
-    wfc::Spot* bottom_left_spot = &buffer__[p_spot_idx + columns__ - 1];
-    reduce_for(bottom_left_spot, current_spot, wfc::Directions::SOUTH_WEST);
-  }
+  /// Copy every tile over black into its slot and store its texture coordinates and average colour
 
-  if (row_number != rows__ - 1 && col_number != columns__ - 1) { /// Bottom Right spot exists
-    wfc::Spot* bottom_right_spot = &buffer__[p_spot_idx + columns__ + 1];
-    reduce_for(bottom_right_spot, current_spot, wfc::Directions::SOUTH_EAST);
-  }
-}
+  std::vector<uint8_t> pixels(atlas_width * atlas_height * 4, 0);
+  size_t pitch = atlas_width * 4;
+  uvs__.clear();
 
-void wfc::Canvas::apply_constraints__() {
+  auto place = [&](size_t p_slot, size_t p_width, size_t p_height) {
+    size_t x = (p_slot % slot_columns) * slot_width;
+    size_t y = (p_slot / slot_columns) * slot_height;
+    uvs__.push_back({
+      static_cast<float>(x) / atlas_width,
+      static_cast<float>(y) / atlas_height,
+      static_cast<float>(p_width) / atlas_width,
+      static_cast<float>(p_height) / atlas_height
+    });
+    return &pixels[y * pitch + x * 4];
+  };
 
-  /// Top Row
+  auto over_black = [](const uint8_t* p_src, uint8_t* p_out) {
+    p_out[0] = p_src[0] * p_src[3] / 255;
+    p_out[1] = p_src[1] * p_src[3] / 255;
+    p_out[2] = p_src[2] * p_src[3] / 255;
+    p_out[3] = 255;
+  };
 
-  if (constraints__.others[wfc::Constraints::TOP].size() > 0) {
-    for (size_t i = 0; i < columns__; ++i) {
-      buffer__[i].possible_tiles = constraints__.others[wfc::Constraints::TOP];
+  colours__.clear();
+  for (size_t t = 0; t < tile_count; ++t) {
+    const wfc::MipChain& chain = compositor__.get_mip_chain(t);
+    uint8_t* dst = place(t, chain.get_width(0), chain.get_height(0));
+    for (size_t y = 0; y < chain.get_height(0); ++y) {
+      const uint8_t* src = chain.get_pixels(0) + y * chain.get_width(0) * 4;
+      uint8_t* out = dst + y * pitch;
+      for (size_t i = 0; i < chain.get_width(0) * 4; i += 4) {
+        over_black(src + i, out + i);
+      }
     }
+
+    uint32_t average;
+    over_black(chain.get_average(), reinterpret_cast<uint8_t*>(&average));
+    colours__.push_back(average);
   }
 
-  /// Bottom Row
+  /// Draw the uncollapsed tile as a black tile with white border
 
-  if (constraints__.others[wfc::Constraints::BOTTOM].size() > 0) {
-    for (size_t i = buffer__.size() - columns__, e = buffer__.size(); i < e; ++i) {
-      buffer__[i].possible_tiles = constraints__.others[wfc::Constraints::BOTTOM];
+  const size_t border_thickness = 2;
+  uint8_t* null_tile = place(tile_count, slot_width, slot_height);
+  for (size_t y = 0; y < slot_height; ++y) {
+    for (size_t x = 0; x < slot_width; ++x) {
+      bool border = x < border_thickness || y < border_thickness ||
+                    x + border_thickness >= slot_width || y + border_thickness >= slot_height;
+      uint8_t* out = null_tile + y * pitch + x * 4;
+      out[0] = out[1] = out[2] = border ? 255 : 0;
+      out[3] = 255;
     }
   }
 
-  /// Left Column
+  uint32_t null_average;
+  std::memcpy(&null_average, wfc::MipChain(null_tile, slot_width, slot_height, pitch).get_average(), 4);
+  colours__.push_back(null_average);
 
-  if (constraints__.others[wfc::Constraints::LEFT].size() > 0) {
-    for (size_t i = 0, e = buffer__.size(); i < e; i += columns__) {
-      buffer__[i].possible_tiles = constraints__.others[wfc::Constraints::LEFT];
-    }
+  /// Upload the atlas, sampled with nearest neighbour so slots do not bleed into each other
+
+  atlas__ = SDL_CreateTexture(renderer__, SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_STATIC,
+                              atlas_width, atlas_height);
+  if (!atlas__) {
+    throw std::runtime_error("Failed to create tile atlas texture");
   }
+  SDL_UpdateTexture(atlas__, nullptr, pixels.data(), pitch);
+  SDL_SetTextureBlendMode(atlas__, SDL_BLENDMODE_NONE);
+  SDL_SetTextureScaleMode(atlas__, SDL_ScaleModeNearest);
+}
 
-  /// Right Column
+void wfc::Canvas::add_spot__(size_t p_spot_idx, uint32_t p_tile, const View& p_view) {
+  size_t columns = solver__->get_columns();
+  size_t row = p_spot_idx / columns;
+  size_t col = p_spot_idx % columns;
 
-  if (constraints__.others[wfc::Constraints::RIGHT].size() > 0) {
-    for (size_t i = columns__ - 1, e = buffer__.size(); i < e; i += columns__) {
-      buffer__[i].possible_tiles = constraints__.others[wfc::Constraints::RIGHT];
-    }
-  }
+  /// Calculate the position of the tile in the window
 
-  /// Top Right Spot
+  float left = offset_x__ + col * p_view.spot_width;
+  float top = offset_y__ + row * p_view.spot_height;
+  float right = offset_x__ + (col + 1) * p_view.spot_width;
+  float bottom = offset_y__ + (row + 1) * p_view.spot_height;
 
-  size_t top_right_index = columns__ - 1;
-  if (constraints__.others[wfc::Constraints::TOP_RIGHT].size() > 0) {
-    buffer__[top_right_index].possible_tiles = constraints__.others[wfc::Constraints::TOP_RIGHT];
-  }
+  /// Take the texture coordinates of the collapsed tile, or of the uncollapsed tile
 
-  /// Bottom Right Spot
+  const SDL_FRect& uv = uvs__[p_tile != wfc::NO_TILE ? p_tile : uvs__.size() - 1];
 
-  size_t bottom_right_index = buffer__.size() - 1;
-  if (constraints__.others[wfc::Constraints::BOTTOM_RIGHT].size() > 0) {
-    buffer__[bottom_right_index].possible_tiles = constraints__.others[wfc::Constraints::BOTTOM_RIGHT];
-  }
+  /// Add two triangles covering the spot
 
-  /// Bottom Left Spot
+  const SDL_Color white = {255, 255, 255, 255};
+  int first = vertices__.size();
+  vertices__.push_back({{left, top}, white, {uv.x, uv.y}});
+  vertices__.push_back({{right, top}, white, {uv.x + uv.w, uv.y}});
+  vertices__.push_back({{right, bottom}, white, {uv.x + uv.w, uv.y + uv.h}});
+  vertices__.push_back({{left, bottom}, white, {uv.x, uv.y + uv.h}});
 
-  size_t bottom_left_index = buffer__.size() - columns__;
-  if (constraints__.others[wfc::Constraints::BOTTOM_LEFT].size() > 0) {
-    buffer__[bottom_left_index].possible_tiles = constraints__.others[wfc::Constraints::BOTTOM_LEFT];
+  const int corners[] = {0, 1, 2, 2, 3, 0};
+  for (int corner : corners) {
+    indices__.push_back(first + corner);
   }
+}
 
-  /// Top Left Spot
-
-  size_t top_left_index = 0;
-  if (constraints__.others[wfc::Constraints::TOP_LEFT].size() > 0) {
-    buffer__[top_left_index].possible_tiles = constraints__.others[wfc::Constraints::TOP_LEFT];
+void wfc::Canvas::free_textures__() {
+  if (atlas__) {
+    SDL_DestroyTexture(atlas__);
+    atlas__ = nullptr;
   }
 
-  /// Fixed
+  if (colours_texture__) {
+    SDL_DestroyTexture(colours_texture__);
+    colours_texture__ = nullptr;
+  }
 
-  for (auto& [idx, value]: constraints__.fixed) {
-    buffer__[idx].possible_tiles = value;
+  if (frame__) {
+    SDL_DestroyTexture(frame__);
+    frame__ = nullptr;
   }
 }
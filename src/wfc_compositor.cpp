@@ -0,0 +1,158 @@
+#include "wfc_compositor.h"
+#include "wfc_image_writer.h"
+#include "wfc_sdl_utils.h"
+#include "wfc_symmetry.h"
+#include "wfc_log.h"
+
+#include <algorithm>
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+
+#include <SDL2/SDL.h>
+
+wfc::Compositor::Compositor(const std::vector<wfc::Tile*>& p_tiles) {
+  wfc::ImageCache images;
+
+  for (const wfc::Tile* tile : p_tiles) {
+
+    /// Use the pixels of tiles that were not given an image file as they are
+
+    if (!tile->get_pixels().empty()) {
+      if (!mip_chains__.empty() &&
+          (tile->get_width() != get_tile_width() || tile->get_height() != get_tile_height())) {
+        std::stringstream msg;
+        msg << "Tile " << tile->get_id() << " is " << tile->get_width() << "x" << tile->get_height()
+            << " but the other tiles are " << get_tile_width() << "x" << get_tile_height();
+        throw std::runtime_error(msg.str());
+      }
+
+      mip_chains__.emplace_back(tile->get_pixels().data(), tile->get_width(), tile->get_height(),
+                                tile->get_width() * 4);
+      uint32_t colour;
+      std::memcpy(&colour, mip_chains__.back().get_average(), 4);
+      colours__.push_back(colour);
+      continue;
+    }
+
+    /// Load the image as RGBA32 so rows can be copied into the output as they are, variants of a
+    /// tile share the file and turn or mirror it in memory
+
+    const std::filesystem::path& path = tile->get_path();
+    SDL_Surface* surface = images.get(path);
+    const uint8_t* pixels = static_cast<const uint8_t*>(surface->pixels);
+    size_t width = surface->w;
+    size_t height = surface->h;
+    size_t pitch = surface->pitch;
+
+    std::vector<uint8_t> transformed;
+    if (tile->get_transform() != 0) {
+      transformed = wfc::transform_image(pixels, width, height, pitch, tile->get_transform(), width, height);
+      pixels = transformed.data();
+      pitch = width * 4;
+    }
+
+    /// Check that every tile has the size of the first one
+
+    if (!mip_chains__.empty() && (width != get_tile_width() || height != get_tile_height())) {
+      std::stringstream msg;
+      msg << "Image at " << path << " is " << width << "x" << height
+          << " but the other tiles are " << get_tile_width() << "x" << get_tile_height();
+      throw std::runtime_error(msg.str());
+    }
+
+    /// Keep the pixels with their mip chain and average colour
+
+    mip_chains__.emplace_back(pixels, width, height, pitch);
+
+    uint32_t colour;
+    std::memcpy(&colour, mip_chains__.back().get_average(), 4);
+    colours__.push_back(colour);
+  }
+}
+
+size_t wfc::Compositor::get_tile_width(size_t p_level) const {
+  return mip_chains__.empty() ? 0 : mip_chains__[0].get_width(p_level);
+}
+
+size_t wfc::Compositor::get_tile_height(size_t p_level) const {
+  return mip_chains__.empty() ? 0 : mip_chains__[0].get_height(p_level);
+}
+
+size_t wfc::Compositor::get_level_count() const {
+  return mip_chains__.empty() ? 1 : mip_chains__[0].get_level_count();
+}
+
+const wfc::MipChain& wfc::Compositor::get_mip_chain(size_t p_tile) const {
+  return mip_chains__[p_tile];
+}
+
+const std::vector<uint32_t>& wfc::Compositor::get_colours() const {
+  return colours__;
+}
+
+void wfc::Compositor::compose_rows(const wfc::Solver& p_solver, size_t p_first_row, size_t p_row_count,
+                                   uint8_t* p_pixels, size_t p_pitch, size_t p_level) const {
+  size_t columns = p_solver.get_columns();
+  size_t tile_width = get_tile_width(p_level);
+  size_t tile_height = get_tile_height(p_level);
+  size_t tile_bytes = tile_width * 4;
+
+  /// At the last level write one pixel per spot straight from the average colours
+
+  if (p_level + 1 == get_level_count()) {
+    for (size_t row = 0; row < p_row_count; ++row) {
+      uint32_t* line = reinterpret_cast<uint32_t*>(p_pixels + row * p_pitch);
+      for (size_t col = 0; col < columns; ++col) {
+        const wfc::Tile* tile = p_solver.get_tile((p_first_row + row) * columns + col);
+        line[col] = tile ? colours__[tile->get_id()] : 0;
+      }
+    }
+    return;
+  }
+
+  for (size_t row = 0; row < p_row_count; ++row) {
+    for (size_t col = 0; col < columns; ++col) {
+      const wfc::Tile* tile = p_solver.get_tile((p_first_row + row) * columns + col);
+      uint8_t* dst = p_pixels + row * tile_height * p_pitch + col * tile_bytes;
+
+      /// Leave uncollapsed spots transparent
+
+      if (!tile) {
+        for (size_t y = 0; y < tile_height; ++y) {
+          std::memset(dst + y * p_pitch, 0, tile_bytes);
+        }
+        continue;
+      }
+
+      /// Copy the tile one line at a time
+
+      const uint8_t* src = mip_chains__[tile->get_id()].get_pixels(p_level);
+      for (size_t y = 0; y < tile_height; ++y) {
+        std::memcpy(dst + y * p_pitch, src + y * tile_bytes, tile_bytes);
+      }
+    }
+  }
+}
+
+void wfc::Compositor::save_image(const wfc::Solver& p_solver, const std::string& p_output, size_t p_threads,
+                                 size_t p_level) const {
+  wfc::Log::info("Saving output image...");
+
+  size_t level = std::min(p_level, get_level_count() - 1);
+  size_t tile_height = get_tile_height(level);
+  size_t width = p_solver.get_columns() * get_tile_width(level);
+  size_t height = p_solver.get_rows() * tile_height;
+  std::unique_ptr<wfc::ImageWriter> writer = wfc::ImageWriter::open(p_output, width, height, p_threads);
+
+  /// Compose one row of spots at a time and stream it to the writer
+
+  size_t pitch = width * 4;
+  std::vector<uint8_t> band(pitch * tile_height);
+  for (size_t row = 0; row < p_solver.get_rows(); ++row) {
+    compose_rows(p_solver, row, 1, band.data(), pitch, level);
+    writer->write_band(band.data(), pitch, tile_height);
+  }
+
+  writer->finish();
+}
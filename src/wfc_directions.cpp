@@ -1,6 +1,13 @@
 #include "wfc_directions.h"
 #include <ostream>
 
+wfc::Directions wfc::opposite(wfc::Directions p_dir) {
+
+  /// Directions are listed clockwise so the opposite one is half a turn away
+
+  return static_cast<wfc::Directions>((static_cast<size_t>(p_dir) + 4) % wfc::DIRECTION_COUNT);
+}
+
 std::ostream& operator<<(std::ostream& out, const wfc::Directions& dir) {
   using wfc::Directions;
 
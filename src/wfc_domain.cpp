@@ -0,0 +1,82 @@
+#include "wfc_domain.h"
+
+#include <algorithm>
+
+wfc::Domains::Domains() :
+  cells__(0),
+  bits__(0),
+  words__(0) {
+}
+
+void wfc::Domains::resize(size_t p_cells, size_t p_bits) {
+  cells__ = p_cells;
+  bits__ = p_bits;
+  words__ = words_for(p_bits);
+
+  /// Allocate all spots in one block
+
+  data__.assign(cells__ * words__, 0);
+}
+
+void wfc::Domains::clear(size_t p_idx) {
+  std::fill_n(cell(p_idx), words__, 0);
+}
+
+void wfc::Domains::assign(size_t p_idx, const uint64_t* p_mask) {
+  std::copy_n(p_mask, words__, cell(p_idx));
+}
+
+void wfc::Domains::fill(const uint64_t* p_mask) {
+  for (size_t i = 0; i < cells__; ++i) {
+    assign(i, p_mask);
+  }
+}
+
+bool wfc::Domains::intersect(size_t p_idx, const uint64_t* p_mask) {
+  uint64_t* words = cell(p_idx);
+  uint64_t changed = 0;
+
+  /// AND word by word and remember if any bit was dropped
+
+  for (size_t w = 0; w < words__; ++w) {
+    uint64_t reduced = words[w] & p_mask[w];
+    changed |= words[w] ^ reduced;
+    words[w] = reduced;
+  }
+
+  return changed != 0;
+}
+
+size_t wfc::Domains::count(size_t p_idx) const {
+  const uint64_t* words = cell(p_idx);
+  size_t result = 0;
+  for (size_t w = 0; w < words__; ++w) {
+    result += __builtin_popcountll(words[w]);
+  }
+  return result;
+}
+
+size_t wfc::Domains::nth(size_t p_idx, size_t p_n) const {
+  const uint64_t* words = cell(p_idx);
+
+  for (size_t w = 0; w < words__; ++w) {
+    size_t in_word = __builtin_popcountll(words[w]);
+
+    /// Skip whole words until the word holding the n-th bit is found
+
+    if (p_n >= in_word) {
+      p_n -= in_word;
+      continue;
+    }
+
+    /// Drop the lowest set bits of the word until the n-th one is the lowest
+
+    uint64_t word = words[w];
+    for (size_t i = 0; i < p_n; ++i) {
+      word &= word - 1;
+    }
+    return w * 64 + __builtin_ctzll(word);
+  }
+
+  return bits__;
+}
@@ -0,0 +1,178 @@
+#include "wfc_edge_rules.h"
+#include "wfc_utils.h"
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+namespace {
+
+/// Multiplier of each lane of the edge hash
+const uint64_t HASH_PRIME = 0x100000001b3ULL;
+
+/// Number of edges per tile, in the order north, east, south, west
+const size_t SIDE_COUNT = 4;
+
+/*
+ * Hash the colours of an edge. Four lanes hash every fourth pixel independently, so their
+ * multiplies do not wait for each other and the loop can be vectorised, then they are combined
+ */
+uint64_t hash_edge(const std::vector<uint32_t>& p_pixels) {
+  uint64_t lanes[4] = {0xcbf29ce484222325ULL, 0x84222325cbf29ce4ULL, 0x9e3779b97f4a7c15ULL, 0xbf58476d1ce4e5b9ULL};
+  size_t count = p_pixels.size();
+
+  size_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    for (size_t k = 0; k < 4; ++k) {
+      lanes[k] = (lanes[k] ^ p_pixels[i + k]) * HASH_PRIME;
+    }
+  }
+  for (; i < count; ++i) {
+    lanes[i & 3] = (lanes[i & 3] ^ p_pixels[i]) * HASH_PRIME;
+  }
+
+  uint64_t hash = count;
+  for (uint64_t lane : lanes) {
+    hash = (hash ^ lane ^ (lane >> 29)) * 0x94d049bb133111ebULL;
+  }
+  return hash ^ (hash >> 32);
+}
+
+}
+
+wfc::EdgeRules::EdgeRules(size_t p_tolerance) :
+  tolerance__(p_tolerance) {
+}
+
+void wfc::EdgeRules::add_tile(const uint8_t* p_pixels, size_t p_width, size_t p_height, size_t p_pitch) {
+  auto pixel = [p_pixels, p_pitch](size_t p_x, size_t p_y) {
+    uint32_t colour;
+    std::memcpy(&colour, p_pixels + p_y * p_pitch + p_x * 4, 4);
+    return colour;
+  };
+
+  /// Copy the first and last line and column, lines from left to right and columns from top to bottom
+
+  Edge sides[SIDE_COUNT];
+  for (size_t x = 0; x < p_width; ++x) {
+    sides[0].pixels.push_back(pixel(x, 0));
+    sides[2].pixels.push_back(pixel(x, p_height - 1));
+  }
+  for (size_t y = 0; y < p_height; ++y) {
+    sides[1].pixels.push_back(pixel(p_width - 1, y));
+    sides[3].pixels.push_back(pixel(0, y));
+  }
+
+  for (Edge& edge : sides) {
+    edge.hash = hash_edge(edge.pixels);
+    std::fill(edge.sums, edge.sums + 4, 0);
+    for (uint32_t colour : edge.pixels) {
+      const uint8_t* channels = reinterpret_cast<const uint8_t*>(&colour);
+      for (size_t c = 0; c < 4; ++c) {
+        edge.sums[c] += channels[c];
+      }
+    }
+    edges__.push_back(std::move(edge));
+  }
+}
+
+void wfc::EdgeRules::compile(size_t p_threads) {
+  size_t tile_count = edges__.size() / SIDE_COUNT;
+
+  /// Diagonals have no edge and are left empty
+
+  compatible__.build(tile_count, p_threads, 2, [this, tile_count](size_t p_dir) {
+    size_t side = p_dir / 2;
+    size_t facing = (side + 2) % SIDE_COUNT;
+
+    /// Group the identical facing edges so each distinct edge is only compared once
+
+    std::vector<std::pair<uint64_t, uint32_t>> by_hash(tile_count);
+    for (size_t t = 0; t < tile_count; ++t) {
+      by_hash[t] = {edges__[t * SIDE_COUNT + facing].hash, static_cast<uint32_t>(t)};
+    }
+    std::sort(by_hash.begin(), by_hash.end());
+
+    std::vector<uint32_t> members(tile_count);
+    std::vector<size_t> class_starts;
+    for (size_t i = 0; i < tile_count; ++i) {
+      members[i] = by_hash[i].second;
+      const Edge& edge = edges__[members[i] * SIDE_COUNT + facing];
+      const Edge* first = class_starts.empty() ? nullptr : &edges__[members[class_starts.back()] * SIDE_COUNT + facing];
+      if (!first || by_hash[i].first != first->hash || edge.pixels != first->pixels) {
+        class_starts.push_back(i);
+      }
+    }
+    class_starts.push_back(tile_count);
+
+    /// Sort the distinct edges on their hash for exact matches, on their red sum for a tolerance
+
+    size_t class_count = class_starts.size() - 1;
+    std::vector<std::pair<uint64_t, uint32_t>> sorted(class_count);
+    for (size_t k = 0; k < class_count; ++k) {
+      const Edge& edge = edges__[members[class_starts[k]] * SIDE_COUNT + facing];
+      sorted[k] = {tolerance__ == 0 ? edge.hash : edge.sums[0], static_cast<uint32_t>(k)};
+    }
+    std::sort(sorted.begin(), sorted.end());
+
+    return [this, side, facing, members = std::move(members), class_starts = std::move(class_starts),
+            sorted = std::move(sorted)](size_t p_a, std::vector<uint32_t>& p_out) {
+      const Edge& edge = edges__[p_a * SIDE_COUNT + side];
+      size_t before = p_out.size();
+
+      /// Edges within the tolerance have channel sums at most tolerance * length apart
+
+      uint64_t slack = tolerance__ * edge.pixels.size();
+      uint64_t low = tolerance__ == 0 ? edge.hash : (edge.sums[0] > slack ? edge.sums[0] - slack : 0);
+      uint64_t high = tolerance__ == 0 ? edge.hash : edge.sums[0] + slack;
+
+      auto first = std::lower_bound(sorted.begin(), sorted.end(), std::make_pair(low, uint32_t(0)));
+      for (auto it = first; it != sorted.end() && it->first <= high; ++it) {
+        const Edge& other = edges__[members[class_starts[it->second]] * SIDE_COUNT + facing];
+
+        bool close = true;
+        for (size_t c = 1; close && c < 4; ++c) {
+          uint64_t diff = edge.sums[c] > other.sums[c] ? edge.sums[c] - other.sums[c] : other.sums[c] - edge.sums[c];
+          close = diff <= slack;
+        }
+        if (close && matches__(edge, other)) {
+          p_out.insert(p_out.end(), members.begin() + class_starts[it->second],
+                       members.begin() + class_starts[it->second + 1]);
+        }
+      }
+
+      /// Matching classes come in order of their keys
+
+      std::sort(p_out.begin() + before, p_out.end());
+    };
+  });
+}
+
+const uint32_t* wfc::EdgeRules::get_compatible(size_t p_tile, wfc::Directions p_dir) const {
+  return compatible__.get(p_tile, p_dir);
+}
+
+size_t wfc::EdgeRules::get_compatible_count(size_t p_tile, wfc::Directions p_dir) const {
+  return compatible__.get_count(p_tile, p_dir);
+}
+
+bool wfc::EdgeRules::matches__(const Edge& p_a, const Edge& p_b) const {
+  if (p_a.pixels.size() != p_b.pixels.size()) {
+    return false;
+  }
+
+  if (tolerance__ == 0) {
+    return p_a.pixels == p_b.pixels;
+  }
+
+  /// Compare every channel of every pair of facing pixels
+
+  const uint8_t* a = reinterpret_cast<const uint8_t*>(p_a.pixels.data());
+  const uint8_t* b = reinterpret_cast<const uint8_t*>(p_b.pixels.data());
+  for (size_t i = 0; i < p_a.pixels.size() * 4; ++i) {
+    if (static_cast<size_t>(std::abs(a[i] - b[i])) > tolerance__) {
+      return false;
+    }
+  }
+  return true;
+}
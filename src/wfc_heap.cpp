@@ -0,0 +1,103 @@
+#include "wfc_heap.h"
+
+wfc::EntropyHeap::EntropyHeap() {
+}
+
+void wfc::EntropyHeap::clear(size_t p_capacity) {
+  heap__.clear();
+  heap__.reserve(p_capacity);
+  position__.assign(p_capacity, NPOS);
+  entropy__.resize(p_capacity);
+  noise__.resize(p_capacity);
+}
+
+void wfc::EntropyHeap::push(size_t p_idx, double p_entropy, uint32_t p_noise) {
+  entropy__[p_idx] = p_entropy;
+  noise__[p_idx] = p_noise;
+
+  /// Append the spot and restore heap order
+
+  position__[p_idx] = heap__.size();
+  heap__.push_back(p_idx);
+  sift_up__(heap__.size() - 1);
+}
+
+void wfc::EntropyHeap::update(size_t p_idx, double p_entropy) {
+  double previous = entropy__[p_idx];
+  entropy__[p_idx] = p_entropy;
+
+  /// Move the spot in the direction its entropy changed
+
+  if (p_entropy < previous) {
+    sift_up__(position__[p_idx]);
+  }
+  else {
+    sift_down__(position__[p_idx]);
+  }
+}
+
+void wfc::EntropyHeap::remove(size_t p_idx) {
+  uint32_t pos = position__[p_idx];
+  if (pos == NPOS) {
+    return;
+  }
+
+  /// Move the last spot into the hole and restore heap order around it
+
+  uint32_t last = heap__.back();
+  heap__.pop_back();
+  position__[p_idx] = NPOS;
+
+  if (last == p_idx) {
+    return;
+  }
+
+  heap__[pos] = last;
+  position__[last] = pos;
+  sift_up__(pos);
+  sift_down__(position__[last]);
+}
+
+void wfc::EntropyHeap::sift_up__(size_t p_pos) {
+  uint32_t idx = heap__[p_pos];
+
+  while (p_pos > 0) {
+    size_t parent = (p_pos - 1) / 2;
+    if (!before__(idx, heap__[parent])) {
+      break;
+    }
+    heap__[p_pos] = heap__[parent];
+    position__[heap__[p_pos]] = p_pos;
+    p_pos = parent;
+  }
+
+  heap__[p_pos] = idx;
+  position__[idx] = p_pos;
+}
+
+void wfc::EntropyHeap::sift_down__(size_t p_pos) {
+  uint32_t idx = heap__[p_pos];
+  size_t size = heap__.size();
+
+  while (true) {
+    size_t child = 2 * p_pos + 1;
+    if (child >= size) {
+      break;
+    }
+
+    /// Pick the smaller child
+
+    if (child + 1 < size && before__(heap__[child + 1], heap__[child])) {
+      ++child;
+    }
+    if (!before__(heap__[child], idx)) {
+      break;
+    }
+    heap__[p_pos] = heap__[child];
+    position__[heap__[p_pos]] = p_pos;
+    p_pos = child;
+  }
+
+  heap__[p_pos] = idx;
+  position__[idx] = p_pos;
+}
@@ -0,0 +1,292 @@
+#include "wfc_image_writer.h"
+
+#include <algorithm>
+#include <climits>
+#include <cstring>
+#include <filesystem>
+#include <sstream>
+#include <stdexcept>
+
+#include <zlib.h>
+
+namespace {
+
+/// Largest window of a deflate stream, the most of the previous band used as dictionary
+const size_t DICTIONARY_SIZE = 32768;
+
+/*
+ * Store a 32-bit integer in big-endian order
+ */
+void put_u32(uint8_t* p_out, uint32_t p_value) {
+  p_out[0] = p_value >> 24;
+  p_out[1] = p_value >> 16;
+  p_out[2] = p_value >> 8;
+  p_out[3] = p_value;
+}
+
+/*
+ * Throw if the last write to the file failed
+ */
+void check_stream(const std::ofstream& p_file, const std::string& p_path) {
+  if (!p_file) {
+    std::stringstream msg;
+    msg << "Failed to write output image " << p_path;
+    throw std::runtime_error(msg.str());
+  }
+}
+
+}
+
+std::unique_ptr<wfc::ImageWriter> wfc::ImageWriter::open(const std::string& p_path, size_t p_width,
+                                                         size_t p_height, size_t p_threads) {
+  std::string extension = std::filesystem::path(p_path).extension();
+  if (extension == ".png") {
+    return std::make_unique<wfc::PngWriter>(p_path, p_width, p_height, p_threads);
+  }
+  if (extension == ".ppm") {
+    return std::make_unique<wfc::PpmWriter>(p_path, p_width, p_height);
+  }
+
+  std::stringstream msg;
+  msg << "Output image " << p_path << " must be a png or ppm";
+  throw std::runtime_error(msg.str());
+}
+
+wfc::PngWriter::PngWriter(const std::string& p_path, size_t p_width, size_t p_height, size_t p_threads) :
+  file__(p_path, std::ios::binary),
+  path__(p_path),
+  width__(p_width),
+  height__(p_height),
+  threads__(std::max<size_t>(p_threads, 1)),
+  lines__(0),
+  adler__(adler32(0, Z_NULL, 0)) {
+
+  /// Check the size fits in the png header
+
+  if (width__ == 0 || height__ == 0 || width__ > INT32_MAX || height__ > INT32_MAX) {
+    std::stringstream msg;
+    msg << "Can not save a " << width__ << "x" << height__ << " png";
+    throw std::runtime_error(msg.str());
+  }
+
+  if (!file__) {
+    std::stringstream msg;
+    msg << "Failed to open output image " << path__;
+    throw std::runtime_error(msg.str());
+  }
+
+  /// Write the signature, an 8-bit RGBA header and the start of the zlib stream
+
+  const uint8_t signature[] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n'};
+  file__.write(reinterpret_cast<const char*>(signature), sizeof(signature));
+
+  uint8_t header[13];
+  put_u32(header, width__);
+  put_u32(header + 4, height__);
+  header[8] = 8;
+  header[9] = 6;
+  header[10] = 0;
+  header[11] = 0;
+  header[12] = 0;
+  write_chunk__("IHDR", header, sizeof(header));
+
+  const uint8_t zlib_header[] = {0x78, 0x9c};
+  write_chunk__("IDAT", zlib_header, sizeof(zlib_header));
+}
+
+void wfc::PngWriter::write_band(const uint8_t* p_pixels, size_t p_pitch, size_t p_lines) {
+  if (lines__ + p_lines > height__) {
+    std::stringstream msg;
+    msg << "Too many lines written to " << path__;
+    throw std::runtime_error(msg.str());
+  }
+
+  /// Filter every line with Up, or with Sub for the first line so the band stands on its own
+
+  size_t line_bytes = width__ * 4;
+  auto filtered = std::make_shared<std::vector<uint8_t>>(p_lines * (line_bytes + 1));
+  for (size_t y = 0; y < p_lines; ++y) {
+    const uint8_t* line = p_pixels + y * p_pitch;
+    uint8_t* out = filtered->data() + y * (line_bytes + 1);
+
+    if (y == 0) {
+      out[0] = 1;
+      for (size_t i = 0; i < line_bytes; ++i) {
+        out[i + 1] = line[i] - (i >= 4 ? line[i - 4] : 0);
+      }
+    }
+    else {
+      const uint8_t* above = line - p_pitch;
+      out[0] = 2;
+      for (size_t i = 0; i < line_bytes; ++i) {
+        out[i + 1] = line[i] - above[i];
+      }
+    }
+  }
+
+  /// Compress the band on its own thread, keeping at most threads__ bands in flight
+
+  lines__ += p_lines;
+  pending__.push_back(std::async(std::launch::async, &wfc::PngWriter::compress__,
+                                 filtered, previous__, lines__ == height__));
+  previous__ = filtered;
+
+  while (pending__.size() >= threads__) {
+    write_pending__();
+  }
+}
+
+void wfc::PngWriter::finish() {
+  if (lines__ != height__) {
+    std::stringstream msg;
+    msg << "Only " << lines__ << " of " << height__ << " lines written to " << path__;
+    throw std::runtime_error(msg.str());
+  }
+
+  while (!pending__.empty()) {
+    write_pending__();
+  }
+
+  /// End the zlib stream with the checksum of all bands and close the png
+
+  uint8_t adler[4];
+  put_u32(adler, adler__);
+  write_chunk__("IDAT", adler, sizeof(adler));
+  write_chunk__("IEND", nullptr, 0);
+
+  file__.close();
+  check_stream(file__, path__);
+}
+
+wfc::PngWriter::Band wfc::PngWriter::compress__(std::shared_ptr<const std::vector<uint8_t>> p_filtered,
+                                                std::shared_ptr<const std::vector<uint8_t>> p_dictionary,
+                                                bool p_last) {
+  Band band;
+  band.size = p_filtered->size();
+  band.adler = adler32(adler32(0, Z_NULL, 0), p_filtered->data(), band.size);
+
+  if (band.size > UINT_MAX) {
+    throw std::runtime_error("Image band is too large to compress");
+  }
+
+  /// Raw deflate so the bands can be concatenated behind a single zlib header
+
+  z_stream stream;
+  std::memset(&stream, 0, sizeof(stream));
+  if (deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+    throw std::runtime_error("Failed to initialize deflate");
+  }
+
+  if (p_dictionary) {
+    size_t size = std::min(DICTIONARY_SIZE, p_dictionary->size());
+    deflateSetDictionary(&stream, p_dictionary->data() + p_dictionary->size() - size, size);
+  }
+
+  band.data.resize(deflateBound(&stream, band.size) + 16);
+  stream.next_in = const_cast<Bytef*>(p_filtered->data());
+  stream.avail_in = band.size;
+  stream.next_out = band.data.data();
+  stream.avail_out = band.data.size();
+
+  /// Flush to a byte boundary, only the last band ends the deflate stream
+
+  int flush = p_last ? Z_FINISH : Z_SYNC_FLUSH;
+  while (true) {
+    int status = deflate(&stream, flush);
+    if (status == Z_STREAM_ERROR) {
+      deflateEnd(&stream);
+      throw std::runtime_error("Failed to compress image band");
+    }
+    if (p_last ? status == Z_STREAM_END : stream.avail_out != 0) {
+      break;
+    }
+
+    size_t used = band.data.size() - stream.avail_out;
+    band.data.resize(band.data.size() * 2);
+    stream.next_out = band.data.data() + used;
+    stream.avail_out = band.data.size() - used;
+  }
+
+  band.data.resize(band.data.size() - stream.avail_out);
+  deflateEnd(&stream);
+  return band;
+}
+
+void wfc::PngWriter::write_pending__() {
+  Band band = pending__.front().get();
+  pending__.pop_front();
+
+  write_chunk__("IDAT", band.data.data(), band.data.size());
+  adler__ = adler32_combine(adler__, band.adler, band.size);
+}
+
+void wfc::PngWriter::write_chunk__(const char* p_type, const uint8_t* p_data, size_t p_size) {
+  uint8_t length[4];
+  put_u32(length, p_size);
+
+  uLong crc = crc32(0, Z_NULL, 0);
+  crc = crc32(crc, reinterpret_cast<const Bytef*>(p_type), 4);
+  if (p_size > 0) {
+    crc = crc32(crc, p_data, p_size);
+  }
+  uint8_t checksum[4];
+  put_u32(checksum, crc);
+
+  file__.write(reinterpret_cast<const char*>(length), 4);
+  file__.write(p_type, 4);
+  file__.write(reinterpret_cast<const char*>(p_data), p_size);
+  file__.write(reinterpret_cast<const char*>(checksum), 4);
+  check_stream(file__, path__);
+}
+
+wfc::PpmWriter::PpmWriter(const std::string& p_path, size_t p_width, size_t p_height) :
+  file__(p_path, std::ios::binary),
+  path__(p_path),
+  width__(p_width),
+  height__(p_height),
+  lines__(0),
+  line__(p_width * 3) {
+
+  if (!file__) {
+    std::stringstream msg;
+    msg << "Failed to open output image " << path__;
+    throw std::runtime_error(msg.str());
+  }
+
+  file__ << "P6\n" << width__ << " " << height__ << "\n255\n";
+  check_stream(file__, path__);
+}
+
+void wfc::PpmWriter::write_band(const uint8_t* p_pixels, size_t p_pitch, size_t p_lines) {
+  if (lines__ + p_lines > height__) {
+    std::stringstream msg;
+    msg << "Too many lines written to " << path__;
+    throw std::runtime_error(msg.str());
+  }
+
+  /// Drop the alpha channel of every pixel
+
+  for (size_t y = 0; y < p_lines; ++y) {
+    const uint8_t* line = p_pixels + y * p_pitch;
+    for (size_t x = 0; x < width__; ++x) {
+      line__[x * 3] = line[x * 4];
+      line__[x * 3 + 1] = line[x * 4 + 1];
+      line__[x * 3 + 2] = line[x * 4 + 2];
+    }
+    file__.write(reinterpret_cast<const char*>(line__.data()), line__.size());
+  }
+
+  lines__ += p_lines;
+  check_stream(file__, path__);
+}
+
+void wfc::PpmWriter::finish() {
+  if (lines__ != height__) {
+    std::stringstream msg;
+    msg << "Only " << lines__ << " of " << height__ << " lines written to " << path__;
+    throw std::runtime_error(msg.str());
+  }
+
+  file__.close();
+  check_stream(file__, path__);
+}
@@ -0,0 +1,65 @@
+#include "wfc_mip_chain.h"
+
+#include <cstring>
+
+wfc::MipChain::MipChain(const uint8_t* p_pixels, size_t p_width, size_t p_height, size_t p_pitch) {
+
+  /// Copy the image as level 0 without padding between lines
+
+  Level image = {p_width, p_height, std::vector<uint8_t>(p_width * p_height * 4)};
+  for (size_t y = 0; y < p_height; ++y) {
+    std::memcpy(&image.pixels[y * p_width * 4], p_pixels + y * p_pitch, p_width * 4);
+  }
+  levels__.push_back(std::move(image));
+
+  /// Halve the last level until it is a single pixel, an odd line or column is averaged alone
+
+  while (levels__.back().width > 1 || levels__.back().height > 1) {
+    const Level& above = levels__.back();
+    Level level = {(above.width + 1) / 2, (above.height + 1) / 2, {}};
+    level.pixels.resize(level.width * level.height * 4);
+
+    for (size_t y = 0; y < level.height; ++y) {
+      size_t y0 = 2 * y;
+      size_t y1 = y0 + 1 < above.height ? y0 + 1 : y0;
+
+      for (size_t x = 0; x < level.width; ++x) {
+        size_t x0 = 2 * x;
+        size_t x1 = x0 + 1 < above.width ? x0 + 1 : x0;
+        size_t count = (y1 - y0 + 1) * (x1 - x0 + 1);
+
+        for (size_t c = 0; c < 4; ++c) {
+          unsigned sum = 0;
+          for (size_t sy = y0; sy <= y1; ++sy) {
+            for (size_t sx = x0; sx <= x1; ++sx) {
+              sum += above.pixels[(sy * above.width + sx) * 4 + c];
+            }
+          }
+          level.pixels[(y * level.width + x) * 4 + c] = (sum + count / 2) / count;
+        }
+      }
+    }
+
+    levels__.push_back(std::move(level));
+  }
+}
+
+size_t wfc::MipChain::get_level_count() const {
+  return levels__.size();
+}
+
+size_t wfc::MipChain::get_width(size_t p_level) const {
+  return levels__[p_level].width;
+}
+
+size_t wfc::MipChain::get_height(size_t p_level) const {
+  return levels__[p_level].height;
+}
+
+const uint8_t* wfc::MipChain::get_pixels(size_t p_level) const {
+  return levels__[p_level].pixels.data();
+}
+
+const uint8_t* wfc::MipChain::get_average() const {
+  return levels__.back().pixels.data();
+}
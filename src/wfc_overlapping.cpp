@@ -0,0 +1,412 @@
+#include "wfc_overlapping.h"
+#include "wfc_utils.h"
+
+#include <algorithm>
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+
+namespace {
+
+/// Multiplier of the rolling hash along the lines of a window
+const uint64_t LINE_BASE = 0x100000001b3ULL;
+
+/// Multiplier of the rolling hash across the lines of a window
+const uint64_t COLUMN_BASE = 0x9e3779b97f4a7c15ULL;
+
+/// Marks the end of a chain of windows with the same hash
+const uint32_t NO_WINDOW = UINT32_MAX;
+
+/// Offset of the neighbour in each direction, indexed by wfc::Directions
+const int DIRECTION_X[wfc::DIRECTION_COUNT] = {0, 1, 1, 1, 0, -1, -1, -1};
+const int DIRECTION_Y[wfc::DIRECTION_COUNT] = {-1, -1, 0, 1, 1, 1, 0, -1};
+
+/*
+ * One variant of the sample image, as RGBA32 colours without padding
+ */
+struct Image {
+  size_t width;
+  size_t height;
+  std::vector<uint32_t> pixels;
+
+  uint32_t at(size_t p_x, size_t p_y) const {
+    return pixels[(p_y % height) * width + p_x % width];
+  }
+};
+
+/*
+ * A distinct window of the sample variants and where it appears first
+ */
+struct Window {
+  uint64_t hash;
+  uint64_t first;    /// Index of the window among all windows of all variants
+  uint32_t variant;
+  uint32_t x;
+  uint32_t y;
+  uint32_t next;     /// Next window with the same hash, or NO_WINDOW
+  double count;
+};
+
+/*
+ * Mix the bits of a polynomial hash so that similar windows land in different buckets
+ */
+uint64_t mix(uint64_t p_hash) {
+  p_hash ^= p_hash >> 30;
+  p_hash *= 0xbf58476d1ce4e5b9ULL;
+  p_hash ^= p_hash >> 27;
+  p_hash *= 0x94d049bb133111ebULL;
+  return p_hash ^ (p_hash >> 31);
+}
+
+/*
+ * Get p_base raised to the power p_exp, modulo 2^64
+ */
+uint64_t power(uint64_t p_base, size_t p_exp) {
+  uint64_t result = 1;
+  for (size_t i = 0; i < p_exp; ++i) {
+    result *= p_base;
+  }
+  return result;
+}
+
+/*
+ * Windows of the sample variants keyed by their hash, two windows with the same hash are only
+ * merged when their pixels match
+ */
+class WindowTable {
+public:
+  WindowTable(const std::vector<Image>& p_variants, size_t p_size) :
+    variants__(p_variants),
+    size__(p_size) {
+  }
+
+  /*
+   * Add the count of a window to the matching window of the table, or add it as a new one
+   */
+  void add(const Window& p_window) {
+    auto [head, inserted] = heads__.try_emplace(p_window.hash, windows__.size());
+    if (!inserted) {
+      uint32_t idx = head->second;
+      while (true) {
+        Window& known = windows__[idx];
+        if (same__(known, p_window)) {
+          known.count += p_window.count;
+          return;
+        }
+        if (known.next == NO_WINDOW) {
+          known.next = windows__.size();
+          break;
+        }
+        idx = known.next;
+      }
+    }
+
+    windows__.push_back(p_window);
+    windows__.back().next = NO_WINDOW;
+  }
+
+  std::vector<Window>& get_windows() {
+    return windows__;
+  }
+
+private:
+  const std::vector<Image>& variants__;
+  const size_t size__;
+  std::unordered_map<uint64_t, uint32_t> heads__;
+  std::vector<Window> windows__;
+
+  bool same__(const Window& p_a, const Window& p_b) const {
+    const Image& a = variants__[p_a.variant];
+    const Image& b = variants__[p_b.variant];
+    for (size_t y = 0; y < size__; ++y) {
+      for (size_t x = 0; x < size__; ++x) {
+        if (a.at(p_a.x + x, p_a.y + y) != b.at(p_b.x + x, p_b.y + y)) {
+          return false;
+        }
+      }
+    }
+    return true;
+  }
+};
+
+/*
+ * Get the sample mirrored left to right
+ */
+Image reflect(const Image& p_image) {
+  Image result = {p_image.width, p_image.height, std::vector<uint32_t>(p_image.pixels.size())};
+  for (size_t y = 0; y < result.height; ++y) {
+    for (size_t x = 0; x < result.width; ++x) {
+      result.pixels[y * result.width + x] = p_image.at(p_image.width - 1 - x, y);
+    }
+  }
+  return result;
+}
+
+/*
+ * Get the sample rotated by a quarter turn
+ */
+Image rotate(const Image& p_image) {
+  Image result = {p_image.height, p_image.width, std::vector<uint32_t>(p_image.pixels.size())};
+  for (size_t y = 0; y < result.height; ++y) {
+    for (size_t x = 0; x < result.width; ++x) {
+      result.pixels[y * result.width + x] = p_image.at(p_image.width - 1 - y, x);
+    }
+  }
+  return result;
+}
+
+}
+
+wfc::OverlappingModel::OverlappingModel(const uint8_t* p_pixels, size_t p_width, size_t p_height, size_t p_pitch,
+                                        size_t p_size, size_t p_symmetry, bool p_periodic, wfc::DirectionType p_type,
+                                        size_t p_threads) :
+  size__(p_size) {
+
+  /// Check the pattern size and symmetry
+
+  if (p_size < 2 || p_size > p_width || p_size > p_height) {
+    std::stringstream msg;
+    msg << "Pattern size " << p_size << " must be at least 2 and fit in the " << p_width << "x" << p_height
+        << " sample";
+    throw std::runtime_error(msg.str());
+  }
+
+  if (p_symmetry < 1 || p_symmetry > 8) {
+    std::stringstream msg;
+    msg << "Symmetry " << p_symmetry << " must be between 1 and 8";
+    throw std::runtime_error(msg.str());
+  }
+
+  /// Copy the sample and build its variants, alternating reflections and quarter turns
+
+  std::vector<Image> variants;
+  variants.push_back({p_width, p_height, std::vector<uint32_t>(p_width * p_height)});
+  for (size_t y = 0; y < p_height; ++y) {
+    std::memcpy(&variants[0].pixels[y * p_width], p_pixels + y * p_pitch, p_width * 4);
+  }
+
+  for (size_t v = 1; v < p_symmetry; ++v) {
+    variants.push_back(v % 2 ? reflect(variants[v - 1]) : rotate(variants[v - 2]));
+  }
+
+  /// Count the windows of each variant, only whole windows unless they wrap around
+
+  std::vector<size_t> columns(variants.size());
+  std::vector<size_t> rows(variants.size());
+  std::vector<size_t> first_row(variants.size() + 1, 0);
+  std::vector<uint64_t> first_window(variants.size(), 0);
+  for (size_t v = 0; v < variants.size(); ++v) {
+    columns[v] = p_periodic ? variants[v].width : variants[v].width - p_size + 1;
+    rows[v] = p_periodic ? variants[v].height : variants[v].height - p_size + 1;
+    first_row[v + 1] = first_row[v] + rows[v];
+    if (v > 0) {
+      first_window[v] = first_window[v - 1] + columns[v - 1] * rows[v - 1];
+    }
+  }
+
+  /// Hash the windows of a range of rows on each thread and count them in a table per thread
+
+  size_t threads = std::max<size_t>(p_threads, 1);
+  std::vector<WindowTable> tables(threads, WindowTable(variants, p_size));
+  const uint64_t line_top = power(LINE_BASE, p_size - 1);
+  const uint64_t column_top = power(COLUMN_BASE, p_size - 1);
+
+  wfc::parallel_for(first_row.back(), threads, [&](size_t p_begin, size_t p_end, size_t p_thread) {
+    WindowTable& table = tables[p_thread];
+    std::vector<std::vector<uint64_t>> lines(p_size);
+    std::vector<uint64_t> hashes;
+    size_t v = 0;
+
+    /// Hash the N pixels from each column of a line of the current variant
+
+    auto hash_line = [&](size_t p_y, std::vector<uint64_t>& p_out) {
+      const Image& image = variants[v];
+      p_out.resize(columns[v]);
+      uint64_t hash = 0;
+      for (size_t x = 0; x < p_size; ++x) {
+        hash = hash * LINE_BASE + image.at(x, p_y);
+      }
+      p_out[0] = hash;
+      for (size_t x = 1; x < columns[v]; ++x) {
+        hash = (hash - image.at(x - 1, p_y) * line_top) * LINE_BASE + image.at(x + p_size - 1, p_y);
+        p_out[x] = hash;
+      }
+    };
+
+    for (size_t row = p_begin; row < p_end; ++row) {
+      bool restart = row == p_begin;
+      while (row >= first_row[v + 1]) {
+        ++v;
+        restart = true;
+      }
+      size_t y = row - first_row[v];
+
+      if (restart) {
+
+        /// Hash the N lines of the first window row from scratch
+
+        hashes.assign(columns[v], 0);
+        for (size_t j = 0; j < p_size; ++j) {
+          std::vector<uint64_t>& line = lines[(y + j) % p_size];
+          hash_line(y + j, line);
+          for (size_t x = 0; x < columns[v]; ++x) {
+            hashes[x] = hashes[x] * COLUMN_BASE + line[x];
+          }
+        }
+      }
+      else {
+
+        /// Roll down one line, the new line takes the slot of the one that left
+
+        std::vector<uint64_t>& line = lines[(y + p_size - 1) % p_size];
+        for (size_t x = 0; x < columns[v]; ++x) {
+          hashes[x] -= line[x] * column_top;
+        }
+        hash_line(y + p_size - 1, line);
+        for (size_t x = 0; x < columns[v]; ++x) {
+          hashes[x] = hashes[x] * COLUMN_BASE + line[x];
+        }
+      }
+
+      for (size_t x = 0; x < columns[v]; ++x) {
+        table.add({mix(hashes[x]), first_window[v] + y * columns[v] + x, static_cast<uint32_t>(v),
+                   static_cast<uint32_t>(x), static_cast<uint32_t>(y), NO_WINDOW, 1.0});
+      }
+    }
+  });
+
+  /// Merge the tables in the order the windows first appear so the ids do not depend on the threads
+
+  std::vector<Window> windows;
+  for (WindowTable& table : tables) {
+    windows.insert(windows.end(), table.get_windows().begin(), table.get_windows().end());
+  }
+  std::sort(windows.begin(), windows.end(), [](const Window& a, const Window& b) {
+    return a.first < b.first;
+  });
+
+  WindowTable merged(variants, p_size);
+  for (const Window& window : windows) {
+    merged.add(window);
+  }
+
+  /// Stop before building the compatibility of more patterns than a solver can take
+
+  size_t pattern_count = merged.get_windows().size();
+  if (pattern_count > MAX_PATTERNS) {
+    std::stringstream msg;
+    msg << "Sample has " << pattern_count << " distinct " << p_size << "x" << p_size << " patterns but at most "
+        << MAX_PATTERNS << " are supported, try a smaller size or a sample with fewer colours";
+    throw std::runtime_error(msg.str());
+  }
+
+  /// Copy out the pixels and counts of the distinct windows
+
+  size_t area = p_size * p_size;
+  patterns__.resize(pattern_count * area);
+  weights__.resize(pattern_count);
+  for (size_t p = 0; p < pattern_count; ++p) {
+    const Window& window = merged.get_windows()[p];
+    const Image& image = variants[window.variant];
+    for (size_t y = 0; y < p_size; ++y) {
+      for (size_t x = 0; x < p_size; ++x) {
+        patterns__[p * area + y * p_size + x] = image.at(window.x + x, window.y + y);
+      }
+    }
+    weights__[p] = window.count;
+  }
+
+  /// Hash the pixels each pattern shares with its neighbour in every direction
+
+  auto overlap = [p_size](size_t p_dir, size_t& p_x0, size_t& p_x1, size_t& p_y0, size_t& p_y1) {
+    p_x0 = std::max(DIRECTION_X[p_dir], 0);
+    p_x1 = p_size + std::min(DIRECTION_X[p_dir], 0);
+    p_y0 = std::max(DIRECTION_Y[p_dir], 0);
+    p_y1 = p_size + std::min(DIRECTION_Y[p_dir], 0);
+  };
+
+  std::vector<uint64_t> keys(pattern_count * wfc::DIRECTION_COUNT);
+  wfc::parallel_for(pattern_count, threads, [&](size_t p_begin, size_t p_end, size_t) {
+    for (size_t p = p_begin; p < p_end; ++p) {
+      const uint32_t* pattern = get_pattern(p);
+      for (size_t d = 0; d < wfc::DIRECTION_COUNT; ++d) {
+        size_t x0, x1, y0, y1;
+        overlap(d, x0, x1, y0, y1);
+        uint64_t hash = 0;
+        for (size_t y = y0; y < y1; ++y) {
+          for (size_t x = x0; x < x1; ++x) {
+            hash = hash * LINE_BASE + pattern[y * p_size + x];
+          }
+        }
+        keys[p * wfc::DIRECTION_COUNT + d] = mix(hash);
+      }
+    }
+  });
+
+  /// Pattern b fits in direction d of pattern a when the part of a that b covers, hashed for d,
+  /// matches the part of b that a covers, hashed for the opposite of d
+
+  size_t dir_step = (p_type == wfc::DirectionType::OCT_DIRECTIONS) ? 1 : 2;
+  compatible__.build(pattern_count, threads, dir_step, [&](size_t p_dir) {
+    size_t opp = static_cast<size_t>(wfc::opposite(static_cast<wfc::Directions>(p_dir)));
+
+    std::vector<std::pair<uint64_t, uint32_t>> sorted(pattern_count);
+    for (size_t p = 0; p < pattern_count; ++p) {
+      sorted[p] = {keys[p * wfc::DIRECTION_COUNT + opp], static_cast<uint32_t>(p)};
+    }
+    std::sort(sorted.begin(), sorted.end());
+
+    size_t x0, x1, y0, y1;
+    overlap(p_dir, x0, x1, y0, y1);
+    int dx = DIRECTION_X[p_dir];
+    int dy = DIRECTION_Y[p_dir];
+
+    return [this, &keys, sorted = std::move(sorted), p_dir, p_size, x0, x1, y0, y1, dx, dy](
+        size_t p_a, std::vector<uint32_t>& p_out) {
+      const uint32_t* pattern_a = get_pattern(p_a);
+      uint64_t key = keys[p_a * wfc::DIRECTION_COUNT + p_dir];
+      auto first = std::lower_bound(sorted.begin(), sorted.end(), std::make_pair(key, uint32_t(0)));
+      for (auto it = first; it != sorted.end() && it->first == key; ++it) {
+
+        /// Check the shared pixels in case two overlaps have the same hash
+
+        const uint32_t* pattern_b = get_pattern(it->second);
+        bool agrees = true;
+        for (size_t y = y0; agrees && y < y1; ++y) {
+          for (size_t x = x0; agrees && x < x1; ++x) {
+            agrees = pattern_a[y * p_size + x] == pattern_b[(y - dy) * p_size + (x - dx)];
+          }
+        }
+        if (agrees) {
+          p_out.push_back(it->second);
+        }
+      }
+    };
+  });
+}
+
+size_t wfc::OverlappingModel::get_size() const {
+  return size__;
+}
+
+size_t wfc::OverlappingModel::get_pattern_count() const {
+  return weights__.size();
+}
+
+const uint32_t* wfc::OverlappingModel::get_pattern(size_t p_pattern) const {
+  return &patterns__[p_pattern * size__ * size__];
+}
+
+double wfc::OverlappingModel::get_weight(size_t p_pattern) const {
+  return weights__[p_pattern];
+}
+
+const uint32_t* wfc::OverlappingModel::get_compatible(size_t p_pattern, wfc::Directions p_dir) const {
+  return compatible__.get(p_pattern, p_dir);
+}
+
+size_t wfc::OverlappingModel::get_compatible_count(size_t p_pattern, wfc::Directions p_dir) const {
+  return compatible__.get_count(p_pattern, p_dir);
+}
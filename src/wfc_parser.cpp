@@ -1,9 +1,10 @@
 #include "wfc_parser.h"
-#include "wfc_canvas.h"
 #include "wfc.h"
-#include "wfc_utils.h"
 #include "wfc_log.h"
 
+#include <algorithm>
+#include <cctype>
+#include <iterator>
 #include <sstream>
 #include <fstream>
 #include <iostream>
@@ -11,6 +12,30 @@
 using json = nlohmann::json;
 namespace fs = std::filesystem;
 
+namespace {
+
+/// Directions with the names expected in the config file
+
+const std::pair<wfc::Directions, const char*> DIRECTION_NAMES[] = {
+  {wfc::Directions::NORTH, "north"},
+  {wfc::Directions::NORTH_EAST, "north_east"},
+  {wfc::Directions::EAST, "east"},
+  {wfc::Directions::SOUTH_EAST, "south_east"},
+  {wfc::Directions::SOUTH, "south"},
+  {wfc::Directions::SOUTH_WEST, "south_west"},
+  {wfc::Directions::WEST, "west"},
+  {wfc::Directions::NORTH_WEST, "north_west"},
+};
+
+/*
+ * Get the name of variant p_variant of a tile, variant 0 is the tile itself
+ */
+std::string variant_name(const std::string& p_name, size_t p_variant) {
+  return p_variant == 0 ? p_name : p_name + "#" + std::to_string(p_variant);
+}
+
+}
+
 wfc::Parser::Parser(const std::string& p_config_path) :
   config_path__(fs::absolute(p_config_path)) {
 
@@ -63,9 +88,14 @@ void wfc::Parser::parse_canvas(wfc::CanvasInfo& p_canvas_info) const {
     throw std::runtime_error(msg.str());
   }
 
+  p_canvas_info.edge_tolerance = 0;
+  if (section.contains("edge_tolerance")) {
+    p_canvas_info.edge_tolerance = parse_positive_int__(section, "edge_tolerance", "/canvas");
+  }
 }
 
-void wfc::Parser::parse_tiles(std::vector<TileInfo>& p_tiles, const wfc::GroupInfo& p_groups) const {
+void wfc::Parser::parse_tiles(std::vector<TileInfo>& p_tiles, const wfc::GroupInfo& p_groups,
+                              wfc::TileRegistry& p_registry) const {
 
   /// Check if tiles section is defined
 
@@ -75,29 +105,84 @@ void wfc::Parser::parse_tiles(std::vector<TileInfo>& p_tiles, const wfc::GroupIn
     throw std::runtime_error(msg.str());
   }
 
-  auto parse_tile_section = [this, &p_groups, &p_tiles](const json& section){
+  /// Read every tile before its rules, so rules can name tiles defined after them
+
+  std::vector<const json*> rule_sections;
+  auto parse_tile_section = [this, &p_tiles, &rule_sections](const json& section){
     for (auto& [key, item]: section.items()) {
       const std::string path = parse_string__(item, "path", "/tiles/" + key);
       wfc::TileInfo tile(key, fs::absolute(path));
 
-      if (!item.contains("rules")) {
+      if (item.contains("weight")) {
+        tile.weight = parse_positive_number__(item, "weight", "/tiles/" + key);
+      }
+
+      if (item.contains("symmetry")) {
+        const std::string symmetry = parse_string__(item, "symmetry", "/tiles/" + key);
+        if (symmetry == "X") {
+          tile.symmetry = wfc::Symmetry::X;
+        }
+        else if (symmetry == "I") {
+          tile.symmetry = wfc::Symmetry::I;
+        }
+        else if (symmetry == "\\") {
+          tile.symmetry = wfc::Symmetry::BACKSLASH;
+        }
+        else if (symmetry == "T") {
+          tile.symmetry = wfc::Symmetry::T;
+        }
+        else if (symmetry == "L") {
+          tile.symmetry = wfc::Symmetry::L;
+        }
+        else if (symmetry == "F") {
+          tile.symmetry = wfc::Symmetry::F;
+        }
+        else {
+          std::stringstream msg;
+          msg << "Path \"/tiles/" << key << "/symmetry\" must be one of \"X\", \"I\", \"\\\\\", \"T\", \"L\" or \"F\""
+              << " in config file " << config_path__;
+          throw std::runtime_error(msg.str());
+        }
+      }
+
+      /// Tiles with sockets only need rules for the neighbours their sockets do not cover
+
+      if (item.contains("sockets")) {
+        parse_tile_sockets__(tile, item["sockets"]);
+      }
+      else if (!item.contains("rules")) {
         std::stringstream msg;
         msg << "Path \"/tiles/" << key << "/rules\" is missing in config file " << config_path__;
         throw std::runtime_error(msg.str());
       }
 
-      parse_tile_rules__(tile, item["rules"], p_groups);
+      /// Rules can be inferred from the edges of the tile images instead of listed
+
+      if (item.contains("rules") && item["rules"].is_string()) {
+        if (item["rules"] != "auto") {
+          std::stringstream msg;
+          msg << "Path \"/tiles/" << key << "/rules\" must be an object or \"auto\" in config file " << config_path__;
+          throw std::runtime_error(msg.str());
+        }
+        tile.auto_rules = true;
+        rule_sections.push_back(nullptr);
+      }
+      else {
+        rule_sections.push_back(item.contains("rules") ? &item["rules"] : nullptr);
+      }
       p_tiles.emplace_back(tile);
     }
   };
 
-  auto& section = config_json__["tiles"];
+  const json& section = config_json__["tiles"];
+  std::vector<json> sub_configs;  /// Kept until the rules they hold are parsed
 
   if (section.is_object()) { /// If tiles section is object then parse the tiles
     parse_tile_section(section);
   }
 
   else if (section.is_array()) { /// If tiles section is an array then it is a list of sub config files
+    sub_configs.reserve(section.size());
     for (auto& v : section) {
       /// Save current directory
 
@@ -111,8 +196,8 @@ void wfc::Parser::parse_tiles(std::vector<TileInfo>& p_tiles, const wfc::GroupIn
       /// Parse sub config file
 
       wfc::Log::info("Parsing sub config file at " + sub_config_path.string() + "...");
-      json sub_config = open_sub_config__(sub_config_path.filename());
-      parse_tile_section(sub_config);
+      sub_configs.push_back(open_sub_config__(sub_config_path.filename()));
+      parse_tile_section(sub_configs.back());
 
       /// Restore directory
 
@@ -125,9 +210,82 @@ void wfc::Parser::parse_tiles(std::vector<TileInfo>& p_tiles, const wfc::GroupIn
     throw std::runtime_error(msg.str());
   }
 
-  /// Resolve rules of tiles that were defined using inversion
+  /// Intern the names of all tiles once, each tile followed by its variants
 
+  size_t variant_total = 0;
+  for (const TileInfo& tile : p_tiles) {
+    variant_total += wfc::variant_count(tile.symmetry);
+  }
+
+  wfc::TileRegistry registry;
+  registry.reserve(variant_total);
+  for (TileInfo& tile : p_tiles) {
+    tile.id = registry.size();
+    for (size_t v = 0; v < wfc::variant_count(tile.symmetry); ++v) {
+      size_t count = registry.size();
+      const std::string name = variant_name(tile.name, v);
+      if (registry.intern(name) != count) {
+        std::stringstream msg;
+        msg << "Tile with name " << name << " is defined more than once in config file " << config_path__;
+        throw std::runtime_error(msg.str());
+      }
+    }
+  }
+
+  /// Resolve the rules to ids now that every tile has one
+
+  for (size_t t = 0; t < p_tiles.size(); ++t) {
+    if (rule_sections[t] != nullptr) {
+      parse_tile_rules__(p_tiles[t], *rule_sections[t], p_groups, registry);
+    }
+  }
+
+  /// Add the variants of symmetric tiles, then resolve rules of tiles that were defined using
+  /// inversion against every variant
+
+  add_tile_variants__(p_tiles);
   resolve_tile_inversion__(p_tiles);
+
+  /// The names keep their ids, so the solver can take them as they are
+
+  p_registry = std::move(registry);
+}
+
+bool wfc::Parser::has_sample() const {
+  return config_json__.contains("sample");
+}
+
+void wfc::Parser::parse_sample(wfc::SampleInfo& p_sample_info) const {
+
+  /// Check if sample section is defined
+
+  if (!has_sample()) {
+    std::stringstream msg;
+    msg << "Path \"/sample\" is missing in config file " << config_path__;
+    throw std::runtime_error(msg.str());
+  }
+
+  /// Parse values in sample section, everything but the path is optional
+
+  auto& section = config_json__["sample"];
+  p_sample_info.path = fs::absolute(parse_string__(section, "path", "/sample"));
+
+  if (section.contains("size")) {
+    p_sample_info.size = parse_positive_int__(section, "size", "/sample");
+  }
+
+  if (section.contains("symmetry")) {
+    p_sample_info.symmetry = parse_positive_int__(section, "symmetry", "/sample");
+    if (p_sample_info.symmetry > 8) {
+      std::stringstream msg;
+      msg << "Path \"/sample/symmetry\" must be between 1 and 8 in config file " << config_path__;
+      throw std::runtime_error(msg.str());
+    }
+  }
+
+  if (section.contains("periodic")) {
+    p_sample_info.periodic = parse_bool__(section, "periodic", "/sample");
+  }
 }
 
 void wfc::Parser::parse_groups(wfc::GroupInfo& p_group) const {
@@ -232,6 +390,28 @@ size_t wfc::Parser::parse_positive_int__(const json& section, const std::string&
   return section[p_key];
 }
 
+double wfc::Parser::parse_positive_number__(const json& section, const std::string& p_key,
+                                           const std::string& p_path) const {
+  /// Check if the key exists
+
+  if (!section.contains(p_key)) {
+    std::stringstream msg;
+    msg << "Path \"" << p_path << "/" << p_key << "\" is missing in config file " << config_path__;
+    throw std::runtime_error(msg.str());
+  }
+
+  /// Check if the key is a number greater than zero
+
+  if (!section[p_key].is_number() || section[p_key].get<double>() <= 0) {
+    std::stringstream msg;
+    msg << "Path \"" << p_path << "/" << p_key << "\" is expected to be a positive number in config file ";
+    msg << config_path__;
+    throw std::runtime_error(msg.str());
+  }
+
+  return section[p_key];
+}
+
 std::string wfc::Parser::parse_string__(const json& section, const std::string& p_key,
                                         const std::string& p_path) const {
 
@@ -276,51 +456,51 @@ bool wfc::Parser::parse_bool__(const json& section, const std::string& p_key,
   return section[p_key];
 }
 
-void wfc::Parser::parse_tile_rules__(TileInfo& p_tile, const json& p_section, const wfc::GroupInfo& p_group_info) const {
+void wfc::Parser::parse_tile_rules__(TileInfo& p_tile, const json& p_section, const wfc::GroupInfo& p_group_info,
+                                     const wfc::TileRegistry& p_registry) const {
   auto& groups = p_group_info.groups;
-  using wfc::Directions;
-
-  /// Map enums to the strings expected in the config file
-
-  std::unordered_map<wfc::Directions, std::string> dir_map = {
-    {Directions::NORTH, "north"},
-    {Directions::NORTH_EAST, "north_east"},
-    {Directions::EAST, "east"},
-    {Directions::SOUTH_EAST, "south_east"},
-    {Directions::SOUTH, "south"},
-    {Directions::SOUTH_WEST, "south_west"},
-    {Directions::WEST, "west"},
-    {Directions::NORTH_WEST, "north_west"},
-  };
 
-  auto add_rules = [&groups, &p_tile](wfc::Directions key, std::vector<std::string>& rules) {
-    std::unordered_set<std::string> rule_set;
+  auto add_rules = [this, &groups, &p_registry, &p_tile](wfc::Directions key, const std::string& p_key,
+                                                         const std::vector<std::string>& rules) {
+    std::vector<uint32_t>& ids = p_tile.rules[key];
+    auto add_rule = [this, &p_registry, &p_tile, &p_key, &ids](const std::string& p_name) {
+      uint32_t id = p_registry.find(p_name);
+      if (id == wfc::NO_TILE) {
+        std::stringstream msg;
+        msg << "Path \"/tiles/" << p_tile.name << "/rules/" << p_key << "\" names unknown tile " << p_name
+            << " in config file " << config_path__;
+        throw std::runtime_error(msg.str());
+      }
+      ids.push_back(id);
+    };
+
     for (const std::string& rule : rules) {
       if (groups.find(rule) != groups.end()) {
         for (const std::string& gr: groups.at(rule)) {
-          rule_set.insert(gr);
+          add_rule(gr);
         }
       }
       else {
-        rule_set.insert(rule);
+        add_rule(rule);
       }
     }
-    p_tile.rules[key] = rule_set;
+    std::sort(ids.begin(), ids.end());
+    ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
   };
 
   /// Go through all the rules of the tile
 
-  for (const auto& [key, value] : dir_map) {
-    std::string negation_value = "!" + value;
+  for (const auto& [key, value] : DIRECTION_NAMES) {
+    std::string negation_value = "!" + std::string(value);
 
     if (p_section.contains(negation_value)) { /// Check if the rule for the direction is negated
       std::vector<std::string> rule_vec = p_section[negation_value].get<std::vector<std::string>>();
-      add_rules(key, rule_vec);
+      add_rules(key, negation_value, rule_vec);
       p_tile.directions_to_invert.insert(key);
     }
     else if (p_section.contains(value)) { /// Check if the rule for the direction exists
       std::vector<std::string> rule_vec = p_section[value].get<std::vector<std::string>>();
-      add_rules(key, rule_vec);
+      add_rules(key, value, rule_vec);
     }
     else { /// The rule for the direction is empty
       p_tile.rules[key] = {};
@@ -328,23 +508,102 @@ void wfc::Parser::parse_tile_rules__(TileInfo& p_tile, const json& p_section, co
   }
 }
 
-void wfc::Parser::resolve_tile_inversion__(std::vector<TileInfo>& p_tiles) const {
+void wfc::Parser::parse_tile_sockets__(TileInfo& p_tile, const json& p_section) const {
+  const std::string path = "/tiles/" + p_tile.name + "/sockets";
+
+  if (!p_section.is_object()) {
+    std::stringstream msg;
+    msg << "Path \"" << path << "\" is expected to be an object in config file " << config_path__;
+    throw std::runtime_error(msg.str());
+  }
+
+  for (const auto& [key, value] : p_section.items()) {
+    const auto* found = std::find_if(std::begin(DIRECTION_NAMES), std::end(DIRECTION_NAMES),
+                                     [&key](const auto& p_item) { return key == p_item.second; });
+    if (found == std::end(DIRECTION_NAMES)) {
+      std::stringstream msg;
+      msg << "Path \"" << path << "/" << key << "\" is not a direction in config file " << config_path__;
+      throw std::runtime_error(msg.str());
+    }
+    p_tile.sockets[found->first] = parse_string__(p_section, key, path);
+  }
+}
 
-  /// Collect names of all tiles
+void wfc::Parser::add_tile_variants__(std::vector<TileInfo>& p_tiles) const {
 
-  std::unordered_set<std::string> all_tile_names;
+  /// Collect the id of the base tile and the symmetry of every id, the variants of a tile have the
+  /// ids right after it
+
+  std::vector<uint32_t> base_ids;
+  std::vector<wfc::Symmetry> symmetries;
   for (const TileInfo& tile : p_tiles) {
-    all_tile_names.insert(tile.name);
+    base_ids.resize(base_ids.size() + wfc::variant_count(tile.symmetry), tile.id);
+    symmetries.resize(base_ids.size(), tile.symmetry);
+  }
+
+  /// A rule naming variant k of a tile names the variant it becomes under the transform
+
+  auto transform_id = [&base_ids, &symmetries](uint32_t p_id, size_t p_transform) {
+    uint32_t base = base_ids[p_id];
+    return static_cast<uint32_t>(base + wfc::transform_variant(symmetries[p_id], p_id - base, p_transform));
+  };
+
+  /// Put the variants of a tile right after it so they get neighbouring ids
+
+  std::vector<TileInfo> tiles;
+  tiles.reserve(base_ids.size());
+  for (const TileInfo& base : p_tiles) {
+    for (size_t v = 0; v < wfc::variant_count(base.symmetry); ++v) {
+      TileInfo tile(variant_name(base.name, v), base.path);
+      tile.id = base.id + v;
+      tile.weight = base.weight;
+      tile.auto_rules = base.auto_rules;
+      tile.symmetry = base.symmetry;
+      tile.transform = v;
+
+      for (const auto& [dir, ids] : base.rules) {
+        std::vector<uint32_t>& rule_ids = tile.rules[wfc::transform_direction(dir, v)];
+        for (uint32_t id : ids) {
+          rule_ids.push_back(transform_id(id, v));
+        }
+        std::sort(rule_ids.begin(), rule_ids.end());
+      }
+      for (const wfc::Directions& dir : base.directions_to_invert) {
+        tile.directions_to_invert.insert(wfc::transform_direction(dir, v));
+      }
+
+      /// Mirroring a tile reverses its sockets along with their order around it
+
+      for (const auto& [dir, socket] : base.sockets) {
+        tile.sockets[wfc::transform_direction(dir, v)] = v >= 4 ? wfc::mirror_socket(socket) : socket;
+      }
+      tiles.emplace_back(std::move(tile));
+    }
   }
+  p_tiles = std::move(tiles);
+}
+
+void wfc::Parser::resolve_tile_inversion__(std::vector<TileInfo>& p_tiles) const {
 
   /// Go throug all tiles and see if any of their rules is neagated
 
+  std::vector<uint8_t> named(p_tiles.size());
   for (TileInfo& tile : p_tiles) {
     for (const wfc::Directions& dir : tile.directions_to_invert) {
 
-      /// Negate the rule set
+      /// Negate the rule set against the ids of all tiles
 
-      tile.rules[dir] = set_difference(all_tile_names, tile.rules[dir]);
+      std::vector<uint32_t>& ids = tile.rules[dir];
+      std::fill(named.begin(), named.end(), 0);
+      for (uint32_t id : ids) {
+        named[id] = 1;
+      }
+      ids.clear();
+      for (size_t t = 0; t < p_tiles.size(); ++t) {
+        if (!named[t]) {
+          ids.push_back(t);
+        }
+      }
     }
   }
 }
@@ -0,0 +1,106 @@
+#include "wfc_portfolio.h"
+#include "wfc_random.h"
+
+#include <thread>
+
+wfc::Portfolio::Portfolio(const wfc::Solver& p_solver, size_t p_threads) :
+  next_attempt__(0),
+  best_attempt__(NPOS),
+  winner__(NPOS) {
+
+  /// Compile the rules once before copying, the copies only read the shared tiles
+
+  size_t threads = p_threads > 0 ? p_threads : 1;
+  solvers__.reserve(threads);
+  solvers__.push_back(p_solver);
+  solvers__[0].compile_rules();
+
+  for (size_t i = 1; i < threads; ++i) {
+    solvers__.push_back(solvers__[0]);
+  }
+  solved__.assign(threads, NPOS);
+}
+
+bool wfc::Portfolio::solve(uint64_t p_seed, size_t p_max_attempts) {
+  next_attempt__ = 0;
+  best_attempt__ = NPOS;
+  winner__ = NPOS;
+  solved__.assign(solvers__.size(), NPOS);
+
+  /// Race the attempts, the calling thread takes part as thread 0
+
+  std::vector<std::thread> threads;
+  for (size_t t = 1; t < solvers__.size(); ++t) {
+    threads.emplace_back(&wfc::Portfolio::run__, this, t, p_seed, p_max_attempts);
+  }
+  run__(0, p_seed, p_max_attempts);
+
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+
+  /// Find the solver that finished the winning attempt
+
+  for (size_t t = 0; t < solvers__.size(); ++t) {
+    if (solved__[t] != NPOS && solved__[t] == best_attempt__) {
+      winner__ = t;
+    }
+  }
+
+  return winner__ != NPOS;
+}
+
+const wfc::Solver& wfc::Portfolio::get_result() const {
+  return solvers__[winner__];
+}
+
+size_t wfc::Portfolio::get_attempt() const {
+  return best_attempt__;
+}
+
+void wfc::Portfolio::run__(size_t p_thread, uint64_t p_seed, size_t p_max_attempts) {
+  wfc::Solver& solver = solvers__[p_thread];
+  wfc::Random stream(p_seed);
+  size_t position = 0;
+
+  while (true) {
+
+    /// Stop once no remaining attempt can beat the best one
+
+    size_t attempt = next_attempt__.fetch_add(1);
+    if (attempt >= best_attempt__.load() || (p_max_attempts > 0 && attempt >= p_max_attempts)) {
+      return;
+    }
+
+    /// Move the stream forward to the stream of the attempt
+
+    for (; position < attempt; ++position) {
+      stream.jump();
+    }
+
+    solver.set_random(stream);
+    solver.reset();
+
+    /// Collapse until done, a contradiction or a lower attempt finishing first
+
+    bool solved = true;
+    while (!solver.is_collapsed()) {
+      if (best_attempt__.load(std::memory_order_relaxed) < attempt || !solver.collapse_next()) {
+        solved = false;
+        break;
+      }
+    }
+
+    if (solved) {
+      solved__[p_thread] = attempt;
+      finish__(attempt);
+      return;
+    }
+  }
+}
+
+void wfc::Portfolio::finish__(size_t p_attempt) {
+  size_t best = best_attempt__.load();
+  while (p_attempt < best && !best_attempt__.compare_exchange_weak(best, p_attempt)) {
+  }
+}
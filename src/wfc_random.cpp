@@ -1,11 +1,29 @@
 #include "wfc_random.h"
 
+#include <random>
 
-void wfc::Random::seed(unsigned int p_seed) {
+wfc::Random::Random() {
 
-  /// Set seed for the static random engine
+  /// Seed from the system when no seed is given
 
-    get_engine__() = std::mt19937(p_seed);
+  std::random_device device;
+  seed((static_cast<uint64_t>(device()) << 32) | device());
+}
+
+wfc::Random::Random(uint64_t p_seed) {
+  seed(p_seed);
+}
+
+void wfc::Random::seed(uint64_t p_seed) {
+
+  /// Expand the seed into the state with splitmix64 so similar seeds give unrelated states
+
+  for (uint64_t& word : state__) {
+    uint64_t z = (p_seed += 0x9e3779b97f4a7c15);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+    word = z ^ (z >> 31);
+  }
 }
 
 int wfc::Random::int_from_range(int p_min, int p_max) {
@@ -18,14 +36,51 @@ int wfc::Random::int_from_range(int p_min, int p_max) {
 
   /// Generate random integer in the range
 
-  std::uniform_int_distribution<> dist(p_min, p_max - 1);
-  return dist(get_engine__());
+  uint64_t span = static_cast<uint64_t>(static_cast<int64_t>(p_max) - p_min);
+  return static_cast<int>(p_min + static_cast<int64_t>(int_below(span)));
+}
+
+double wfc::Random::real_from_range(double p_min, double p_max) {
+
+  /// Check if min is less than max
+
+  if (p_min >= p_max) {
+    throw std::invalid_argument("min must be less than max");
+  }
+
+  /// Use the top 53 bits as the fraction of a double in [0, 1)
+
+  double unit = static_cast<double>(next() >> 11) * 0x1.0p-53;
+  double result = p_min + unit * (p_max - p_min);
+  return result < p_max ? result : p_min;
 }
 
-std::mt19937& wfc::Random::get_engine__() {
+void wfc::Random::jump() {
+  static const uint64_t JUMP[] = {
+    0x180ec6d33cfd0aba, 0xd5a61266f0c9392c, 0xa9582618e03fc9aa, 0x39abdc4529b1661c
+  };
 
-  /// Define the static random number generator
+  /// Combine the states reached at the set bits of the jump polynomial
+
+  uint64_t s[4] = {0, 0, 0, 0};
+  for (uint64_t word : JUMP) {
+    for (int b = 0; b < 64; ++b) {
+      if (word & (uint64_t(1) << b)) {
+        for (int i = 0; i < 4; ++i) {
+          s[i] ^= state__[i];
+        }
+      }
+      next();
+    }
+  }
+
+  for (int i = 0; i < 4; ++i) {
+    state__[i] = s[i];
+  }
+}
 
-  static std::mt19937 gen{std::random_device{}()};
-  return gen;
+wfc::Random wfc::Random::split() {
+  Random stream = *this;
+  jump();
+  return stream;
 }
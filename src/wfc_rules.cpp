@@ -0,0 +1,153 @@
+#include "wfc_rules.h"
+#include "wfc_domain.h"
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+wfc::Rules::Rules() :
+  tile_count__(0),
+  words__(0),
+  table__(nullptr) {
+}
+
+void wfc::Rules::set_tiles__(const std::vector<wfc::Tile*>& p_tiles) {
+  tile_count__ = p_tiles.size();
+  words__ = wfc::Domains::words_for(tile_count__);
+
+  /// Store the weights used for entropy and tile selection
+
+  weights__.resize(tile_count__);
+  weight_log_weights__.resize(tile_count__);
+  for (size_t t = 0; t < tile_count__; ++t) {
+    weights__[t] = p_tiles[t]->get_weight();
+    weight_log_weights__[t] = weights__[t] * std::log(weights__[t]);
+  }
+}
+
+void wfc::Rules::load(const std::vector<wfc::Tile*>& p_tiles, const uint64_t* p_table,
+                      std::shared_ptr<const void> p_owner) {
+  set_tiles__(p_tiles);
+  table__ = p_table;
+  owner__ = std::move(p_owner);
+}
+
+void wfc::Rules::compile(const std::vector<wfc::Tile*>& p_tiles, wfc::DirectionType p_type) {
+  set_tiles__(p_tiles);
+
+  /// Build a new table, copies of the rules keep sharing the old one
+
+  auto storage = std::make_shared<std::vector<uint64_t>>(table_size(), 0);
+  std::vector<uint64_t>& table = *storage;
+
+  size_t dir_step = (p_type == wfc::DirectionType::OCT_DIRECTIONS) ? 1 : 2;
+
+  /// Group the tiles by the socket of each side, so a side finds the tiles with the socket it needs
+  /// without comparing itself to every tile
+
+  size_t socket_count = 0;
+  for (const wfc::Tile* tile : p_tiles) {
+    for (size_t d = 0; d < wfc::DIRECTION_COUNT; ++d) {
+      uint32_t socket = tile->get_socket(static_cast<wfc::Directions>(d));
+      if (socket != wfc::NO_SOCKET) {
+        socket_count = std::max<size_t>(socket_count, socket + 1);
+      }
+    }
+  }
+
+  std::vector<size_t> socket_starts(wfc::DIRECTION_COUNT * (socket_count + 1), 0);
+  std::vector<uint32_t> socket_members;
+  for (size_t d = 0; d < wfc::DIRECTION_COUNT && socket_count > 0; ++d) {
+    size_t* starts = &socket_starts[d * (socket_count + 1)];
+    for (const wfc::Tile* tile : p_tiles) {
+      uint32_t socket = tile->get_socket(static_cast<wfc::Directions>(d));
+      if (socket != wfc::NO_SOCKET) {
+        ++starts[socket + 1];
+      }
+    }
+
+    /// Turn the counts into the start of each group among the tiles with a socket on side d
+
+    starts[0] = socket_members.size();
+    for (size_t s = 0; s < socket_count; ++s) {
+      starts[s + 1] += starts[s];
+    }
+
+    socket_members.resize(starts[socket_count]);
+    std::vector<size_t> next(starts, starts + socket_count);
+    for (size_t t = 0; t < tile_count__; ++t) {
+      uint32_t socket = p_tiles[t]->get_socket(static_cast<wfc::Directions>(d));
+      if (socket != wfc::NO_SOCKET) {
+        socket_members[next[socket]++] = t;
+      }
+    }
+  }
+
+  /// Collect the tiles the rules and sockets of each tile allow in each direction, a direction with
+  /// neither allows every tile unless its rules are closed. Going through the rule sets and socket groups keeps this linear in
+  /// the number of allowed pairs
+
+  std::vector<uint64_t> allowed(table.size(), 0);
+  auto allowed_mask = [this, &allowed](size_t p_tile, size_t p_dir) {
+    return &allowed[(p_tile * wfc::DIRECTION_COUNT + p_dir) * words__];
+  };
+
+  for (size_t a = 0; a < tile_count__; ++a) {
+    for (size_t d = 0; d < wfc::DIRECTION_COUNT; ++d) {
+      uint64_t* mask = allowed_mask(a, d);
+      wfc::Directions dir = static_cast<wfc::Directions>(d);
+      const std::vector<uint32_t>& rules = p_tiles[a]->get_rules(dir);
+      uint32_t wanted = p_tiles[a]->get_mirror_socket(dir);
+
+      /// Directions not used by the canvas do not restrict anything
+
+      if (d % dir_step != 0 || (rules.size() == 0 && wanted == wfc::NO_SOCKET &&
+                                !p_tiles[a]->are_rules_closed(dir))) {
+        for (size_t b = 0; b < tile_count__; ++b) {
+          mask[b >> 6] |= uint64_t(1) << (b & 63);
+        }
+        continue;
+      }
+
+      for (uint32_t tile : rules) {
+        mask[tile >> 6] |= uint64_t(1) << (tile & 63);
+      }
+
+      /// Add the tiles whose facing side has the mirror of the socket of this side
+
+      if (wanted != wfc::NO_SOCKET && wanted < socket_count) {
+        size_t opp = static_cast<size_t>(wfc::opposite(dir));
+        const size_t* starts = &socket_starts[opp * (socket_count + 1)];
+        for (size_t i = starts[wanted]; i < starts[wanted + 1]; ++i) {
+          mask[socket_members[i] >> 6] |= uint64_t(1) << (socket_members[i] & 63);
+        }
+      }
+    }
+  }
+
+  /// A pair of tiles is compatible only if the rules of both tiles allow each other
+
+  for (size_t d = 0; d < wfc::DIRECTION_COUNT; ++d) {
+    size_t opp = static_cast<size_t>(wfc::opposite(static_cast<wfc::Directions>(d)));
+
+    for (size_t a = 0; a < tile_count__; ++a) {
+      uint64_t* mask = &table[(a * wfc::DIRECTION_COUNT + d) * words__];
+
+      /// Both sides of a direction not used by the canvas allow every tile
+
+      if (d % dir_step != 0) {
+        std::copy(allowed_mask(a, d), allowed_mask(a, d) + words__, mask);
+        continue;
+      }
+
+      wfc::for_each_bit(allowed_mask(a, d), words__, [&](size_t b) {
+        if ((allowed_mask(b, opp)[a >> 6] >> (a & 63)) & 1) {
+          mask[b >> 6] |= uint64_t(1) << (b & 63);
+        }
+      });
+    }
+  }
+
+  table__ = table.data();
+  owner__ = std::move(storage);
+}
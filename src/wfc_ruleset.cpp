@@ -0,0 +1,395 @@
+#include "wfc_ruleset.h"
+
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+const char MAGIC[8] = {'W', 'F', 'C', 'B', 'R', 'U', 'L', 'E'};
+const uint32_t BYTE_ORDER_MARK = 0x01020304;  /// Reads differently on a machine with another byte order
+const size_t ALIGNMENT = 64;                  /// Alignment of every section in the file
+const uint32_t FIXED = UINT32_MAX;            /// Kind of a constraint on a single spot
+
+struct Header {
+  char magic[8];
+  uint32_t version;
+  uint32_t byte_order;
+  uint64_t file_size;
+  uint64_t width;
+  uint64_t height;
+  uint64_t rows;
+  uint64_t columns;
+  uint64_t direction_type;      /// 0 for quad, 1 for oct
+  uint64_t tile_count;
+  uint64_t table_offset;        /// Words of the compatibility table
+  uint64_t tiles_offset;        /// One TileRecord per tile
+  uint64_t constraint_count;
+  uint64_t constraints_offset;  /// One ConstraintRecord per constraint
+  uint64_t data_offset;         /// Names, paths and pixels the records point to
+  uint64_t data_size;
+};
+
+struct TileRecord {
+  uint64_t name_offset;    /// Offsets and sizes are within the data section
+  uint64_t name_size;
+  uint64_t path_offset;    /// Path relative to the directory of the file, empty for tiles with pixels
+  uint64_t path_size;
+  uint64_t pixels_offset;  /// RGBA32 pixels, empty for tiles with an image file
+  uint64_t pixels_size;
+  uint64_t width;
+  uint64_t height;
+  uint64_t transform;
+  double weight;
+};
+
+struct ConstraintRecord {
+  uint32_t kind;  /// Value of wfc::Constraints, FIXED for a single spot
+  uint32_t tile;
+  uint64_t row;
+  uint64_t column;
+};
+
+/*
+ * Round an offset up to the next section boundary
+ */
+uint64_t align(uint64_t p_offset) {
+  return (p_offset + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+}
+
+/*
+ * Check that p_size bytes at p_offset fit in p_limit bytes, without overflowing
+ */
+bool fits(uint64_t p_offset, uint64_t p_size, uint64_t p_limit) {
+  return p_offset <= p_limit && p_size <= p_limit - p_offset;
+}
+
+/*
+ * Multiply two numbers, without overflowing
+ *
+ * Returns:
+ *        false if the product is larger than p_limit
+ */
+bool multiply(uint64_t p_a, uint64_t p_b, uint64_t p_limit, uint64_t& p_product) {
+  if (p_a != 0 && p_b > p_limit / p_a) {
+    return false;
+  }
+  p_product = p_a * p_b;
+  return true;
+}
+
+/*
+ * A file mapped read-only, unmapped when destroyed
+ */
+class MappedFile {
+public:
+  MappedFile(const fs::path& p_path) :
+    data__(nullptr),
+    size__(0) {
+    int fd = ::open(p_path.c_str(), O_RDONLY);
+    if (fd < 0) {
+      std::stringstream msg;
+      msg << "Failed to open ruleset file at " << p_path;
+      throw std::runtime_error(msg.str());
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < sizeof(Header)) {
+      ::close(fd);
+      std::stringstream msg;
+      msg << "File at " << p_path << " is not a ruleset file";
+      throw std::runtime_error(msg.str());
+    }
+
+    size__ = info.st_size;
+    data__ = mmap(nullptr, size__, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (data__ == MAP_FAILED) {
+      std::stringstream msg;
+      msg << "Failed to map ruleset file at " << p_path;
+      throw std::runtime_error(msg.str());
+    }
+  }
+
+  ~MappedFile() {
+    munmap(data__, size__);
+  }
+
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  const uint8_t* data() const {
+    return static_cast<const uint8_t*>(data__);
+  }
+
+  size_t size() const {
+    return size__;
+  }
+
+private:
+  void* data__;
+  size_t size__;
+};
+
+}
+
+void wfc::save_ruleset(const fs::path& p_path, const wfc::CanvasInfo& p_canvas_info, const wfc::Solver& p_solver,
+                       const wfc::ConstraintInfo& p_constraints) {
+  const wfc::Rules& rules = p_solver.get_rules();
+  const std::vector<wfc::Tile*>& tiles = p_solver.get_tiles();
+  if (rules.data() == nullptr || rules.tile_count() != tiles.size()) {
+    throw std::runtime_error("Rules of the solver must be compiled before they are saved");
+  }
+
+  /// Collect the names, paths and pixels of the tiles, paths relative to the file so it can move
+  /// along with the tile images
+
+  std::string data;
+  auto add_data = [&data](const void* p_bytes, size_t p_size) {
+    uint64_t offset = data.size();
+    data.append(static_cast<const char*>(p_bytes), p_size);
+    return offset;
+  };
+
+  fs::path directory = fs::absolute(p_path).parent_path();
+  const std::vector<std::string>& names = p_solver.get_tile_names();
+  std::vector<TileRecord> tile_records(tiles.size());
+  for (size_t t = 0; t < tiles.size(); ++t) {
+    const wfc::Tile* tile = tiles[t];
+    TileRecord& record = tile_records[t];
+    std::memset(&record, 0, sizeof(record));
+
+    record.name_size = names[t].size();
+    record.name_offset = add_data(names[t].data(), names[t].size());
+
+    if (!tile->get_pixels().empty()) {
+      record.pixels_size = tile->get_pixels().size();
+      record.pixels_offset = add_data(tile->get_pixels().data(), tile->get_pixels().size());
+      record.width = tile->get_width();
+      record.height = tile->get_height();
+    }
+    else {
+      std::string path = fs::proximate(tile->get_path(), directory).generic_string();
+      record.path_size = path.size();
+      record.path_offset = add_data(path.data(), path.size());
+    }
+
+    record.transform = tile->get_transform();
+    record.weight = tile->get_weight();
+  }
+
+  /// Resolve the constraints to tile ids
+
+  std::vector<ConstraintRecord> constraint_records;
+  auto add_constraint = [&p_solver, &constraint_records](uint32_t p_kind, uint64_t p_row, uint64_t p_column,
+                                                         const std::string& p_tile) {
+    uint32_t id = p_solver.get_tile_id(p_tile);
+    if (id == wfc::NO_TILE) {
+      std::stringstream msg;
+      msg << "Tile with name " << p_tile << " does not exist";
+      throw std::runtime_error(msg.str());
+    }
+    constraint_records.push_back({p_kind, id, p_row, p_column});
+  };
+
+  const std::pair<wfc::Constraints, const std::unordered_set<std::string>*> sides[] = {
+    {wfc::Constraints::TOP, &p_constraints.top},
+    {wfc::Constraints::TOP_RIGHT, &p_constraints.top_right},
+    {wfc::Constraints::RIGHT, &p_constraints.right},
+    {wfc::Constraints::BOTTOM_RIGHT, &p_constraints.bottom_right},
+    {wfc::Constraints::BOTTOM, &p_constraints.bottom},
+    {wfc::Constraints::BOTTOM_LEFT, &p_constraints.bottom_left},
+    {wfc::Constraints::LEFT, &p_constraints.left},
+    {wfc::Constraints::TOP_LEFT, &p_constraints.top_left},
+  };
+  for (const auto& [kind, names_of_kind] : sides) {
+    for (const std::string& tile : *names_of_kind) {
+      add_constraint(static_cast<uint32_t>(kind), 0, 0, tile);
+    }
+  }
+  for (const wfc::ConstraintInfo::Fixed& fixed : p_constraints.fixed) {
+    for (const std::string& tile : fixed.tiles) {
+      add_constraint(FIXED, fixed.row, fixed.column, tile);
+    }
+  }
+
+  /// Lay out the sections
+
+  Header header;
+  std::memset(&header, 0, sizeof(header));
+  std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+  header.version = wfc::RULESET_VERSION;
+  header.byte_order = BYTE_ORDER_MARK;
+  header.width = p_canvas_info.width;
+  header.height = p_canvas_info.height;
+  header.rows = p_canvas_info.rows;
+  header.columns = p_canvas_info.columns;
+  header.direction_type = p_canvas_info.direction_type == wfc::DirectionType::OCT_DIRECTIONS ? 1 : 0;
+  header.tile_count = tiles.size();
+  header.table_offset = align(sizeof(Header));
+  header.tiles_offset = align(header.table_offset + rules.table_size() * sizeof(uint64_t));
+  header.constraint_count = constraint_records.size();
+  header.constraints_offset = align(header.tiles_offset + tile_records.size() * sizeof(TileRecord));
+  header.data_offset = align(header.constraints_offset + constraint_records.size() * sizeof(ConstraintRecord));
+  header.data_size = data.size();
+  header.file_size = header.data_offset + header.data_size;
+
+  /// Write the sections, padding up to the start of each
+
+  std::ofstream out(p_path, std::ios::binary | std::ios::trunc);
+  auto write_at = [&out](uint64_t p_offset, const void* p_bytes, size_t p_size) {
+    static const char zeros[ALIGNMENT] = {};
+    out.write(zeros, p_offset - static_cast<uint64_t>(out.tellp()));
+    out.write(static_cast<const char*>(p_bytes), p_size);
+  };
+
+  write_at(0, &header, sizeof(header));
+  write_at(header.table_offset, rules.data(), rules.table_size() * sizeof(uint64_t));
+  write_at(header.tiles_offset, tile_records.data(), tile_records.size() * sizeof(TileRecord));
+  write_at(header.constraints_offset, constraint_records.data(), constraint_records.size() * sizeof(ConstraintRecord));
+  write_at(header.data_offset, data.data(), data.size());
+  out.close();
+
+  if (!out) {
+    std::stringstream msg;
+    msg << "Failed to write ruleset file at " << p_path;
+    throw std::runtime_error(msg.str());
+  }
+}
+
+wfc::Solver* wfc::load_ruleset(const fs::path& p_path, wfc::CanvasInfo& p_canvas_info) {
+  auto file = std::make_shared<MappedFile>(p_path);
+
+  auto invalid = [&p_path](const std::string& p_reason) {
+    std::stringstream msg;
+    msg << "Ruleset file at " << p_path << " " << p_reason;
+    return std::runtime_error(msg.str());
+  };
+
+  /// Check the header before trusting any offset in it
+
+  Header header;
+  std::memcpy(&header, file->data(), sizeof(header));
+  if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0) {
+    throw invalid("is not a ruleset file");
+  }
+  if (header.byte_order != BYTE_ORDER_MARK) {
+    throw invalid("was written on a machine with another byte order");
+  }
+  if (header.version != wfc::RULESET_VERSION) {
+    throw invalid("has version " + std::to_string(header.version) + " but version " +
+                  std::to_string(wfc::RULESET_VERSION) + " is expected, compile the config again");
+  }
+
+  /// Spots are indexed by 32 bit ids, and the canvas divides its size by the rows and columns
+
+  uint64_t spot_count;
+  if (header.rows == 0 || header.columns == 0 || !multiply(header.rows, header.columns, UINT32_MAX, spot_count) ||
+      header.direction_type > 1) {
+    throw invalid("has an invalid canvas");
+  }
+
+  size_t words = wfc::Domains::words_for(header.tile_count);
+  uint64_t table_words = header.tile_count * wfc::DIRECTION_COUNT * words;
+  if (header.file_size != file->size() || header.tile_count > UINT16_MAX ||
+      header.table_offset % ALIGNMENT != 0 ||
+      !fits(header.table_offset, table_words * sizeof(uint64_t), file->size()) ||
+      !fits(header.tiles_offset, header.tile_count * sizeof(TileRecord), file->size()) ||
+      !fits(header.constraints_offset, header.constraint_count * sizeof(ConstraintRecord), file->size()) ||
+      !fits(header.data_offset, header.data_size, file->size())) {
+    throw invalid("is truncated or corrupt");
+  }
+
+  p_canvas_info.width = header.width;
+  p_canvas_info.height = header.height;
+  p_canvas_info.rows = header.rows;
+  p_canvas_info.columns = header.columns;
+  p_canvas_info.direction_type = header.direction_type == 1 ? wfc::DirectionType::OCT_DIRECTIONS
+                                                            : wfc::DirectionType::QUAD_DIRECTIONS;
+  p_canvas_info.edge_tolerance = 0;
+
+  wfc::Solver* solver = new wfc::Solver(p_canvas_info.rows, p_canvas_info.columns);
+  try {
+    solver->set_direction_type(p_canvas_info.direction_type);
+
+    /// Add the tiles in the order of their ids, records are copied out since the mapping only
+    /// guarantees the alignment of the sections
+
+    const char* data = reinterpret_cast<const char*>(file->data() + header.data_offset);
+    fs::path directory = fs::absolute(p_path).parent_path();
+    for (size_t t = 0; t < header.tile_count; ++t) {
+      TileRecord record;
+      std::memcpy(&record, file->data() + header.tiles_offset + t * sizeof(TileRecord), sizeof(record));
+      uint64_t area;
+      if (!fits(record.name_offset, record.name_size, header.data_size) ||
+          !fits(record.path_offset, record.path_size, header.data_size) ||
+          !fits(record.pixels_offset, record.pixels_size, header.data_size) ||
+          !multiply(record.width, record.height, header.data_size / 4, area) || record.pixels_size != area * 4 ||
+          record.transform >= 8 || !(record.weight > 0) || !std::isfinite(record.weight)) {
+        throw invalid("is truncated or corrupt");
+      }
+
+      std::string name(data + record.name_offset, record.name_size);
+      if (record.pixels_size > 0) {
+        const uint8_t* pixels = reinterpret_cast<const uint8_t*>(data + record.pixels_offset);
+        solver->add_tile(name, std::vector<uint8_t>(pixels, pixels + record.pixels_size), record.width,
+                         record.height, record.weight);
+      }
+      else {
+        fs::path path = directory / std::string(data + record.path_offset, record.path_size);
+        solver->add_tile(name, path.lexically_normal().string(), record.weight, record.transform);
+      }
+    }
+
+    /// Use the table where it is mapped, the solver keeps the file mapped. The bits past the last
+    /// tile in each mask must be clear, the solver would take them for tiles that do not exist
+
+    const uint64_t* table = reinterpret_cast<const uint64_t*>(file->data() + header.table_offset);
+    if (header.tile_count % 64 != 0) {
+      uint64_t padding = ~uint64_t(0) << (header.tile_count % 64);
+      for (uint64_t row = 0; row < header.tile_count * wfc::DIRECTION_COUNT; ++row) {
+        if ((table[row * words + words - 1] & padding) != 0) {
+          throw invalid("is truncated or corrupt");
+        }
+      }
+    }
+    solver->load_rules(table, file);
+
+    for (size_t c = 0; c < header.constraint_count; ++c) {
+      ConstraintRecord record;
+      std::memcpy(&record, file->data() + header.constraints_offset + c * sizeof(ConstraintRecord), sizeof(record));
+      if (record.tile >= header.tile_count ||
+          (record.kind != FIXED && record.kind > static_cast<uint32_t>(wfc::Constraints::CORNERS))) {
+        throw invalid("is truncated or corrupt");
+      }
+
+      if (record.kind == FIXED) {
+        solver->add_constraint(record.row, record.column, record.tile);
+      }
+      else {
+        solver->add_constraint(static_cast<wfc::Constraints>(record.kind), record.tile);
+      }
+    }
+
+    solver->reset();
+  }
+  catch (...) {
+    delete solver;
+    throw;
+  }
+
+  return solver;
+}
@@ -1,6 +1,8 @@
 #include "wfc_sdl_utils.h"
+#include "wfc_log.h"
 
 #include <SDL2/SDL_image.h>
+#include <sstream>
 #include <stdexcept>
 
 #include <SDL2/SDL.h>
@@ -27,3 +29,45 @@ void wfc::free_sdl() {
   IMG_Quit();
   SDL_Quit();
 }
+
+SDL_Surface* wfc::load_image(const std::filesystem::path& p_path) {
+
+  /// Load the image onto a SDL surface
+
+  SDL_Surface* loaded = IMG_Load(p_path.c_str());
+  if (!loaded) {
+    std::stringstream msg;
+    msg << "Failed to load image at " << p_path;
+    throw std::runtime_error(msg.str());
+  }
+
+  /// Convert the pixels to RGBA32 so they can be read the same way for any file format
+
+  SDL_Surface* surface = SDL_ConvertSurfaceFormat(loaded, SDL_PIXELFORMAT_RGBA32, 0);
+  SDL_FreeSurface(loaded);
+  if (!surface) {
+    std::stringstream msg;
+    msg << "Failed to convert image at " << p_path << " to RGBA";
+    throw std::runtime_error(msg.str());
+  }
+
+  return surface;
+}
+
+wfc::ImageCache::~ImageCache() {
+  for (auto& [path, surface] : surfaces__) {
+    SDL_FreeSurface(surface);
+  }
+}
+
+SDL_Surface* wfc::ImageCache::get(const std::filesystem::path& p_path) {
+  auto it = surfaces__.find(p_path.string());
+  if (it != surfaces__.end()) {
+    return it->second;
+  }
+
+  wfc::Log::info("Loading image at " + p_path.string() + "...");
+  SDL_Surface* surface = load_image(p_path);
+  surfaces__[p_path.string()] = surface;
+  return surface;
+}
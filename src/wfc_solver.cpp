@@ -0,0 +1,1004 @@
+#include "wfc_solver.h"
+#include "wfc_random.h"
+#include "wfc_symmetry.h"
+
+#include <sstream>
+#include <stdexcept>
+#include <filesystem>
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+namespace fs = std::filesystem;
+
+wfc::Solver::Solver(size_t p_rows, size_t p_columns) :
+  rows__(p_rows),
+  columns__(p_columns),
+  direction_type__(DirectionType::QUAD_DIRECTIONS),
+  tiles__(std::make_shared<TileStore>()),
+  rules_dirty__(true),
+  backtrack_budget__(0),
+  backtrack_count__(0),
+  repair_radius__(0),
+  repair_count__(0),
+  attempt_trail__(0),
+  attempt_idx__(SIZE_MAX),
+  last_repair_idx__(SIZE_MAX),
+  last_repair_radius__(0),
+  propagated__(0),
+  contradiction__(false),
+  contradiction_idx__(0) {
+
+  /// Initialize solver values
+
+  buffer__.resize(rows__ * columns__);
+  dirty_flags__.resize(buffer__.size(), 0);
+  collapsed_count__ = 0;
+}
+
+
+void wfc::Solver::set_direction_type(const wfc::DirectionType p_dir_type) {
+  direction_type__ = p_dir_type;
+  rules_dirty__ = true;
+}
+
+uint32_t wfc::Solver::add_tile(const std::string& p_name, const std::string& p_path, double p_weight,
+                               size_t p_transform) {
+
+  /// Add tile to the solver, its image is only loaded when it is drawn
+
+  fs::path abs_path = fs::absolute(p_path);
+  return insert_tile__(p_name, wfc::Tile(abs_path, p_transform), p_weight);
+}
+
+uint32_t wfc::Solver::add_tile(const std::string& p_name, const std::vector<uint8_t>& p_pixels, size_t p_width,
+                               size_t p_height, double p_weight) {
+  return insert_tile__(p_name, wfc::Tile(p_pixels, p_width, p_height), p_weight);
+}
+
+void wfc::Solver::add_tiles(wfc::TileRegistry&& p_registry, std::vector<wfc::Tile>&& p_tiles) {
+
+  /// The registry takes the place of the names of the solver, so it can only hold all the tiles
+
+  if (!tile_list__.empty()) {
+    std::stringstream msg;
+    msg << "Tiles with interned names can only be added to a solver without tiles";
+    throw std::runtime_error(msg.str());
+  }
+
+  if (p_registry.size() != p_tiles.size()) {
+    std::stringstream msg;
+    msg << "Got " << p_registry.size() << " tile names for " << p_tiles.size() << " tiles";
+    throw std::runtime_error(msg.str());
+  }
+
+  /// Give every tile its index as id
+
+  for (size_t t = 0; t < p_tiles.size(); ++t) {
+    p_tiles[t].set_id(t);
+  }
+
+  own_tiles__();
+  tiles__->tiles = std::move(p_tiles);
+  tiles__->registry = std::move(p_registry);
+  list_tiles__();
+
+  rules_dirty__ = true;
+}
+
+uint32_t wfc::Solver::insert_tile__(const std::string& p_name, wfc::Tile&& p_tile, double p_weight) {
+
+  /// Check if tile is already known to the solver
+
+  if (tiles__->registry.find(p_name) != wfc::NO_TILE) {
+    std::stringstream msg;
+    msg << "Tile with name " << p_name << " already exists";
+    throw std::runtime_error(msg.str());
+  }
+
+  /// Give the tile the next id, the tiles are stored next to each other so tile_list__ has to
+  /// follow them when they move
+
+  own_tiles__();
+  uint32_t id = tile_list__.size();
+  p_tile.set_id(id);
+  p_tile.set_weight(p_weight);
+
+  const wfc::Tile* storage = tiles__->tiles.data();
+  tiles__->tiles.push_back(std::move(p_tile));
+  tiles__->registry.intern(p_name);
+  if (tiles__->tiles.data() != storage) {
+    list_tiles__();
+  }
+  else {
+    tile_list__.push_back(&tiles__->tiles.back());
+  }
+
+  rules_dirty__ = true;
+  return id;
+}
+
+wfc::Tile& wfc::Solver::edit_tile__(uint32_t p_id) {
+  check_tile_id__(p_id);
+  own_tiles__();
+  rules_dirty__ = true;
+  return tiles__->tiles[p_id];
+}
+
+void wfc::Solver::own_tiles__() {
+  if (tiles__.use_count() > 1) {
+    tiles__ = std::make_shared<TileStore>(*tiles__);
+    list_tiles__();
+  }
+}
+
+uint32_t wfc::Solver::find_tile__(const std::string& p_name) const {
+  uint32_t id = tiles__->registry.find(p_name);
+  if (id == wfc::NO_TILE) {
+    std::stringstream msg;
+    msg << "Tile with name " << p_name << " does not exist";
+    throw std::runtime_error(msg.str());
+  }
+  return id;
+}
+
+void wfc::Solver::check_tile_id__(uint32_t p_id) const {
+  if (p_id >= tile_list__.size()) {
+    std::stringstream msg;
+    msg << "Tile with id " << p_id << " does not exist";
+    throw std::runtime_error(msg.str());
+  }
+}
+
+void wfc::Solver::list_tiles__() {
+  tile_list__.resize(tiles__->tiles.size());
+  for (size_t t = 0; t < tile_list__.size(); ++t) {
+    tile_list__[t] = &tiles__->tiles[t];
+  }
+}
+
+void wfc::Solver::add_rule(const std::string& p_for, wfc::Directions p_dir, const std::string& p_to) {
+  add_rule(find_tile__(p_for), p_dir, find_tile__(p_to));
+}
+
+void wfc::Solver::add_rule(uint32_t p_for, wfc::Directions p_dir, uint32_t p_to) {
+  check_tile_id__(p_to);
+  edit_tile__(p_for).add_rule(p_dir, p_to);
+}
+
+void wfc::Solver::close_rules(uint32_t p_tile, wfc::Directions p_dir) {
+  edit_tile__(p_tile).close_rules(p_dir);
+}
+
+void wfc::Solver::add_socket(const std::string& p_tile, wfc::Directions p_dir, const std::string& p_socket) {
+  add_socket(find_tile__(p_tile), p_dir, p_socket);
+}
+
+void wfc::Solver::add_socket(uint32_t p_tile, wfc::Directions p_dir, const std::string& p_socket) {
+  wfc::Tile& tile = edit_tile__(p_tile);
+
+  /// Give the socket and its mirror the next ids if they are new
+
+  auto socket_id = [this](const std::string& p_label) {
+    return socket_ids__.emplace(p_label, static_cast<uint32_t>(socket_ids__.size())).first->second;
+  };
+  uint32_t socket = socket_id(p_socket);
+  uint32_t mirror = socket_id(wfc::mirror_socket(p_socket));
+
+  tile.set_socket(p_dir, socket, mirror);
+}
+
+void wfc::Solver::add_constraint(wfc::Constraints p_cons, const std::string& p_tile) {
+  add_constraint(p_cons, find_tile__(p_tile));
+}
+
+void wfc::Solver::add_constraint(wfc::Constraints p_cons, uint32_t p_tile) {
+  check_tile_id__(p_tile);
+  constraints__.others[p_cons].insert(p_tile);
+}
+
+void wfc::Solver::add_constraint(size_t x, size_t y, const std::string& p_tile) {
+  add_constraint(x, y, find_tile__(p_tile));
+}
+
+void wfc::Solver::add_constraint(size_t x, size_t y, uint32_t p_tile) {
+  check_tile_id__(p_tile);
+
+  /// Check if the coordinate are out of bound
+
+  size_t idx = y * columns__ + x;
+  if (idx >= buffer__.size()) {
+    std::stringstream msg;
+    msg << "Coordinates" << x << ", " << y << " is out of bound";
+    throw std::runtime_error(msg.str());
+  }
+
+  /// Add the constraint to the solver
+
+  constraints__.fixed[idx].insert(p_tile);
+}
+
+void wfc::Solver::add_rule(const std::string& p_for, wfc::Directions p_dir, const std::vector<std::string>& p_to) {
+
+  /// Call add_rule for each tile in the list
+
+  uint32_t id = find_tile__(p_for);
+  for (const std::string& tile : p_to) {
+    add_rule(id, p_dir, find_tile__(tile));
+  }
+}
+
+void wfc::Solver::set_backtrack_budget(size_t p_budget) {
+  backtrack_budget__ = p_budget;
+}
+
+void wfc::Solver::set_seed(uint64_t p_seed) {
+  random__.seed(p_seed);
+}
+
+void wfc::Solver::set_random(const wfc::Random& p_random) {
+  random__ = p_random;
+}
+
+void wfc::Solver::set_repair_radius(size_t p_radius) {
+  repair_radius__ = p_radius;
+}
+
+void wfc::Solver::compile_rules() {
+  if (!rules_dirty__) {
+    return;
+  }
+
+  check_tile_count__();
+  rules__.compile(tile_list__, direction_type__);
+  use_rules__();
+}
+
+void wfc::Solver::load_rules(const uint64_t* p_table, std::shared_ptr<const void> p_owner) {
+  check_tile_count__();
+  rules__.load(tile_list__, p_table, std::move(p_owner));
+  use_rules__();
+}
+
+const wfc::Rules& wfc::Solver::get_rules() const {
+  return rules__;
+}
+
+void wfc::Solver::check_tile_count__() const {
+
+  /// Support counters are 16 bit wide
+
+  if (tile_list__.size() > UINT16_MAX) {
+    std::stringstream msg;
+    msg << "Solver supports at most " << UINT16_MAX << " tiles";
+    throw std::runtime_error(msg.str());
+  }
+}
+
+void wfc::Solver::use_rules__() {
+
+  /// Collect the directions used by the solver in clockwise order
+
+  directions__.clear();
+  size_t dir_step = (direction_type__ == wfc::DirectionType::OCT_DIRECTIONS) ? 1 : 2;
+  for (size_t d = 0; d < wfc::DIRECTION_COUNT; d += dir_step) {
+    directions__.push_back(static_cast<wfc::Directions>(d));
+  }
+
+  rules_dirty__ = false;
+}
+
+void wfc::Solver::reset() {
+
+  /// Compile the rules if they changed
+
+  if (rules_dirty__) {
+    compile_rules();
+  }
+
+  size_t tile_count = tile_list__.size();
+  size_t dir_count = directions__.size();
+
+  /// Size the domains for the known tiles
+
+  if (domains__.bits() != tile_count || domains__.cells() != buffer__.size()) {
+    domains__.resize(buffer__.size(), tile_count);
+    mask__.resize(domains__.words_per_cell());
+    sum_weights__.resize(buffer__.size());
+    sum_weight_logs__.resize(buffer__.size());
+  }
+
+  /// The counters also depend on the number of directions, which changes without the domains
+
+  supports__.resize(buffer__.size() * tile_count * dir_count);
+
+  /// Build the mask of all possible tiles
+
+  std::vector<uint64_t> all_tiles(domains__.words_per_cell(), 0);
+  for (size_t i = 0; i < tile_count; ++i) {
+    all_tiles[i >> 6] |= uint64_t(1) << (i & 63);
+  }
+
+  /// Reset the buffer__
+
+  for (size_t i = 0, e = buffer__.size(); i < e; ++i) {
+    if (buffer__[i].tile != wfc::NO_TILE) {
+      buffer__[i].tile = wfc::NO_TILE;
+      mark_dirty__(i);
+    }
+  }
+  domains__.fill(all_tiles.data());
+
+  /// Every spot starts with the weight sums of all tiles
+
+  double sum_weight = 0;
+  double sum_weight_log = 0;
+  for (size_t t = 0; t < tile_count; ++t) {
+    sum_weight += rules__.weight(t);
+    sum_weight_log += rules__.weight_log_weight(t);
+  }
+  std::fill(sum_weights__.begin(), sum_weights__.end(), sum_weight);
+  std::fill(sum_weight_logs__.begin(), sum_weight_logs__.end(), sum_weight_log);
+
+  /// Every tile starts supported by all the tiles compatible with it
+
+  std::vector<uint16_t> initial_supports(tile_count * dir_count);
+  for (size_t t = 0; t < tile_count; ++t) {
+    for (size_t k = 0; k < dir_count; ++k) {
+      const uint64_t* compatible = rules__.get(t, directions__[k]);
+      size_t count = 0;
+      for (size_t w = 0; w < rules__.words(); ++w) {
+        count += __builtin_popcountll(compatible[w]);
+      }
+      initial_supports[t * dir_count + k] = count;
+    }
+  }
+
+  for (size_t i = 0, e = buffer__.size(); i < e; ++i) {
+    std::copy(initial_supports.begin(), initial_supports.end(), &support__(i, 0, 0));
+  }
+
+  removals__.clear();
+  decisions__.clear();
+  backtrack_count__ = 0;
+  repair_count__ = 0;
+  attempt_trail__ = 0;
+  attempt_idx__ = SIZE_MAX;
+  last_repair_idx__ = SIZE_MAX;
+  last_repair_radius__ = 0;
+  propagated__ = 0;
+  contradiction__ = false;
+  heap__.clear(buffer__.size());
+
+  /// Queue the tiles removed by the constraints
+
+  apply_constraints__();
+
+  for (size_t i = 0, e = buffer__.size(); i < e; ++i) {
+    const uint64_t* words = domains__.cell(i);
+    for (size_t w = 0; w < domains__.words_per_cell(); ++w) {
+      mask__[w] = all_tiles[w] & ~words[w];
+    }
+    wfc::for_each_bit(mask__.data(), mask__.size(), [this, i](size_t tile) {
+      removals__.push_back({static_cast<uint32_t>(i), static_cast<uint32_t>(tile)});
+      sum_weights__[i] -= rules__.weight(tile);
+      sum_weight_logs__[i] -= rules__.weight_log_weight(tile);
+    });
+    if (domains__.count(i) == 0) {
+      contradiction__ = true;
+    }
+  }
+
+  /// Remove tiles that have no compatible tile at all in a direction where a neighbour exists
+
+  for (size_t t = 0; t < tile_count; ++t) {
+    for (size_t k = 0; k < dir_count; ++k) {
+      if (initial_supports[t * dir_count + k] != 0) {
+        continue;
+      }
+      for (size_t i = 0, e = buffer__.size(); i < e; ++i) {
+        size_t neighbour_idx;
+        if (domains__.test(i, t) && neighbour__(i, k, neighbour_idx)) {
+          ban__(i, t);
+        }
+      }
+    }
+  }
+
+  propagate__();
+
+  /// Keep the propagated constraints to clear blocks back to during local repair
+
+  root_domains__ = domains__;
+
+  /// Order all spots by entropy
+
+  for (size_t i = 0, e = buffer__.size(); i < e; ++i) {
+    heap__.push(i, entropy__(i), random__.next_u32());
+  }
+
+  /// Reset number of tiles collapsed
+
+  collapsed_count__ = 0;
+}
+
+bool wfc::Solver::collapse_next() {
+  /// Check if the constraints left no solution
+
+  if (contradiction__) {
+    return false;
+  }
+
+  /// Check if uncollapsed tile exists
+
+  if (collapsed_count__ == rows__ * columns__) {
+    return true;
+  }
+
+  /// Collapse the tile with the lowest entropy
+
+  size_t spot_idx = get_lowest_entropy_spot_idx__();
+  wfc::Spot* spot = &buffer__[spot_idx];
+  size_t possible_count = domains__.count(spot_idx);
+  if (possible_count == 0) {
+    return false;
+  }
+
+  /// Select a tile to collapse into with probability proportional to its weight
+
+  std::copy_n(domains__.cell(spot_idx), mask__.size(), mask__.begin());
+
+  double total_weight = 0;
+  wfc::for_each_bit(mask__.data(), mask__.size(), [this, &total_weight](size_t tile) {
+    total_weight += rules__.weight(tile);
+  });
+
+  double selection = random__.real_from_range(0, total_weight);
+  size_t tile_id = domains__.nth(spot_idx, possible_count - 1);
+  wfc::for_each_bit(mask__.data(), mask__.size(), [this, &selection, &tile_id](size_t tile) {
+    if (selection >= 0 && (selection -= rules__.weight(tile)) < 0) {
+      tile_id = tile;
+    }
+  });
+
+  // Collapse the tile and remove every other tile from the spot
+
+  attempt_trail__ = removals__.size();
+  attempt_idx__ = spot_idx;
+  spot->tile = tile_id;
+  ++collapsed_count__;
+  mark_dirty__(spot_idx);
+
+  if (backtrack_budget__ > 0) {
+    decisions__.push_back({removals__.size(), static_cast<uint32_t>(spot_idx), static_cast<uint32_t>(tile_id)});
+  }
+
+  wfc::for_each_bit(mask__.data(), mask__.size(), [this, spot_idx, tile_id](size_t tile) {
+    if (tile != tile_id) {
+      ban__(spot_idx, tile);
+    }
+  });
+
+  if (!propagate__() && !backtrack__()) {
+    return repair__();
+  }
+  return true;
+}
+
+bool wfc::Solver::is_collapsed() const {
+  return collapsed_count__ == buffer__.size();
+}
+
+size_t wfc::Solver::get_rows() const {
+  return rows__;
+}
+
+size_t wfc::Solver::get_columns() const {
+  return columns__;
+}
+
+const std::vector<wfc::Tile*>& wfc::Solver::get_tiles() const {
+  return tile_list__;
+}
+
+const std::vector<std::string>& wfc::Solver::get_tile_names() const {
+  return tiles__->registry.names();
+}
+
+uint32_t wfc::Solver::get_tile_id(const std::string& p_name) const {
+  return tiles__->registry.find(p_name);
+}
+
+const wfc::Tile* wfc::Solver::get_tile(size_t p_spot_idx) const {
+  uint32_t tile = buffer__[p_spot_idx].tile;
+  return tile == wfc::NO_TILE ? nullptr : tile_list__[tile];
+}
+
+void wfc::Solver::take_dirty(std::vector<uint32_t>& p_out) {
+  p_out.swap(dirty__);
+  dirty__.clear();
+  for (uint32_t idx : p_out) {
+    dirty_flags__[idx] = 0;
+  }
+}
+
+bool wfc::Solver::check_supports() const {
+  if (contradiction__ || propagated__ != removals__.size()) {
+    return false;
+  }
+
+  size_t tile_count = tile_list__.size();
+  size_t dir_count = directions__.size();
+  for (size_t i = 0, e = buffer__.size(); i < e; ++i) {
+    for (size_t t = 0; t < tile_count; ++t) {
+      for (size_t k = 0; k < dir_count; ++k) {
+        const uint64_t* compatible = rules__.get(t, directions__[k]);
+        size_t neighbour_idx;
+        bool has_neighbour = neighbour__(i, k, neighbour_idx);
+
+        size_t count = 0;
+        for (size_t w = 0; w < rules__.words(); ++w) {
+          count += __builtin_popcountll(has_neighbour ? compatible[w] & domains__.cell(neighbour_idx)[w]
+                                                      : compatible[w]);
+        }
+
+        size_t support = supports__[(i * tile_count + t) * dir_count + k];
+        if (support != count || (has_neighbour && count == 0 && domains__.test(i, t))) {
+          return false;
+        }
+      }
+    }
+  }
+  return true;
+}
+
+size_t wfc::Solver::get_lowest_entropy_spot_idx__() {
+
+  /// The top of the heap is the spot with minimum entropy
+
+  size_t spot_idx = heap__.top();
+  heap__.pop();
+  return spot_idx;
+}
+
+bool wfc::Solver::neighbour__(size_t p_spot_idx, size_t p_dir_idx, size_t& p_out) const {
+  size_t row_number = p_spot_idx / columns__;
+  size_t col_number = p_spot_idx % columns__;
+
+  /// Check if the neighbour falls outside the grid
+
+  switch (directions__[p_dir_idx]) {
+    case wfc::Directions::NORTH:
+      if (row_number == 0) return false;
+      p_out = p_spot_idx - columns__;
+      break;
+
+    case wfc::Directions::NORTH_EAST:
+      if (row_number == 0 || col_number == columns__ - 1) return false;
+      p_out = p_spot_idx - columns__ + 1;
+      break;
+
+    case wfc::Directions::EAST:
+      if (col_number == columns__ - 1) return false;
+      p_out = p_spot_idx + 1;
+      break;
+
+    case wfc::Directions::SOUTH_EAST:
+      if (row_number == rows__ - 1 || col_number == columns__ - 1) return false;
+      p_out = p_spot_idx + columns__ + 1;
+      break;
+
+    case wfc::Directions::SOUTH:
+      if (row_number == rows__ - 1) return false;
+      p_out = p_spot_idx + columns__;
+      break;
+
+    case wfc::Directions::SOUTH_WEST:
+      if (row_number == rows__ - 1 || col_number == 0) return false;
+      p_out = p_spot_idx + columns__ - 1;
+      break;
+
+    case wfc::Directions::WEST:
+      if (col_number == 0) return false;
+      p_out = p_spot_idx - 1;
+      break;
+
+    case wfc::Directions::NORTH_WEST:
+      if (row_number == 0 || col_number == 0) return false;
+      p_out = p_spot_idx - columns__ - 1;
+      break;
+  }
+
+  return true;
+}
+
+double wfc::Solver::entropy__(size_t p_spot_idx) const {
+
+  /// H = log(sum(w)) - sum(w * log(w)) / sum(w)
+
+  double sum_weight = sum_weights__[p_spot_idx];
+  if (sum_weight <= 0) {
+    return 0;
+  }
+  return std::log(sum_weight) - sum_weight_logs__[p_spot_idx] / sum_weight;
+}
+
+void wfc::Solver::ban__(size_t p_spot_idx, size_t p_tile) {
+  domains__.reset(p_spot_idx, p_tile);
+  removals__.push_back({static_cast<uint32_t>(p_spot_idx), static_cast<uint32_t>(p_tile)});
+  sum_weights__[p_spot_idx] -= rules__.weight(p_tile);
+  sum_weight_logs__[p_spot_idx] -= rules__.weight_log_weight(p_tile);
+
+  size_t count = domains__.count(p_spot_idx);
+  if (count == 0) {
+    contradiction__ = true;
+    contradiction_idx__ = p_spot_idx;
+  }
+
+  /// Move the spot up in the heap now that it has less possible tiles
+
+  if (heap__.contains(p_spot_idx)) {
+    heap__.update(p_spot_idx, entropy__(p_spot_idx));
+  }
+}
+
+bool wfc::Solver::propagate__() {
+  size_t dir_count = directions__.size();
+
+  while (propagated__ < removals__.size() && !contradiction__) {
+    Removal removal = removals__[propagated__++];
+
+    for (size_t k = 0; k < dir_count; ++k) {
+      size_t neighbour_idx;
+      if (!neighbour__(removal.spot, k, neighbour_idx)) {
+        continue;
+      }
+
+      /// Every tile of the neighbour compatible with the removed tile loses one support in the
+      /// direction pointing back at the spot
+
+      size_t back = (k + dir_count / 2) % dir_count;
+      const uint64_t* compatible = rules__.get(removal.tile, directions__[k]);
+
+      wfc::for_each_bit(compatible, rules__.words(), [this, neighbour_idx, back](size_t tile) {
+        uint16_t& support = support__(neighbour_idx, tile, back);
+        if (--support == 0 && domains__.test(neighbour_idx, tile)) {
+          ban__(neighbour_idx, tile);
+        }
+      });
+    }
+  }
+
+  /// Forget the removals if there is no decision to undo them to. After a contradiction they are
+  /// kept, a repair undoes the failed attempt with them
+
+  if (!contradiction__ && (backtrack_budget__ == 0 || decisions__.empty())) {
+    removals__.clear();
+    propagated__ = 0;
+  }
+
+  return !contradiction__;
+}
+
+void wfc::Solver::undo__(size_t p_trail_size) {
+  size_t dir_count = directions__.size();
+
+  /// Walk the trail backwards so every counter goes back through the values it had
+
+  for (size_t i = removals__.size(); i-- > p_trail_size;) {
+    Removal removal = removals__[i];
+
+    domains__.set(removal.spot, removal.tile);
+    sum_weights__[removal.spot] += rules__.weight(removal.tile);
+    sum_weight_logs__[removal.spot] += rules__.weight_log_weight(removal.tile);
+
+    if (heap__.contains(removal.spot)) {
+      heap__.update(removal.spot, entropy__(removal.spot));
+    }
+
+    /// Removals after propagated__ never decremented the counters of their neighbours
+
+    if (i >= propagated__) {
+      continue;
+    }
+
+    for (size_t k = 0; k < dir_count; ++k) {
+      size_t neighbour_idx;
+      if (!neighbour__(removal.spot, k, neighbour_idx)) {
+        continue;
+      }
+
+      size_t back = (k + dir_count / 2) % dir_count;
+      const uint64_t* compatible = rules__.get(removal.tile, directions__[k]);
+
+      wfc::for_each_bit(compatible, rules__.words(), [this, neighbour_idx, back](size_t tile) {
+        ++support__(neighbour_idx, tile, back);
+      });
+    }
+  }
+
+  removals__.resize(p_trail_size);
+  propagated__ = std::min(propagated__, p_trail_size);
+  contradiction__ = false;
+}
+
+bool wfc::Solver::backtrack__() {
+  while (!decisions__.empty()) {
+
+    /// Give up once the budget is spent
+
+    if (backtrack_count__ >= backtrack_budget__) {
+      return false;
+    }
+    ++backtrack_count__;
+
+    /// Undo the last decision and uncollapse its spot
+
+    Decision decision = decisions__.back();
+    decisions__.pop_back();
+    undo__(decision.trail_size);
+
+    buffer__[decision.spot].tile = wfc::NO_TILE;
+    --collapsed_count__;
+    mark_dirty__(decision.spot);
+    heap__.push(decision.spot, entropy__(decision.spot), random__.next_u32());
+
+    /// Ban the tile that led to the contradiction, recorded as part of the previous decision
+
+    attempt_trail__ = removals__.size();
+    attempt_idx__ = SIZE_MAX;
+    ban__(decision.spot, decision.tile);
+    if (propagate__()) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+void wfc::Solver::recount_supports__(size_t p_spot_idx) {
+  size_t dir_count = directions__.size();
+  size_t words = rules__.words();
+
+  for (size_t k = 0; k < dir_count; ++k) {
+    size_t neighbour_idx;
+    bool has_neighbour = neighbour__(p_spot_idx, k, neighbour_idx);
+
+    for (size_t t = 0, e = tile_list__.size(); t < e; ++t) {
+      const uint64_t* compatible = rules__.get(t, directions__[k]);
+      size_t count = 0;
+
+      /// Without a neighbour every compatible tile counts, as on reset()
+
+      if (has_neighbour) {
+        const uint64_t* possible = domains__.cell(neighbour_idx);
+        for (size_t w = 0; w < words; ++w) {
+          count += __builtin_popcountll(compatible[w] & possible[w]);
+        }
+      }
+      else {
+        for (size_t w = 0; w < words; ++w) {
+          count += __builtin_popcountll(compatible[w]);
+        }
+      }
+
+      support__(p_spot_idx, t, k) = count;
+    }
+  }
+}
+
+void wfc::Solver::reset_block__(size_t p_spot_idx, size_t p_radius) {
+  size_t row = p_spot_idx / columns__;
+  size_t col = p_spot_idx % columns__;
+
+  size_t row_begin = row > p_radius ? row - p_radius : 0;
+  size_t row_end = std::min(rows__, row + p_radius + 1);
+  size_t col_begin = col > p_radius ? col - p_radius : 0;
+  size_t col_end = std::min(columns__, col + p_radius + 1);
+
+  /// Clear the block back to its possible tiles after reset()
+
+  for (size_t r = row_begin; r < row_end; ++r) {
+    for (size_t c = col_begin; c < col_end; ++c) {
+      size_t idx = r * columns__ + c;
+
+      if (buffer__[idx].tile != wfc::NO_TILE) {
+        buffer__[idx].tile = wfc::NO_TILE;
+        --collapsed_count__;
+        mark_dirty__(idx);
+      }
+      domains__.assign(idx, root_domains__.cell(idx));
+
+      double sum_weight = 0;
+      double sum_weight_log = 0;
+      wfc::for_each_bit(domains__.cell(idx), domains__.words_per_cell(),
+                        [this, &sum_weight, &sum_weight_log](size_t tile) {
+        sum_weight += rules__.weight(tile);
+        sum_weight_log += rules__.weight_log_weight(tile);
+      });
+      sum_weights__[idx] = sum_weight;
+      sum_weight_logs__[idx] = sum_weight_log;
+
+      if (heap__.contains(idx)) {
+        heap__.update(idx, entropy__(idx));
+      }
+      else {
+        heap__.push(idx, entropy__(idx), random__.next_u32());
+      }
+    }
+  }
+
+  /// The counters of the block and of the spots bordering it depend on the cleared spots
+
+  size_t ring_row_begin = row_begin > 0 ? row_begin - 1 : 0;
+  size_t ring_row_end = std::min(rows__, row_end + 1);
+  size_t ring_col_begin = col_begin > 0 ? col_begin - 1 : 0;
+  size_t ring_col_end = std::min(columns__, col_end + 1);
+
+  for (size_t r = ring_row_begin; r < ring_row_end; ++r) {
+    for (size_t c = ring_col_begin; c < ring_col_end; ++c) {
+      recount_supports__(r * columns__ + c);
+    }
+  }
+
+  /// Remove the tiles that lost all support, the border of the block is where this happens
+
+  size_t dir_count = directions__.size();
+  for (size_t r = ring_row_begin; r < ring_row_end; ++r) {
+    for (size_t c = ring_col_begin; c < ring_col_end; ++c) {
+      size_t idx = r * columns__ + c;
+
+      std::copy_n(domains__.cell(idx), mask__.size(), mask__.begin());
+      wfc::for_each_bit(mask__.data(), mask__.size(), [this, idx, dir_count](size_t tile) {
+        for (size_t k = 0; k < dir_count; ++k) {
+          size_t neighbour_idx;
+          if (neighbour__(idx, k, neighbour_idx) && support__(idx, tile, k) == 0) {
+            ban__(idx, tile);
+            return;
+          }
+        }
+      });
+    }
+  }
+}
+
+bool wfc::Solver::repair__() {
+  if (repair_radius__ == 0 || repair_count__ >= buffer__.size()) {
+    return false;
+  }
+  ++repair_count__;
+
+  size_t spot_idx = contradiction_idx__;
+
+  /// Undo the failed attempt, its removals hold only outside the block while it stands
+
+  undo__(attempt_trail__);
+  if (attempt_idx__ != SIZE_MAX) {
+    buffer__[attempt_idx__].tile = wfc::NO_TILE;
+    --collapsed_count__;
+    mark_dirty__(attempt_idx__);
+    heap__.push(attempt_idx__, entropy__(attempt_idx__), random__.next_u32());
+  }
+
+  /// Every removal left is propagated, and none can be undone past a reset block
+
+  removals__.clear();
+  decisions__.clear();
+  propagated__ = 0;
+
+  /// Clear one spot wider than last time if the contradiction is back at the last repaired block,
+  /// doubling it right away often clears most of the grid
+
+  size_t grid_radius = std::max(rows__, columns__);
+  size_t start_radius = repair_radius__;
+  if (last_repair_idx__ != SIZE_MAX && last_repair_radius__ < grid_radius) {
+    size_t row_distance = std::max(spot_idx / columns__, last_repair_idx__ / columns__) -
+                          std::min(spot_idx / columns__, last_repair_idx__ / columns__);
+    size_t col_distance = std::max(spot_idx % columns__, last_repair_idx__ % columns__) -
+                          std::min(spot_idx % columns__, last_repair_idx__ % columns__);
+    if (std::max(row_distance, col_distance) <= last_repair_radius__ + 1) {
+      start_radius = std::max(start_radius, last_repair_radius__ + 1);
+    }
+  }
+
+  for (size_t radius = start_radius; ; radius *= 2) {
+    reset_block__(spot_idx, radius);
+    if (propagate__()) {
+      last_repair_idx__ = spot_idx;
+      last_repair_radius__ = radius;
+      return true;
+    }
+
+    /// Give up once the block covers the whole grid
+
+    if (radius >= grid_radius) {
+      return false;
+    }
+
+    /// Undo the bans of the block, the wider block clears every spot they touched
+
+    undo__(0);
+  }
+}
+
+void wfc::Solver::apply_constraints__() {
+
+  /// Top Row
+
+  if (constraints__.others[wfc::Constraints::TOP].size() > 0) {
+    const uint64_t* mask = make_mask__(constraints__.others[wfc::Constraints::TOP]);
+    for (size_t i = 0; i < columns__; ++i) {
+      domains__.assign(i, mask);
+    }
+  }
+
+  /// Bottom Row
+
+  if (constraints__.others[wfc::Constraints::BOTTOM].size() > 0) {
+    const uint64_t* mask = make_mask__(constraints__.others[wfc::Constraints::BOTTOM]);
+    for (size_t i = buffer__.size() - columns__, e = buffer__.size(); i < e; ++i) {
+      domains__.assign(i, mask);
+    }
+  }
+
+  /// Left Column
+
+  if (constraints__.others[wfc::Constraints::LEFT].size() > 0) {
+    const uint64_t* mask = make_mask__(constraints__.others[wfc::Constraints::LEFT]);
+    for (size_t i = 0, e = buffer__.size(); i < e; i += columns__) {
+      domains__.assign(i, mask);
+    }
+  }
+
+  /// Right Column
+
+  if (constraints__.others[wfc::Constraints::RIGHT].size() > 0) {
+    const uint64_t* mask = make_mask__(constraints__.others[wfc::Constraints::RIGHT]);
+    for (size_t i = columns__ - 1, e = buffer__.size(); i < e; i += columns__) {
+      domains__.assign(i, mask);
+    }
+  }
+
+  /// Top Right Spot
+
+  size_t top_right_index = columns__ - 1;
+  if (constraints__.others[wfc::Constraints::TOP_RIGHT].size() > 0) {
+    domains__.assign(top_right_index, make_mask__(constraints__.others[wfc::Constraints::TOP_RIGHT]));
+  }
+
+  /// Bottom Right Spot
+
+  size_t bottom_right_index = buffer__.size() - 1;
+  if (constraints__.others[wfc::Constraints::BOTTOM_RIGHT].size() > 0) {
+    domains__.assign(bottom_right_index, make_mask__(constraints__.others[wfc::Constraints::BOTTOM_RIGHT]));
+  }
+
+  /// Bottom Left Spot
+
+  size_t bottom_left_index = buffer__.size() - columns__;
+  if (constraints__.others[wfc::Constraints::BOTTOM_LEFT].size() > 0) {
+    domains__.assign(bottom_left_index, make_mask__(constraints__.others[wfc::Constraints::BOTTOM_LEFT]));
+  }
+
+  /// Top Left Spot
+
+  size_t top_left_index = 0;
+  if (constraints__.others[wfc::Constraints::TOP_LEFT].size() > 0) {
+    domains__.assign(top_left_index, make_mask__(constraints__.others[wfc::Constraints::TOP_LEFT]));
+  }
+
+  /// Fixed
+
+  for (auto& [idx, value]: constraints__.fixed) {
+    domains__.assign(idx, make_mask__(value));
+  }
+}
+
+const uint64_t* wfc::Solver::make_mask__(const std::unordered_set<uint32_t>& p_tiles) {
+  std::fill(mask__.begin(), mask__.end(), 0);
+  for (uint32_t id : p_tiles) {
+    mask__[id >> 6] |= uint64_t(1) << (id & 63);
+  }
+  return mask__.data();
+}
@@ -0,0 +1,150 @@
+#include "wfc_solver_thread.h"
+
+#include <chrono>
+
+namespace {
+
+/// Time the worker sleeps when the grid is collapsed and no command arrived
+const std::chrono::milliseconds IDLE_DELAY(1);
+
+/*
+ * Get the id of the tile collapsed into a spot, or NO_TILE
+ */
+uint32_t tile_id(const wfc::Solver* p_solver, size_t p_spot_idx) {
+  const wfc::Tile* tile = p_solver->get_tile(p_spot_idx);
+  return tile ? tile->get_id() : wfc::NO_TILE;
+}
+
+}
+
+wfc::SolverThread::SolverThread(wfc::Solver* p_solver, uint32_t p_interval) :
+  solver__(p_solver),
+  interval__(p_interval),
+  middle__(1),
+  back__(2),
+  front__(0),
+  commands__(0) {
+
+  /// Start every buffer from the current state of the solver
+
+  size_t spot_count = solver__->get_rows() * solver__->get_columns();
+  for (wfc::Snapshot& snapshot : buffers__) {
+    snapshot.tiles.resize(spot_count);
+    for (size_t idx = 0; idx < spot_count; ++idx) {
+      snapshot.tiles[idx] = tile_id(solver__, idx);
+    }
+    snapshot.collapsed = solver__->is_collapsed();
+  }
+  solver__->take_dirty(dirty__);
+
+  thread__ = std::thread(&wfc::SolverThread::work__, this);
+}
+
+wfc::SolverThread::~SolverThread() {
+  if (thread__.joinable()) {
+    commands__.fetch_or(COMMAND_STOP);
+    thread__.join();
+  }
+}
+
+void wfc::SolverThread::reset() {
+  commands__.fetch_or(COMMAND_RESET);
+}
+
+bool wfc::SolverThread::update() {
+  if (!(middle__.load(std::memory_order_acquire) & FRESH)) {
+    return false;
+  }
+
+  /// Hand the current front buffer back and take the newest snapshot
+
+  front__ = middle__.exchange(front__, std::memory_order_acq_rel) & INDEX_MASK;
+  return true;
+}
+
+const wfc::Snapshot& wfc::SolverThread::get_snapshot() const {
+  return buffers__[front__];
+}
+
+void wfc::SolverThread::stop() {
+  if (thread__.joinable()) {
+    commands__.fetch_or(COMMAND_STOP);
+    thread__.join();
+  }
+
+  if (error__) {
+    std::exception_ptr error = error__;
+    error__ = nullptr;
+    std::rethrow_exception(error);
+  }
+}
+
+void wfc::SolverThread::work__() {
+  try {
+    while (true) {
+
+      /// Run the commands sent since the last collapse
+
+      uint32_t commands = commands__.exchange(0);
+      if (commands & COMMAND_STOP) {
+        break;
+      }
+      if (commands & COMMAND_RESET) {
+        solver__->reset();
+      }
+
+      /// Collapse the next spot, starting over if the solver gets stuck
+
+      bool collapsed = solver__->is_collapsed();
+      if (!collapsed && !solver__->collapse_next()) {
+        solver__->reset();
+      }
+
+      publish__();
+
+      if (collapsed) {
+        std::this_thread::sleep_for(IDLE_DELAY);
+      }
+      else if (interval__ > 0) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(interval__));
+      }
+    }
+  }
+  catch (...) {
+    error__ = std::current_exception();
+  }
+}
+
+void wfc::SolverThread::publish__() {
+  if (middle__.load(std::memory_order_acquire) & FRESH) {
+    return;
+  }
+
+  solver__->take_dirty(dirty__);
+  if (dirty__.empty()) {
+    return;
+  }
+
+  /// Bring the back buffer up to date with the snapshots it missed and the new changes
+
+  wfc::Snapshot& snapshot = buffers__[back__];
+  for (uint32_t idx : pending__[back__]) {
+    snapshot.tiles[idx] = tile_id(solver__, idx);
+  }
+  pending__[back__].clear();
+
+  for (uint32_t idx : dirty__) {
+    snapshot.tiles[idx] = tile_id(solver__, idx);
+  }
+  for (uint8_t b = 0; b < 3; ++b) {
+    if (b != back__) {
+      pending__[b].insert(pending__[b].end(), dirty__.begin(), dirty__.end());
+    }
+  }
+  snapshot.dirty.swap(dirty__);
+  snapshot.collapsed = solver__->is_collapsed();
+
+  /// Publish the back buffer and take the one the viewer handed back
+
+  back__ = middle__.exchange(back__ | FRESH, std::memory_order_acq_rel) & INDEX_MASK;
+}
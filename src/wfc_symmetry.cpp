@@ -0,0 +1,103 @@
+#include "wfc_symmetry.h"
+
+#include <cstring>
+
+size_t wfc::variant_count(wfc::Symmetry p_symmetry) {
+  switch (p_symmetry) {
+    case wfc::Symmetry::X: return 1;
+    case wfc::Symmetry::I: return 2;
+    case wfc::Symmetry::BACKSLASH: return 2;
+    case wfc::Symmetry::T: return 4;
+    case wfc::Symmetry::L: return 4;
+    case wfc::Symmetry::F: return 8;
+  }
+  return 1;
+}
+
+size_t wfc::rotate_variant(wfc::Symmetry p_symmetry, size_t p_variant) {
+  switch (p_symmetry) {
+    case wfc::Symmetry::X: return p_variant;
+    case wfc::Symmetry::I: return 1 - p_variant;
+    case wfc::Symmetry::BACKSLASH: return 1 - p_variant;
+    case wfc::Symmetry::T: return (p_variant + 1) % 4;
+    case wfc::Symmetry::L: return (p_variant + 1) % 4;
+
+    /// Mirrored variants turn the other way, since mirroring and then turning clockwise is turning
+    /// counterclockwise and then mirroring
+
+    case wfc::Symmetry::F: return p_variant < 4 ? (p_variant + 1) % 4 : 4 + (p_variant + 3) % 4;
+  }
+  return p_variant;
+}
+
+size_t wfc::reflect_variant(wfc::Symmetry p_symmetry, size_t p_variant) {
+  switch (p_symmetry) {
+    case wfc::Symmetry::X: return p_variant;
+    case wfc::Symmetry::I: return p_variant;
+    case wfc::Symmetry::BACKSLASH: return 1 - p_variant;
+    case wfc::Symmetry::T: return (4 - p_variant) % 4;
+    case wfc::Symmetry::L: return (5 - p_variant) % 4;
+    case wfc::Symmetry::F: return p_variant < 4 ? p_variant + 4 : p_variant - 4;
+  }
+  return p_variant;
+}
+
+size_t wfc::transform_variant(wfc::Symmetry p_symmetry, size_t p_variant, size_t p_transform) {
+  for (size_t r = 0; r < p_transform % 4; ++r) {
+    p_variant = rotate_variant(p_symmetry, p_variant);
+  }
+  return p_transform >= 4 ? reflect_variant(p_symmetry, p_variant) : p_variant;
+}
+
+wfc::Directions wfc::transform_direction(wfc::Directions p_dir, size_t p_transform) {
+
+  /// Directions are listed clockwise, a quarter turn is two steps and mirroring left to right
+  /// keeps north and south
+
+  size_t dir = (static_cast<size_t>(p_dir) + 2 * (p_transform % 4)) % wfc::DIRECTION_COUNT;
+  if (p_transform >= 4) {
+    dir = (wfc::DIRECTION_COUNT - dir) % wfc::DIRECTION_COUNT;
+  }
+  return static_cast<wfc::Directions>(dir);
+}
+
+std::string wfc::mirror_socket(const std::string& p_socket) {
+  if (p_socket.empty()) {
+    return p_socket;
+  }
+
+  std::string mirror = p_socket;
+  if (mirror.back() == '>') {
+    mirror.back() = '<';
+  }
+  else if (mirror.back() == '<') {
+    mirror.back() = '>';
+  }
+  return mirror;
+}
+
+std::vector<uint8_t> wfc::transform_image(const uint8_t* p_pixels, size_t p_width, size_t p_height, size_t p_pitch,
+                                          size_t p_transform, size_t& p_out_width, size_t& p_out_height) {
+  size_t turns = p_transform % 4;
+  bool mirror = p_transform >= 4;
+  p_out_width = turns % 2 == 0 ? p_width : p_height;
+  p_out_height = turns % 2 == 0 ? p_height : p_width;
+
+  /// Find the source pixel of every pixel of the result, undoing the mirror and then the turns
+
+  std::vector<uint8_t> pixels(p_out_width * p_out_height * 4);
+  for (size_t y = 0; y < p_out_height; ++y) {
+    for (size_t x = 0; x < p_out_width; ++x) {
+      size_t tx = mirror ? p_out_width - 1 - x : x;
+      size_t sx, sy;
+      switch (turns) {
+        case 0: sx = tx; sy = y; break;
+        case 1: sx = y; sy = p_height - 1 - tx; break;
+        case 2: sx = p_width - 1 - tx; sy = p_height - 1 - y; break;
+        default: sx = p_width - 1 - y; sy = tx; break;
+      }
+      std::memcpy(&pixels[(y * p_out_width + x) * 4], p_pixels + sy * p_pitch + sx * 4, 4);
+    }
+  }
+  return pixels;
+}
@@ -1,60 +1,102 @@
 #include "wfc_tile.h"
-#include "wfc_log.h"
 
-#include <sstream>
+#include <algorithm>
 
-#include <SDL2/SDL_image.h>
+wfc::Tile::Tile(const std::string& p_path, size_t p_transform):
+  path__(p_path),
+  transform__(p_transform),
+  width__(0),
+  height__(0),
+  id__(0),
+  weight__(1.0) {
+  std::fill(sockets__, sockets__ + wfc::DIRECTION_COUNT, wfc::NO_SOCKET);
+  std::fill(mirror_sockets__, mirror_sockets__ + wfc::DIRECTION_COUNT, wfc::NO_SOCKET);
+  std::fill(closed__, closed__ + wfc::DIRECTION_COUNT, false);
+}
+
+wfc::Tile::Tile(const std::vector<uint8_t>& p_pixels, size_t p_width, size_t p_height):
+  transform__(0),
+  pixels__(p_pixels),
+  width__(p_width),
+  height__(p_height),
+  id__(0),
+  weight__(1.0) {
+  std::fill(sockets__, sockets__ + wfc::DIRECTION_COUNT, wfc::NO_SOCKET);
+  std::fill(mirror_sockets__, mirror_sockets__ + wfc::DIRECTION_COUNT, wfc::NO_SOCKET);
+  std::fill(closed__, closed__ + wfc::DIRECTION_COUNT, false);
+}
+
+const std::filesystem::path& wfc::Tile::get_path() const {
+  return path__;
+}
+
+size_t wfc::Tile::get_transform() const {
+  return transform__;
+}
+
+const std::vector<uint8_t>& wfc::Tile::get_pixels() const {
+  return pixels__;
+}
 
-wfc::Tile::Tile(const std::string& p_path):
-  path__(p_path) {
+size_t wfc::Tile::get_width() const {
+  return width__;
 }
 
-wfc::Tile::Tile(const std::string& p_path, SDL_Renderer* p_renderer): wfc::Tile::Tile(p_path) {
-  load(p_renderer);
+size_t wfc::Tile::get_height() const {
+  return height__;
 }
 
-void wfc::Tile::load(SDL_Renderer* p_renderer) {
+void wfc::Tile::add_rule(wfc::Directions p_direction, uint32_t p_tile) {
+  rules__[static_cast<size_t>(p_direction)].push_back(p_tile);
+}
 
-  /// Load the image onto a SDL surface
+void wfc::Tile::add_rule(wfc::Directions p_direction, const std::initializer_list<uint32_t>& p_list) {
+  std::vector<uint32_t>& rules = rules__[static_cast<size_t>(p_direction)];
+  rules.insert(rules.end(), p_list.begin(), p_list.end());
+}
 
-  wfc::Log::info("Loading texture at " + path__.string() + "...");
-  SDL_Surface* surface = IMG_Load(path__.c_str());
-  if (!surface) {
-    std::stringstream msg;
-    msg << "Failed to load texture at " << path__;
-    throw std::runtime_error(msg.str());
-  }
+bool wfc::Tile::check_rule(wfc::Directions p_direction, uint32_t p_tile) const {
+  const std::vector<uint32_t>& rules = rules__[static_cast<size_t>(p_direction)];
+  return std::find(rules.begin(), rules.end(), p_tile) != rules.end();
+}
 
-  /// Create texture from loaded surface
+void wfc::Tile::close_rules(wfc::Directions p_dir) {
+  closed__[static_cast<size_t>(p_dir)] = true;
+}
 
-  texture__ = SDL_CreateTextureFromSurface(p_renderer, surface);
-  SDL_FreeSurface(surface);
+bool wfc::Tile::are_rules_closed(wfc::Directions p_dir) const {
+  return closed__[static_cast<size_t>(p_dir)];
+}
+
+const std::vector<uint32_t>& wfc::Tile::get_rules(wfc::Directions p_dir) const {
+  return rules__[static_cast<size_t>(p_dir)];
+}
+
+void wfc::Tile::set_socket(wfc::Directions p_dir, uint32_t p_socket, uint32_t p_mirror) {
+  sockets__[static_cast<size_t>(p_dir)] = p_socket;
+  mirror_sockets__[static_cast<size_t>(p_dir)] = p_mirror;
+}
 
-  if (!texture__) {
-    std::stringstream msg;
-    msg << "Failed to convert surface to texture for " << path__;
-    throw std::runtime_error(msg.str());
-  }
+uint32_t wfc::Tile::get_socket(wfc::Directions p_dir) const {
+  return sockets__[static_cast<size_t>(p_dir)];
 }
 
-void wfc::Tile::add_rule(wfc::Directions p_direction, Tile* p_tile) {
-  rules__[p_direction].insert(p_tile);
+uint32_t wfc::Tile::get_mirror_socket(wfc::Directions p_dir) const {
+  return mirror_sockets__[static_cast<size_t>(p_dir)];
 }
 
-void wfc::Tile::add_rule(wfc::Directions p_direction, const std::initializer_list<Tile*>& p_list) {
-  for (const auto& tile: p_list) {
-    rules__[p_direction].insert(tile);
-  }
+void wfc::Tile::set_id(uint32_t p_id) {
+  id__ = p_id;
 }
 
-bool wfc::Tile::check_rule(wfc::Directions p_direction, Tile* p_tile) {
-  return rules__[p_direction].count(p_tile);
+uint32_t wfc::Tile::get_id() const {
+  return id__;
 }
 
-std::unordered_set<wfc::Tile*> wfc::Tile::get_rules(wfc::Directions p_dir) {
-  return rules__[p_dir];
+void wfc::Tile::set_weight(double p_weight) {
+  weight__ = p_weight;
 }
 
-SDL_Texture* wfc::Tile::get_texture() const {
-  return texture__;
+double wfc::Tile::get_weight() const {
+  return weight__;
 }
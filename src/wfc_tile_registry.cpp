@@ -0,0 +1,19 @@
+#include "wfc_tile_registry.h"
+
+uint32_t wfc::TileRegistry::intern(const std::string& p_name) {
+  auto [it, inserted] = ids__.emplace(p_name, static_cast<uint32_t>(names__.size()));
+  if (inserted) {
+    names__.push_back(p_name);
+  }
+  return it->second;
+}
+
+uint32_t wfc::TileRegistry::find(const std::string& p_name) const {
+  auto it = ids__.find(p_name);
+  return it == ids__.end() ? wfc::NO_TILE : it->second;
+}
+
+void wfc::TileRegistry::reserve(size_t p_count) {
+  names__.reserve(p_count);
+  ids__.reserve(p_count);
+}
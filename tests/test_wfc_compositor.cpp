@@ -0,0 +1,141 @@
+#include "wfc_compositor.h"
+#include "wfc_solver.h"
+#include "wfc_directions.h"
+#include "wfc_test.h"
+
+#include <cstring>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include <SDL2/SDL_image.h>
+
+using wfc::Directions;
+using wfc::Solver;
+using wfc::Compositor;
+
+void test() {
+  Solver solver(3, 5);
+
+  solver.add_tile("blank", "tiles/blank.png");
+  solver.add_tile("up", "tiles/up.png");
+
+  /// Compose before anything is collapsed
+
+  Compositor compositor(solver.get_tiles());
+  size_t tile_width = compositor.get_tile_width();
+  size_t tile_height = compositor.get_tile_height();
+  size_t pitch = solver.get_columns() * tile_width * 4;
+  std::vector<uint8_t> pixels(solver.get_rows() * tile_height * pitch, 1);
+
+  compositor.compose_rows(solver, 0, solver.get_rows(), pixels.data(), pitch);
+  bool transparent = true;
+  for (uint8_t value : pixels) {
+    transparent = transparent && value == 0;
+  }
+  test_case(transparent);
+
+  /// Every spot of a solved grid must hold the exact pixels of its tile
+
+  solver.set_seed(3);
+  solver.reset();
+  while (!solver.is_collapsed() && solver.collapse_next()) {
+  }
+  test_case(solver.is_collapsed());
+
+  compositor.compose_rows(solver, 0, solver.get_rows(), pixels.data(), pitch);
+  bool exact = true;
+  for (size_t idx = 0; idx < solver.get_rows() * solver.get_columns(); ++idx) {
+    SDL_Surface* loaded = IMG_Load(solver.get_tile(idx)->get_path().c_str());
+    SDL_Surface* tile = SDL_ConvertSurfaceFormat(loaded, SDL_PIXELFORMAT_RGBA32, 0);
+    size_t row = idx / solver.get_columns();
+    size_t col = idx % solver.get_columns();
+
+    for (size_t y = 0; y < tile_height; ++y) {
+      const uint8_t* out = &pixels[(row * tile_height + y) * pitch + col * tile_width * 4];
+      const uint8_t* src = static_cast<const uint8_t*>(tile->pixels) + y * tile->pitch;
+      exact = exact && std::memcmp(out, src, tile_width * 4) == 0;
+    }
+
+    SDL_FreeSurface(tile);
+    SDL_FreeSurface(loaded);
+  }
+  test_case(exact);
+
+  /// A band only covers its own rows
+
+  std::vector<uint8_t> band(tile_height * pitch);
+  compositor.compose_rows(solver, 2, 1, band.data(), pitch);
+  test_case(std::memcmp(band.data(), &pixels[2 * tile_height * pitch], band.size()) == 0);
+
+  /// Saved images must decode to the composed pixels, whether bands are compressed in parallel
+
+  bool decoded = true;
+  for (size_t threads : {1, 3}) {
+    std::string path = "test_wfc_compositor_" + std::to_string(threads) + ".png";
+    std::remove(path.c_str());
+    compositor.save_image(solver, path, threads);
+
+    SDL_Surface* loaded = IMG_Load(path.c_str());
+    SDL_Surface* image = loaded ? SDL_ConvertSurfaceFormat(loaded, SDL_PIXELFORMAT_RGBA32, 0) : nullptr;
+    decoded = decoded && image && static_cast<size_t>(image->w) * 4 == pitch;
+    for (size_t y = 0; decoded && y < pixels.size() / pitch; ++y) {
+      const uint8_t* line = static_cast<const uint8_t*>(image->pixels) + y * image->pitch;
+      decoded = std::memcmp(line, &pixels[y * pitch], pitch) == 0;
+    }
+
+    SDL_FreeSurface(image);
+    SDL_FreeSurface(loaded);
+    std::remove(path.c_str());
+  }
+  test_case(decoded);
+
+  /// PPM output drops alpha and keeps the colours
+
+  std::remove("test_wfc_compositor.ppm");
+  compositor.save_image(solver, "test_wfc_compositor.ppm");
+  std::ifstream ppm("test_wfc_compositor.ppm", std::ios::binary);
+  std::vector<uint8_t> data((std::istreambuf_iterator<char>(ppm)), std::istreambuf_iterator<char>());
+  std::string header = "P6\n" + std::to_string(pitch / 4) + " " + std::to_string(pixels.size() / pitch) + "\n255\n";
+  bool rgb = data.size() == header.size() + pixels.size() / 4 * 3 &&
+             std::equal(header.begin(), header.end(), data.begin());
+  for (size_t i = 0; rgb && i < pixels.size() / 4; ++i) {
+    rgb = std::memcmp(&data[header.size() + i * 3], &pixels[i * 4], 3) == 0;
+  }
+  test_case(rgb);
+  std::remove("test_wfc_compositor.ppm");
+
+  /// The last level of the mip chains gives one pixel per spot in the average colour of its tile
+
+  size_t last = compositor.get_level_count() - 1;
+  test_case(compositor.get_tile_width(last) == 1 && compositor.get_tile_height(last) == 1);
+
+  std::vector<uint32_t> colours(solver.get_rows() * solver.get_columns());
+  compositor.compose_rows(solver, 0, solver.get_rows(), reinterpret_cast<uint8_t*>(colours.data()),
+                          solver.get_columns() * 4, last);
+  bool averages = true;
+  for (size_t idx = 0; idx < colours.size(); ++idx) {
+    averages = averages && colours[idx] == compositor.get_colours()[solver.get_tile(idx)->get_id()];
+  }
+  test_case(averages);
+
+  /// Levels past the last one are saved as the last one
+
+  std::remove("test_wfc_compositor_lod.ppm");
+  compositor.save_image(solver, "test_wfc_compositor_lod.ppm", 1, 100);
+  std::ifstream lod("test_wfc_compositor_lod.ppm", std::ios::binary);
+  std::string lod_header;
+  std::getline(lod, lod_header);
+  std::getline(lod, lod_header);
+  test_case(lod_header == std::to_string(solver.get_columns()) + " " + std::to_string(solver.get_rows()));
+  std::remove("test_wfc_compositor_lod.ppm");
+
+  test_results();
+}
+
+int main(void) {
+  test();
+  return 0;
+}
@@ -0,0 +1,189 @@
+#include "wfc.h"
+#include "wfc_edge_rules.h"
+#include "wfc_random.h"
+#include "wfc_test.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+using wfc::Directions;
+using wfc::EdgeRules;
+
+const size_t SIZE = 8;
+
+/*
+ * Build a SIZE x SIZE tile whose edges are filled with the given grey levels, the inside is noise
+ */
+std::vector<uint32_t> tile(uint8_t p_north, uint8_t p_east, uint8_t p_south, uint8_t p_west, wfc::Random& p_random) {
+  auto grey = [](uint8_t p_level) {
+    return 0xff000000u | (p_level << 16) | (p_level << 8) | p_level;
+  };
+
+  std::vector<uint32_t> pixels(SIZE * SIZE);
+  for (uint32_t& pixel : pixels) {
+    pixel = p_random.next();
+  }
+  for (size_t i = 0; i < SIZE; ++i) {
+    pixels[i] = grey(p_north);
+    pixels[(SIZE - 1) * SIZE + i] = grey(p_south);
+    pixels[i * SIZE] = grey(p_west);
+    pixels[i * SIZE + SIZE - 1] = grey(p_east);
+  }
+
+  /// Corners belong to two edges, give them one colour so both edges stay flat
+
+  pixels[0] = pixels[SIZE - 1] = pixels[(SIZE - 1) * SIZE] = pixels[SIZE * SIZE - 1] = grey(0);
+  return pixels;
+}
+
+/*
+ * Get the tiles that can be placed in the given direction of a tile
+ */
+std::vector<uint32_t> compatible(const EdgeRules& p_rules, size_t p_tile, Directions p_dir) {
+  const uint32_t* ids = p_rules.get_compatible(p_tile, p_dir);
+  return std::vector<uint32_t>(ids, ids + p_rules.get_compatible_count(p_tile, p_dir));
+}
+
+/*
+ * Check the rules against comparing the facing edges of every pair of tiles
+ */
+bool same_as_pairs(const EdgeRules& p_rules, const std::vector<std::vector<uint32_t>>& p_tiles, int p_tolerance) {
+  auto edge = [](const std::vector<uint32_t>& p_tile, size_t p_side, size_t p_i) {
+    switch (p_side) {
+      case 0: return p_tile[p_i];
+      case 1: return p_tile[p_i * SIZE + SIZE - 1];
+      case 2: return p_tile[(SIZE - 1) * SIZE + p_i];
+      default: return p_tile[p_i * SIZE];
+    }
+  };
+
+  for (size_t side = 0; side < 4; ++side) {
+    for (size_t a = 0; a < p_tiles.size(); ++a) {
+      std::vector<uint32_t> expected;
+      for (size_t b = 0; b < p_tiles.size(); ++b) {
+        bool match = true;
+        for (size_t i = 0; i < SIZE; ++i) {
+          uint32_t pa = edge(p_tiles[a], side, i);
+          uint32_t pb = edge(p_tiles[b], (side + 2) % 4, i);
+          for (size_t c = 0; c < 32; c += 8) {
+            match = match && std::abs(int((pa >> c) & 0xff) - int((pb >> c) & 0xff)) <= p_tolerance;
+          }
+        }
+        if (match) {
+          expected.push_back(b);
+        }
+      }
+      if (compatible(p_rules, a, static_cast<Directions>(side * 2)) != expected) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+/*
+ * Build rules from a set of tiles
+ */
+EdgeRules build(const std::vector<std::vector<uint32_t>>& p_tiles, size_t p_tolerance, size_t p_threads) {
+  EdgeRules rules(p_tolerance);
+  for (const std::vector<uint32_t>& pixels : p_tiles) {
+    rules.add_tile(reinterpret_cast<const uint8_t*>(pixels.data()), SIZE, SIZE, SIZE * 4);
+  }
+  rules.compile(p_threads);
+  return rules;
+}
+
+void test() {
+  wfc::Random random(3);
+
+  /// A tile fits east of another when its west edge is the east edge of the other
+
+  std::vector<std::vector<uint32_t>> tiles = {tile(10, 20, 30, 40, random),
+                                              tile(50, 40, 60, 20, random),
+                                              tile(30, 20, 10, 40, random)};
+  EdgeRules rules = build(tiles, 0, 1);
+  test_case(compatible(rules, 0, Directions::EAST) == std::vector<uint32_t>{1} &&
+            compatible(rules, 1, Directions::WEST) == std::vector<uint32_t>{0, 2} &&
+            compatible(rules, 0, Directions::SOUTH) == std::vector<uint32_t>{2} &&
+            compatible(rules, 2, Directions::NORTH) == std::vector<uint32_t>{0} &&
+            compatible(rules, 1, Directions::NORTH).empty());
+
+  /// Diagonals have no edges
+
+  test_case(rules.get_compatible_count(0, Directions::NORTH_EAST) == 0 &&
+            rules.get_compatible_count(2, Directions::SOUTH_WEST) == 0);
+
+  /// Edges a few levels apart only match with a tolerance
+
+  tiles = {tile(10, 100, 30, 40, random), tile(50, 40, 60, 103, random)};
+  test_case(build(tiles, 0, 1).get_compatible_count(0, Directions::EAST) == 0);
+  test_case(compatible(build(tiles, 3, 1), 0, Directions::EAST) == std::vector<uint32_t>{1});
+
+  /// Random tiles match the same tiles as comparing every pair, with and without a tolerance
+
+  tiles.clear();
+  for (size_t t = 0; t < 200; ++t) {
+    tiles.push_back(tile(random.next() % 6 * 4, random.next() % 6 * 4, random.next() % 6 * 4,
+                         random.next() % 6 * 4, random));
+  }
+  test_case(same_as_pairs(build(tiles, 0, 3), tiles, 0));
+  test_case(same_as_pairs(build(tiles, 4, 3), tiles, 4));
+
+  /// The rules do not depend on the number of threads
+
+  EdgeRules one = build(tiles, 4, 1);
+  EdgeRules many = build(tiles, 4, 5);
+  bool same = true;
+  for (size_t t = 0; t < tiles.size(); ++t) {
+    for (size_t d = 0; d < wfc::DIRECTION_COUNT; ++d) {
+      same = same && compatible(one, t, static_cast<Directions>(d)) == compatible(many, t, static_cast<Directions>(d));
+    }
+  }
+  test_case(same);
+
+  /// In the solver an edge that matches nothing allows no tile, so two tiles whose facing east and
+  /// west edges match nothing never sit side by side, while their matching north and south do
+
+  tiles = {tile(0, 200, 0, 50, random), tile(0, 100, 0, 150, random)};
+  wfc::Solver solver(4, 4);
+  std::vector<wfc::TileInfo> infos;
+  for (size_t t = 0; t < tiles.size(); ++t) {
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(tiles[t].data());
+    infos.emplace_back("T" + std::to_string(t), "");
+    infos.back().id = solver.add_tile(infos.back().name, std::vector<uint8_t>(bytes, bytes + SIZE * SIZE * 4),
+                                      SIZE, SIZE);
+    infos.back().auto_rules = true;
+  }
+  wfc::add_edge_rules(&solver, build(tiles, 0, 1), infos);
+  solver.compile_rules();
+  const wfc::Rules& compiled = solver.get_rules();
+  bool apart = true;
+  for (uint32_t a = 0; a < 2; ++a) {
+    for (uint32_t b = 0; b < 2; ++b) {
+      apart = apart && !compiled.check(a, Directions::EAST, b) && !compiled.check(a, Directions::WEST, b) &&
+              compiled.check(a, Directions::SOUTH, b);
+    }
+  }
+  test_case(apart);
+
+  /// Inferring the rules of 2000 tiles
+
+  tiles.clear();
+  for (size_t t = 0; t < 2000; ++t) {
+    tiles.push_back(tile(random.next() % 16, random.next() % 16, random.next() % 16, random.next() % 16, random));
+  }
+  auto start = std::chrono::steady_clock::now();
+  EdgeRules large = build(tiles, 0, 4);
+  double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  printf("Rules of 2000 tiles inferred in %.3f s\n", elapsed);
+  test_case(large.get_compatible_count(7, Directions::EAST) > 0);
+
+  test_results();
+}
+
+int main(void) {
+  test();
+  return 0;
+}
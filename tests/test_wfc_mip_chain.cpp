@@ -0,0 +1,52 @@
+#include "wfc_mip_chain.h"
+#include "wfc_test.h"
+
+#include <vector>
+
+using wfc::MipChain;
+
+void test() {
+  /// A 4x4 image halves twice down to its average colour
+
+  std::vector<uint8_t> image(4 * 4 * 4);
+  for (size_t i = 0; i < 16; ++i) {
+    image[i * 4] = i * 16;
+    image[i * 4 + 1] = 255;
+    image[i * 4 + 2] = i < 8 ? 0 : 200;
+    image[i * 4 + 3] = 255;
+  }
+
+  MipChain chain(image.data(), 4, 4, 16);
+  test_case(chain.get_level_count() == 3);
+  test_case(chain.get_width(1) == 2 && chain.get_height(1) == 2 && chain.get_width(2) == 1);
+
+  const uint8_t* half = chain.get_pixels(1);
+  test_case(half[0] == 40 && half[2] == 0 && half[8] == 168 && half[10] == 200);
+
+  const uint8_t* average = chain.get_average();
+  test_case(average[0] == 120 && average[1] == 255 && average[2] == 100 && average[3] == 255);
+
+  /// Lines are read with the given pitch and odd sizes keep their last column
+
+  std::vector<uint8_t> padded(3 * 8, 0);
+  for (size_t x = 0; x < 3; ++x) {
+    padded[x * 4] = x * 30;
+    padded[x * 4 + 3] = 255;
+  }
+
+  MipChain odd(padded.data(), 3, 1, 24);
+  test_case(odd.get_level_count() == 3 && odd.get_width(1) == 2 && odd.get_height(1) == 1);
+  test_case(odd.get_pixels(1)[0] == 15 && odd.get_pixels(1)[4] == 60 && odd.get_average()[0] == 38);
+
+  /// A single pixel is its own chain
+
+  MipChain single(image.data(), 1, 1, 4);
+  test_case(single.get_level_count() == 1 && single.get_average()[1] == 255);
+
+  test_results();
+}
+
+int main(void) {
+  test();
+  return 0;
+}
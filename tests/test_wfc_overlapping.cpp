@@ -0,0 +1,303 @@
+#include "wfc.h"
+#include "wfc_overlapping.h"
+#include "wfc_random.h"
+#include "wfc_test.h"
+
+#include <chrono>
+#include <cstdio>
+#include <map>
+#include <stdexcept>
+#include <vector>
+
+using wfc::Directions;
+using wfc::OverlappingModel;
+
+const uint32_t A = 0xff0000ff;
+const uint32_t B = 0xff00ff00;
+
+/*
+ * Build a sample with p_colours colours picked at random
+ */
+std::vector<uint32_t> noise(size_t p_width, size_t p_height, uint32_t p_colours, uint64_t p_seed) {
+  wfc::Random random(p_seed);
+  std::vector<uint32_t> pixels(p_width * p_height);
+  for (uint32_t& pixel : pixels) {
+    pixel = 0xff000000 | (random.next() % p_colours);
+  }
+  return pixels;
+}
+
+/*
+ * Learn the patterns of a sample with compatible patterns in all 8 directions
+ */
+OverlappingModel learn(const std::vector<uint32_t>& p_pixels, size_t p_width, size_t p_height, size_t p_size,
+                       size_t p_symmetry, bool p_periodic, size_t p_threads) {
+  return OverlappingModel(reinterpret_cast<const uint8_t*>(p_pixels.data()), p_width, p_height, p_width * 4,
+                          p_size, p_symmetry, p_periodic, wfc::DirectionType::OCT_DIRECTIONS, p_threads);
+}
+
+/*
+ * Get the patterns that can be placed in the given direction of a pattern
+ */
+std::vector<uint32_t> compatible(const OverlappingModel& p_model, size_t p_pattern, Directions p_dir) {
+  const uint32_t* ids = p_model.get_compatible(p_pattern, p_dir);
+  return std::vector<uint32_t>(ids, ids + p_model.get_compatible_count(p_pattern, p_dir));
+}
+
+/*
+ * Count the windows of a sample one by one
+ */
+std::map<std::vector<uint32_t>, double> count_windows(const std::vector<uint32_t>& p_pixels, size_t p_width,
+                                                      size_t p_height, size_t p_size, bool p_periodic) {
+  std::map<std::vector<uint32_t>, double> counts;
+  size_t columns = p_periodic ? p_width : p_width - p_size + 1;
+  size_t rows = p_periodic ? p_height : p_height - p_size + 1;
+  for (size_t y = 0; y < rows; ++y) {
+    for (size_t x = 0; x < columns; ++x) {
+      std::vector<uint32_t> window;
+      for (size_t j = 0; j < p_size; ++j) {
+        for (size_t i = 0; i < p_size; ++i) {
+          window.push_back(p_pixels[((y + j) % p_height) * p_width + (x + i) % p_width]);
+        }
+      }
+      counts[window] += 1;
+    }
+  }
+  return counts;
+}
+
+/*
+ * Check that the patterns and weights of a model are the counted windows
+ */
+bool same_patterns(const OverlappingModel& p_model, const std::map<std::vector<uint32_t>, double>& p_counts) {
+  if (p_model.get_pattern_count() != p_counts.size()) {
+    return false;
+  }
+  size_t area = p_model.get_size() * p_model.get_size();
+  for (size_t p = 0; p < p_model.get_pattern_count(); ++p) {
+    std::vector<uint32_t> window(p_model.get_pattern(p), p_model.get_pattern(p) + area);
+    auto it = p_counts.find(window);
+    if (it == p_counts.end() || it->second != p_model.get_weight(p)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/*
+ * Check if the pixels of pattern p_b agree with pattern p_a where it overlaps it in the given
+ * direction of p_a
+ */
+bool overlaps(const OverlappingModel& p_model, size_t p_a, size_t p_dir, size_t p_b) {
+  const int dx[] = {0, 1, 1, 1, 0, -1, -1, -1};
+  const int dy[] = {-1, -1, 0, 1, 1, 1, 0, -1};
+  int n = p_model.get_size();
+
+  for (int y = 0; y < n; ++y) {
+    for (int x = 0; x < n; ++x) {
+      int bx = x - dx[p_dir];
+      int by = y - dy[p_dir];
+      if (bx >= 0 && bx < n && by >= 0 && by < n &&
+          p_model.get_pattern(p_a)[y * n + x] != p_model.get_pattern(p_b)[by * n + bx]) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+/*
+ * Check every pair of patterns in every direction against their pixels
+ */
+bool same_compatible(const OverlappingModel& p_model) {
+  for (size_t d = 0; d < wfc::DIRECTION_COUNT; ++d) {
+    for (size_t a = 0; a < p_model.get_pattern_count(); ++a) {
+      std::vector<uint32_t> expected;
+      for (size_t b = 0; b < p_model.get_pattern_count(); ++b) {
+        if (overlaps(p_model, a, d, b)) {
+          expected.push_back(b);
+        }
+      }
+      if (compatible(p_model, a, static_cast<Directions>(d)) != expected) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+/*
+ * Solve a canvas with the patterns of a quad direction model as tiles, trying seeds until one
+ * solves it. Every pair of collapsed neighbours met on the way must overlap
+ *
+ * Returns:
+ *        true if a seed solved the canvas, p_overlapping is false if any neighbours did not overlap
+ */
+bool solve_patterns(const OverlappingModel& p_model, size_t p_rows, size_t p_columns, bool& p_overlapping) {
+  wfc::Solver solver(p_rows, p_columns);
+  solver.set_direction_type(wfc::DirectionType::QUAD_DIRECTIONS);
+  wfc::add_patterns(&solver, p_model, wfc::DirectionType::QUAD_DIRECTIONS);
+  solver.compile_rules();
+
+  p_overlapping = true;
+  for (uint64_t seed = 0; seed < 20; ++seed) {
+    solver.set_seed(seed);
+    solver.reset();
+    while (!solver.is_collapsed() && solver.collapse_next()) {
+    }
+
+    for (size_t s = 0; s < p_rows * p_columns; ++s) {
+      const wfc::Tile* tile = solver.get_tile(s);
+      const wfc::Tile* east = (s % p_columns + 1 < p_columns) ? solver.get_tile(s + 1) : nullptr;
+      const wfc::Tile* south = (s + p_columns < p_rows * p_columns) ? solver.get_tile(s + p_columns) : nullptr;
+      if (tile != nullptr && east != nullptr) {
+        p_overlapping = p_overlapping && overlaps(p_model, tile->get_id(), 2, east->get_id());
+      }
+      if (tile != nullptr && south != nullptr) {
+        p_overlapping = p_overlapping && overlaps(p_model, tile->get_id(), 4, south->get_id());
+      }
+    }
+    if (solver.is_collapsed()) {
+      return true;
+    }
+  }
+  return false;
+}
+
+/*
+ * Check that two models learned with different thread counts are identical
+ */
+bool same_model(const OverlappingModel& p_a, const OverlappingModel& p_b) {
+  if (p_a.get_pattern_count() != p_b.get_pattern_count()) {
+    return false;
+  }
+  size_t area = p_a.get_size() * p_a.get_size();
+  for (size_t p = 0; p < p_a.get_pattern_count(); ++p) {
+    if (!std::equal(p_a.get_pattern(p), p_a.get_pattern(p) + area, p_b.get_pattern(p)) ||
+        p_a.get_weight(p) != p_b.get_weight(p)) {
+      return false;
+    }
+    for (size_t d = 0; d < wfc::DIRECTION_COUNT; ++d) {
+      if (compatible(p_a, p, static_cast<Directions>(d)) != compatible(p_b, p, static_cast<Directions>(d))) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+void test() {
+
+  /// Vertical stripes have two 2x2 patterns that alternate from west to east
+
+  std::vector<uint32_t> stripes = {A, B, A, B,
+                                   A, B, A, B,
+                                   A, B, A, B,
+                                   A, B, A, B};
+  OverlappingModel model = learn(stripes, 4, 4, 2, 1, true, 1);
+  test_case(model.get_pattern_count() == 2 && model.get_pattern(0)[0] == A && model.get_pattern(1)[0] == B &&
+            model.get_weight(0) == 8 && model.get_weight(1) == 8);
+  test_case(compatible(model, 0, Directions::EAST) == std::vector<uint32_t>{1} &&
+            compatible(model, 0, Directions::WEST) == std::vector<uint32_t>{1} &&
+            compatible(model, 0, Directions::NORTH) == std::vector<uint32_t>{0} &&
+            compatible(model, 1, Directions::SOUTH) == std::vector<uint32_t>{1});
+
+  /// Rotating the stripes adds the two horizontal patterns
+
+  model = learn(stripes, 4, 4, 2, 8, true, 1);
+  test_case(model.get_pattern_count() == 4 && model.get_weight(0) == 32);
+
+  /// Patterns and weights match counting every window, with or without wrapping around
+
+  std::vector<uint32_t> sample = noise(37, 23, 3, 7);
+  test_case(same_patterns(learn(sample, 37, 23, 3, 1, true, 3), count_windows(sample, 37, 23, 3, true)));
+  test_case(same_patterns(learn(sample, 37, 23, 3, 1, false, 3), count_windows(sample, 37, 23, 3, false)));
+
+  /// Compatibility matches comparing the pixels of every pair of patterns
+
+  std::vector<uint32_t> small = noise(12, 9, 2, 3);
+  test_case(same_compatible(learn(small, 12, 9, 3, 8, true, 2)));
+  test_case(same_compatible(learn(small, 12, 9, 2, 2, false, 2)));
+
+  /// The model does not depend on the number of threads
+
+  test_case(same_model(learn(sample, 37, 23, 3, 8, true, 1), learn(sample, 37, 23, 3, 8, true, 5)));
+
+  /// Quad directions leave the diagonals empty
+
+  model = OverlappingModel(reinterpret_cast<const uint8_t*>(small.data()), 12, 9, 12 * 4, 3, 8, true,
+                           wfc::DirectionType::QUAD_DIRECTIONS, 2);
+  OverlappingModel oct = learn(small, 12, 9, 3, 8, true, 2);
+  bool quad = true;
+  for (size_t p = 0; p < model.get_pattern_count(); ++p) {
+    quad = quad && model.get_compatible_count(p, Directions::NORTH_EAST) == 0 &&
+           model.get_compatible_count(p, Directions::SOUTH_WEST) == 0 &&
+           compatible(model, p, Directions::EAST) == compatible(oct, p, Directions::EAST) &&
+           compatible(model, p, Directions::NORTH) == compatible(oct, p, Directions::NORTH);
+  }
+  test_case(quad);
+
+  /// Patterns learned without wrapping around only sit next to patterns they overlap in the solver,
+  /// a pattern on the edge of the sample allows nothing past it. Nine colours give four patterns
+  /// that only fit together as the sample itself
+
+  std::vector<uint32_t> colours(9);
+  for (uint32_t c = 0; c < 9; ++c) {
+    colours[c] = 0xff000000 | c;
+  }
+  model = OverlappingModel(reinterpret_cast<const uint8_t*>(colours.data()), 3, 3, 3 * 4, 2, 1, false,
+                           wfc::DirectionType::QUAD_DIRECTIONS, 1);
+  bool overlapping;
+  test_case(model.get_pattern_count() == 4 && model.get_compatible_count(1, Directions::EAST) == 0);
+  test_case(solve_patterns(model, 2, 2, overlapping) && overlapping);
+  test_case(!solve_patterns(model, 3, 3, overlapping) && overlapping);
+
+  model = OverlappingModel(reinterpret_cast<const uint8_t*>(small.data()), 12, 9, 12 * 4, 2, 1, false,
+                           wfc::DirectionType::QUAD_DIRECTIONS, 2);
+  test_case(solve_patterns(model, 10, 10, overlapping) && overlapping);
+
+  /// Invalid sizes and symmetries are rejected
+
+  bool thrown = false;
+  try {
+    learn(stripes, 4, 4, 1, 1, true, 1);
+  }
+  catch (const std::runtime_error&) {
+    thrown = true;
+  }
+  test_case(thrown);
+
+  thrown = false;
+  try {
+    learn(stripes, 4, 4, 2, 9, true, 1);
+  }
+  catch (const std::runtime_error&) {
+    thrown = true;
+  }
+  test_case(thrown);
+
+  thrown = false;
+  try {
+    learn(noise(300, 300, 8, 5), 300, 300, 3, 1, true, 1);
+  }
+  catch (const std::runtime_error&) {
+    thrown = true;
+  }
+  test_case(thrown);
+
+  /// Learning a 512x512 sample with all 8 variants
+
+  std::vector<uint32_t> large = noise(512, 512, 2, 11);
+  auto start = std::chrono::steady_clock::now();
+  model = learn(large, 512, 512, 3, 8, true, 4);
+  double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  printf("%zu patterns learned from 512x512 sample in %.3f s\n", model.get_pattern_count(), elapsed);
+  test_case(model.get_pattern_count() == 512);
+
+  test_results();
+}
+
+int main(void) {
+  test();
+  return 0;
+}
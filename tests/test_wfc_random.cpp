@@ -0,0 +1,57 @@
+#include "wfc_random.h"
+#include "wfc_test.h"
+
+using wfc::Random;
+
+void test() {
+  /// Same seed must give the same numbers on every platform
+
+  Random random(42);
+  test_case(random.next() == 0x15780b2e0c2ec716);
+  test_case(random.next() == 0x6104d9866d113a7e);
+  test_case(random.next() == 0xae17533239e499a1);
+
+  random.seed(42);
+  const uint64_t expected[] = {0, 3, 6, 9, 9, 7, 7, 8, 7, 5};
+  bool same = true;
+  for (uint64_t value : expected) {
+    same = same && random.int_below(10) == value;
+  }
+  test_case(same);
+
+  /// Ranges
+
+  bool in_range = true;
+  for (int i = 0; i < 10000; ++i) {
+    int n = random.int_from_range(-3, 4);
+    double r = random.real_from_range(2.0, 2.5);
+    in_range = in_range && n >= -3 && n < 4 && r >= 2.0 && r < 2.5;
+  }
+  test_case(in_range);
+
+  try {
+    random.int_from_range(1, 1);
+    test_case(false);
+  }
+  catch(...) {
+    test_case(true);
+  }
+
+  /// Split streams differ from each other and from the parent
+
+  Random parent(7);
+  Random first = parent.split();
+  Random second = parent.split();
+  uint64_t a = first.next(), b = second.next(), c = parent.next();
+  test_case(a != b && b != c && a != c);
+
+  Random again(7);
+  test_case(again.split().next() == a);
+
+  test_results();
+}
+
+int main(void) {
+  test();
+  return 0;
+}
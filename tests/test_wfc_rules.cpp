@@ -0,0 +1,131 @@
+#include "wfc_rules.h"
+#include "wfc_random.h"
+#include "wfc_test.h"
+
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <vector>
+
+using wfc::Directions;
+using wfc::Rules;
+using wfc::Tile;
+
+const uint32_t SYMMETRIC = 6;  /// Sockets below this are their own mirror, the others come in pairs
+const uint32_t SOCKETS = 10;
+
+/*
+ * Get the mirror of a socket
+ */
+uint32_t mirror(uint32_t p_socket) {
+  return p_socket < SYMMETRIC ? p_socket : SYMMETRIC + ((p_socket - SYMMETRIC) ^ 1);
+}
+
+/*
+ * Build tiles with a random socket on each side
+ */
+std::vector<std::unique_ptr<Tile>> random_tiles(size_t p_count, wfc::Random& p_random) {
+  std::vector<std::unique_ptr<Tile>> tiles;
+  for (size_t t = 0; t < p_count; ++t) {
+    tiles.push_back(std::make_unique<Tile>("tile.png"));
+    tiles.back()->set_id(t);
+    for (size_t d = 0; d < wfc::DIRECTION_COUNT; d += 2) {
+      uint32_t socket = p_random.next() % SOCKETS;
+      tiles.back()->set_socket(static_cast<Directions>(d), socket, mirror(socket));
+    }
+  }
+  return tiles;
+}
+
+/*
+ * Compile the rules of tiles
+ */
+Rules compile(const std::vector<std::unique_ptr<Tile>>& p_tiles) {
+  std::vector<Tile*> list;
+  for (const std::unique_ptr<Tile>& tile : p_tiles) {
+    list.push_back(tile.get());
+  }
+  Rules rules;
+  rules.compile(list, wfc::DirectionType::QUAD_DIRECTIONS);
+  return rules;
+}
+
+/*
+ * Check the table against comparing the facing sockets of every pair of tiles
+ */
+bool same_as_pairs(const Rules& p_rules, const std::vector<std::unique_ptr<Tile>>& p_tiles) {
+  for (size_t d = 0; d < wfc::DIRECTION_COUNT; ++d) {
+    Directions dir = static_cast<Directions>(d);
+    for (size_t a = 0; a < p_tiles.size(); ++a) {
+      for (size_t b = 0; b < p_tiles.size(); ++b) {
+        bool fits = d % 2 != 0 || p_tiles[b]->get_socket(wfc::opposite(dir)) == mirror(p_tiles[a]->get_socket(dir));
+        if (p_rules.check(a, dir, b) != fits) {
+          return false;
+        }
+      }
+    }
+  }
+  return true;
+}
+
+void test() {
+  wfc::Random random(5);
+
+  /// Tiles fit where the facing sockets are mirrors of each other
+
+  std::vector<std::unique_ptr<Tile>> tiles = random_tiles(300, random);
+  test_case(same_as_pairs(compile(tiles), tiles));
+
+  /// An asymmetric socket does not fit itself
+
+  tiles = random_tiles(2, random);
+  tiles[0]->set_socket(Directions::EAST, SYMMETRIC, mirror(SYMMETRIC));
+  tiles[1]->set_socket(Directions::WEST, SYMMETRIC, mirror(SYMMETRIC));
+  test_case(!compile(tiles).check(0, Directions::EAST, 1));
+  tiles[1]->set_socket(Directions::WEST, mirror(SYMMETRIC), SYMMETRIC);
+  test_case(compile(tiles).check(0, Directions::EAST, 1) && compile(tiles).check(1, Directions::WEST, 0));
+
+  /// Rules add to the tiles a socket allows, a side with neither allows every tile
+
+  tiles = random_tiles(3, random);
+  tiles[0]->set_socket(Directions::EAST, 0, 0);
+  tiles[1]->set_socket(Directions::WEST, 1, 1);
+  tiles[2]->set_socket(Directions::WEST, wfc::NO_SOCKET, wfc::NO_SOCKET);
+  tiles[0]->add_rule(Directions::EAST, 1);
+  Rules rules = compile(tiles);
+  test_case(!rules.check(0, Directions::EAST, 1) && !rules.check(0, Directions::EAST, 2));
+  tiles[1]->add_rule(Directions::WEST, 0);
+  tiles[2]->add_rule(Directions::WEST, 0);
+  tiles[0]->add_rule(Directions::EAST, 2);
+  rules = compile(tiles);
+  test_case(rules.check(0, Directions::EAST, 1) && rules.check(0, Directions::EAST, 2));
+
+  /// A closed side without rules or socket allows nothing, instead of every tile
+
+  tiles.clear();
+  for (uint32_t t = 0; t < 2; ++t) {
+    tiles.push_back(std::make_unique<Tile>("tile.png"));
+    tiles.back()->set_id(t);
+  }
+  test_case(compile(tiles).check(0, Directions::EAST, 1));
+  tiles[0]->close_rules(Directions::EAST);
+  rules = compile(tiles);
+  test_case(!rules.check(0, Directions::EAST, 0) && !rules.check(0, Directions::EAST, 1) &&
+            !rules.check(1, Directions::WEST, 0) && rules.check(0, Directions::WEST, 1));
+
+  /// Compiling the sockets of 5000 tiles
+
+  tiles = random_tiles(5000, random);
+  auto start = std::chrono::steady_clock::now();
+  rules = compile(tiles);
+  double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  printf("Sockets of 5000 tiles compiled in %.3f s\n", elapsed);
+  test_case(rules.tile_count() == 5000);
+
+  test_results();
+}
+
+int main(void) {
+  test();
+  return 0;
+}
@@ -0,0 +1,214 @@
+#include "wfc_ruleset.h"
+#include "wfc_random.h"
+#include "wfc_test.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+using wfc::CanvasInfo;
+using wfc::Directions;
+using wfc::Solver;
+
+/*
+ * Build a solver with a tile per path and a tile with its own pixels, all with random sockets
+ */
+std::unique_ptr<Solver> socket_solver(size_t p_tiles, wfc::Random& p_random, CanvasInfo& p_canvas_info) {
+  p_canvas_info.width = 800;
+  p_canvas_info.height = 600;
+  p_canvas_info.rows = 12;
+  p_canvas_info.columns = 16;
+  p_canvas_info.direction_type = wfc::DirectionType::QUAD_DIRECTIONS;
+
+  const char* labels[] = {"a", "b", "c", "d>", "d<"};
+  auto solver = std::make_unique<Solver>(p_canvas_info.rows, p_canvas_info.columns);
+  solver->set_direction_type(p_canvas_info.direction_type);
+  for (size_t t = 0; t < p_tiles; ++t) {
+    std::string name = "T" + std::to_string(t);
+    solver->add_tile(name, "tiles/tile_" + std::to_string(t % 7) + ".png", 1.0 + t % 3, t % 8);
+    for (size_t d = 0; d < wfc::DIRECTION_COUNT; d += 2) {
+      solver->add_socket(name, static_cast<Directions>(d), labels[p_random.next() % 5]);
+    }
+  }
+  solver->add_tile("PIXEL", std::vector<uint8_t>{1, 2, 3, 255}, 1, 1, 0.5);
+  solver->compile_rules();
+  return solver;
+}
+
+/*
+ * Check if the loaded solver has the tiles and table of the solver it was saved from
+ */
+bool same_solver(const Solver& p_saved, const Solver& p_loaded) {
+  const wfc::Rules& saved = p_saved.get_rules();
+  const wfc::Rules& loaded = p_loaded.get_rules();
+  if (saved.table_size() != loaded.table_size() || p_saved.get_tile_names() != p_loaded.get_tile_names() ||
+      std::memcmp(saved.data(), loaded.data(), saved.table_size() * sizeof(uint64_t)) != 0) {
+    return false;
+  }
+
+  for (size_t t = 0; t < p_saved.get_tiles().size(); ++t) {
+    const wfc::Tile* a = p_saved.get_tiles()[t];
+    const wfc::Tile* b = p_loaded.get_tiles()[t];
+    if (a->get_path() != b->get_path() || a->get_weight() != b->get_weight() ||
+        a->get_transform() != b->get_transform() || a->get_pixels() != b->get_pixels()) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/*
+ * Check if loading a file throws
+ */
+bool load_fails(const fs::path& p_path) {
+  CanvasInfo canvas_info;
+  try {
+    delete wfc::load_ruleset(p_path, canvas_info);
+  }
+  catch (const std::runtime_error&) {
+    return true;
+  }
+  return false;
+}
+
+/*
+ * Copy a file, replacing its bytes from p_offset with p_bytes, or cutting it to p_size bytes
+ */
+void patch(const fs::path& p_from, const fs::path& p_to, size_t p_offset, const std::string& p_bytes,
+           size_t p_size = SIZE_MAX) {
+  std::ifstream in(p_from, std::ios::binary);
+  std::string data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+  data.replace(p_offset, p_bytes.size(), p_bytes);
+  data.resize(std::min(p_size, data.size()));
+  std::ofstream(p_to, std::ios::binary).write(data.data(), data.size());
+}
+
+/*
+ * Read the 64 bit number at p_offset of a file
+ */
+uint64_t read_word(const fs::path& p_path, size_t p_offset) {
+  std::ifstream in(p_path, std::ios::binary);
+  uint64_t word = 0;
+  in.seekg(p_offset);
+  in.read(reinterpret_cast<char*>(&word), sizeof(word));
+  return word;
+}
+
+/*
+ * Get the bytes of a value
+ */
+template<typename T>
+std::string bytes(T p_value) {
+  return std::string(reinterpret_cast<const char*>(&p_value), sizeof(p_value));
+}
+
+void test() {
+  wfc::Random random(11);
+  fs::path dir = fs::temp_directory_path() / "wfc_test_ruleset";
+  fs::create_directories(dir);
+  fs::current_path(dir);
+
+  /// A loaded ruleset has the canvas, tiles, table and constraints that were saved
+
+  CanvasInfo canvas_info;
+  std::unique_ptr<Solver> solver = socket_solver(40, random, canvas_info);
+  wfc::ConstraintInfo constraints;
+  constraints.top.insert("T1");
+  constraints.fixed.push_back({3, 4, {"T2"}});
+  wfc::save_ruleset(dir / "rules.wfcb", canvas_info, *solver, constraints);
+
+  CanvasInfo loaded_info;
+  std::unique_ptr<Solver> loaded(wfc::load_ruleset(dir / "rules.wfcb", loaded_info));
+  test_case(loaded_info.rows == 12 && loaded_info.columns == 16 && loaded_info.width == 800 &&
+            loaded_info.direction_type == wfc::DirectionType::QUAD_DIRECTIONS);
+  test_case(same_solver(*solver, *loaded));
+
+  /// The table is used where it is mapped and copies of the solver keep using it, compiling the
+  /// rules again keeps the loaded table
+
+  auto copy = std::make_unique<Solver>(*loaded);
+  loaded.reset();
+  copy->compile_rules();
+  test_case(same_solver(*solver, *copy));
+
+  /// The loaded solver solves like the one it was saved from, with the constraints applied
+
+  solver->add_constraint(wfc::Constraints::TOP, "T1");
+  solver->add_constraint(3, 4, "T2");
+  bool same = true;
+  bool solved = false;
+  for (uint64_t seed = 0; seed < 50 && !solved; ++seed) {
+    solver->set_seed(seed);
+    copy->set_seed(seed);
+    solver->reset();
+    copy->reset();
+    while (!solver->is_collapsed() && solver->collapse_next()) {
+      same = same && copy->collapse_next();
+    }
+    solved = solver->is_collapsed();
+  }
+  for (size_t s = 0; s < 12 * 16; ++s) {
+    const wfc::Tile* a = solver->get_tile(s);
+    const wfc::Tile* b = copy->get_tile(s);
+    same = same && (a == nullptr) == (b == nullptr) && (a == nullptr || a->get_id() == b->get_id());
+  }
+  test_case(solved && same && copy->is_collapsed() && copy->get_tile(4 * 16 + 3)->get_id() == 2);
+
+  /// Files with another magic, another version or cut short are rejected
+
+  uint32_t version = wfc::RULESET_VERSION + 1;
+  patch(dir / "rules.wfcb", dir / "magic.wfcb", 0, "WFCBRULX");
+  patch(dir / "rules.wfcb", dir / "version.wfcb", 8, std::string(reinterpret_cast<const char*>(&version), 4));
+  patch(dir / "rules.wfcb", dir / "short.wfcb", 0, "", fs::file_size(dir / "rules.wfcb") - 1);
+  test_case(load_fails(dir / "magic.wfcb") && load_fails(dir / "version.wfcb") && load_fails(dir / "short.wfcb"));
+
+  /// Corrupt files are rejected before the solver uses them: a bit past the last tile in the table,
+  /// an empty canvas, a weight that is not a number, an unknown transform and an unknown constraint
+
+  solver = socket_solver(2, random, canvas_info);
+  constraints = wfc::ConstraintInfo();
+  constraints.top.insert("T1");
+  wfc::save_ruleset(dir / "small.wfcb", canvas_info, *solver, constraints);
+  const uint64_t table_offset = read_word(dir / "small.wfcb", 72);
+  const uint64_t tiles_offset = read_word(dir / "small.wfcb", 80);
+  const uint64_t constraints_offset = read_word(dir / "small.wfcb", 96);
+  test_case(!load_fails(dir / "small.wfcb"));
+
+  uint64_t word = read_word(dir / "small.wfcb", table_offset) | (uint64_t(1) << 40);
+  patch(dir / "small.wfcb", dir / "table.wfcb", table_offset, bytes(word));
+  patch(dir / "small.wfcb", dir / "rows.wfcb", 40, bytes(uint64_t(0)));
+  patch(dir / "small.wfcb", dir / "area.wfcb", 40, bytes(uint64_t(1) << 40));
+  patch(dir / "small.wfcb", dir / "weight.wfcb", tiles_offset + 72, bytes(std::nan("")));
+  patch(dir / "small.wfcb", dir / "transform.wfcb", tiles_offset + 64, bytes(uint64_t(8)));
+  patch(dir / "small.wfcb", dir / "kind.wfcb", constraints_offset, bytes(uint32_t(99)));
+  test_case(load_fails(dir / "table.wfcb") && load_fails(dir / "rows.wfcb") && load_fails(dir / "area.wfcb"));
+  test_case(load_fails(dir / "weight.wfcb") && load_fails(dir / "transform.wfcb") && load_fails(dir / "kind.wfcb"));
+
+  /// Loading 3000 tiles from a ruleset file
+
+  solver = socket_solver(3000, random, canvas_info);
+  wfc::save_ruleset(dir / "large.wfcb", canvas_info, *solver, wfc::ConstraintInfo());
+  auto start = std::chrono::steady_clock::now();
+  loaded.reset(wfc::load_ruleset(dir / "large.wfcb", loaded_info));
+  double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  printf("Ruleset of 3000 tiles loaded in %.3f s\n", elapsed);
+  test_case(same_solver(*solver, *loaded));
+
+  fs::current_path(fs::temp_directory_path());
+  fs::remove_all(dir);
+  test_results();
+}
+
+int main(void) {
+  test();
+  return 0;
+}
@@ -0,0 +1,253 @@
+#include "wfc_solver.h"
+#include "wfc_portfolio.h"
+#include "wfc_batch.h"
+#include "wfc_directions.h"
+#include "wfc_test.h"
+
+#include <algorithm>
+
+using wfc::DirectionType;
+using wfc::Directions;
+using wfc::Solver;
+using Names = std::vector<std::string>;
+
+/*
+ * Check that a solver is collapsed and every pair of neighbouring tiles follows the rules
+ */
+bool is_consistent(const Solver& p_solver) {
+  bool consistent = p_solver.is_collapsed();
+  for (size_t row = 0; consistent && row < p_solver.get_rows(); ++row) {
+    for (size_t col = 0; col < p_solver.get_columns(); ++col) {
+      const wfc::Tile* tile = p_solver.get_tile(row * p_solver.get_columns() + col);
+      if (col + 1 < p_solver.get_columns()) {
+        const wfc::Tile* east = p_solver.get_tile(row * p_solver.get_columns() + col + 1);
+        consistent = consistent && tile->check_rule(Directions::EAST, east->get_id());
+      }
+      if (row + 1 < p_solver.get_rows()) {
+        const wfc::Tile* south = p_solver.get_tile((row + 1) * p_solver.get_columns() + col);
+        consistent = consistent && tile->check_rule(Directions::SOUTH, south->get_id());
+      }
+    }
+  }
+  return consistent;
+}
+
+/*
+ * Count the collapsed spots of a solver
+ */
+size_t count_collapsed(const Solver& p_solver) {
+  size_t count = 0;
+  for (size_t idx = 0; idx < p_solver.get_rows() * p_solver.get_columns(); ++idx) {
+    count += p_solver.get_tile(idx) != nullptr;
+  }
+  return count;
+}
+
+void test() {
+  Solver solver(20, 20);
+
+  solver.set_direction_type(DirectionType::QUAD_DIRECTIONS);
+
+  /// Initialize all tiles
+
+  solver.add_tile("up", "tiles/up.png");
+  solver.add_tile("right", "tiles/right.png");
+  solver.add_tile("down", "tiles/down.png");
+  solver.add_tile("left", "tiles/left.png");
+  solver.add_tile("blank", "tiles/blank.png");
+
+  /// Add rules for tile up
+
+  solver.add_rule("up", Directions::NORTH, Names{"right", "down", "left"});
+  solver.add_rule("up", Directions::EAST, Names{"up", "down", "left"});
+  solver.add_rule("up", Directions::SOUTH, Names{"blank", "down"});
+  solver.add_rule("up", Directions::WEST, Names{"up", "down", "right"});
+
+  /// Add rules for tile right
+
+  solver.add_rule("right", Directions::NORTH, Names{"right", "down", "left"});
+  solver.add_rule("right", Directions::EAST, Names{"up", "down", "left"});
+  solver.add_rule("right", Directions::SOUTH, Names{"right", "up", "left"});
+  solver.add_rule("right", Directions::WEST, Names{"blank", "left"});
+
+  /// Add rules for tile down
+
+  solver.add_rule("down", Directions::NORTH, Names{"blank", "up"});
+  solver.add_rule("down", Directions::EAST, Names{"left", "up", "down"});
+  solver.add_rule("down", Directions::SOUTH, Names{"up", "right", "left"});
+  solver.add_rule("down", Directions::WEST, Names{"right", "up", "down"});
+
+  /// Add rules for tile left
+
+  solver.add_rule("left", Directions::NORTH, Names{"right", "down", "left"});
+  solver.add_rule("left", Directions::EAST, Names{"blank", "right"});
+  solver.add_rule("left", Directions::SOUTH, Names{"up", "left", "right"});
+  solver.add_rule("left", Directions::WEST, Names{"right", "down", "up"});
+
+  /// Add rules for tile blank
+
+  solver.add_rule("blank", Directions::NORTH, Names{"blank", "up"});
+  solver.add_rule("blank", Directions::EAST, Names{"blank", "right"});
+  solver.add_rule("blank", Directions::SOUTH, Names{"blank", "down"});
+  solver.add_rule("blank", Directions::WEST, Names{"blank", "left"});
+
+  /// Tests
+
+  try {
+    solver.add_tile("blank", "blank.png");
+    test_case(false);
+  }
+  catch(...) {
+    test_case(true);
+  }
+
+  try {
+    solver.add_rule("tile", Directions::NORTH, "blank");
+    test_case(false);
+  }
+  catch(...) {
+    test_case(true);
+  }
+
+  try {
+    solver.add_rule("blank", Directions::EAST, Names{"blank", "tile"});
+    test_case(false);
+  }
+  catch(...) {
+    test_case(true);
+  }
+
+  /// Solve the grid without a window and check every pair of neighbours
+
+  solver.set_seed(1);
+  solver.set_backtrack_budget(1000);
+  solver.reset();
+  while (!solver.is_collapsed() && solver.collapse_next()) {
+  }
+
+  test_case(solver.is_collapsed());
+  test_case(is_consistent(solver));
+
+  /// Solve with local repair instead of backtracking, a repair uncollapses spots. The support
+  /// counters must match the domains after every step, also right after a repair
+
+  Solver repaired(solver);
+  repaired.set_backtrack_budget(0);
+  repaired.set_repair_radius(1);
+
+  size_t repairs = 0;
+  size_t repaired_solved = 0;
+  bool supported = true;
+  bool repaired_consistent = true;
+  for (uint64_t seed = 0; seed < 10; ++seed) {
+    repaired.set_seed(seed);
+    repaired.reset();
+
+    size_t collapsed = 0;
+    while (!repaired.is_collapsed() && repaired.collapse_next()) {
+      size_t count = count_collapsed(repaired);
+      repairs += count <= collapsed;
+      collapsed = count;
+      supported = supported && repaired.check_supports();
+    }
+
+    if (repaired.is_collapsed()) {
+      ++repaired_solved;
+      repaired_consistent = repaired_consistent && is_consistent(repaired);
+    }
+  }
+
+  test_case(repairs > 0);
+  test_case(supported);
+  test_case(repaired_solved == 10 && repaired_consistent);
+
+  /// Tiles added with their interned names keep the ids of the registry
+
+  wfc::TileRegistry registry;
+  registry.intern("first");
+  registry.intern("second");
+  std::vector<wfc::Tile> interned;
+  interned.emplace_back("tiles/blank.png");
+  interned.emplace_back("tiles/up.png");
+
+  Solver named(4, 4);
+  named.add_tiles(std::move(registry), std::move(interned));
+  test_case(named.get_tile_id("second") == 1 && named.get_tile_names().size() == 2);
+
+  try {
+    named.add_tiles(wfc::TileRegistry(), std::vector<wfc::Tile>());
+    test_case(false);
+  }
+  catch(...) {
+    test_case(true);
+  }
+
+  /// Switching to eight directions after a reset needs counters for the extra directions
+
+  Solver switched(4, 4);
+  switched.add_tile("open", "tiles/blank.png");
+  for (size_t d = 0; d < wfc::DIRECTION_COUNT; ++d) {
+    switched.add_rule("open", static_cast<Directions>(d), "open");
+  }
+  switched.reset();
+  switched.set_direction_type(DirectionType::OCT_DIRECTIONS);
+  switched.reset();
+  test_case(switched.check_supports());
+
+  while (!switched.is_collapsed() && switched.collapse_next()) {
+  }
+  test_case(switched.is_collapsed());
+
+  /// Racing seeds must give the same result for any number of threads
+
+  wfc::Portfolio single(solver, 1);
+  wfc::Portfolio many(solver, 4);
+  bool solved = single.solve(7, 0) && many.solve(7, 0);
+  test_case(solved && single.get_attempt() == many.get_attempt());
+
+  bool same = solved;
+  for (size_t idx = 0; same && idx < solver.get_rows() * solver.get_columns(); ++idx) {
+    same = single.get_result().get_tile(idx) == many.get_result().get_tile(idx);
+  }
+  test_case(same);
+
+  /// Every batch instance must match a single run with its seed
+
+  wfc::Batch batch(solver, 3);
+  bool batch_same = true;
+  size_t batch_solved = batch.run(5, 4, 0, [&](size_t index, const wfc::Solver* result) {
+    wfc::Portfolio reference(solver, 1);
+    batch_same = batch_same && result && reference.solve(5 + index, 0);
+    for (size_t idx = 0; batch_same && idx < solver.get_rows() * solver.get_columns(); ++idx) {
+      batch_same = result->get_tile(idx) == reference.get_result().get_tile(idx);
+    }
+  });
+  test_case(batch_solved == 4 && batch_same);
+
+  /// Every changed spot is reported once, and only until it is taken
+
+  std::vector<uint32_t> dirty;
+  solver.take_dirty(dirty);
+  std::vector<uint32_t> sorted(dirty);
+  std::sort(sorted.begin(), sorted.end());
+  bool listed = sorted.size() == solver.get_rows() * solver.get_columns();
+  for (size_t idx = 0; listed && idx < sorted.size(); ++idx) {
+    listed = sorted[idx] == idx;
+  }
+  test_case(listed);
+
+  solver.take_dirty(dirty);
+  test_case(dirty.empty());
+
+  solver.collapse_next();
+  solver.reset();
+  solver.take_dirty(dirty);
+  test_case(dirty.size() == solver.get_rows() * solver.get_columns());
+
+  test_results();
+}
+
+int main(void) {
+  test();
+  return 0;
+}
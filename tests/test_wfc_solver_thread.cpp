@@ -0,0 +1,87 @@
+#include "wfc_solver_thread.h"
+#include "wfc_solver.h"
+#include "wfc_test.h"
+
+#include <chrono>
+#include <thread>
+#include <vector>
+
+using wfc::Snapshot;
+using wfc::Solver;
+using wfc::SolverThread;
+
+/*
+ * Apply the dirty spots of every new snapshot to p_drawn until the solver is done, checking that
+ * p_drawn always matches the snapshot like a canvas drawing only the dirty spots would
+ */
+bool follow(SolverThread& p_worker, std::vector<uint32_t>& p_drawn) {
+  bool matches = true;
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+
+  while (std::chrono::steady_clock::now() < deadline) {
+    if (!p_worker.update()) {
+      std::this_thread::sleep_for(std::chrono::microseconds(100));
+      continue;
+    }
+
+    const Snapshot& snapshot = p_worker.get_snapshot();
+    for (uint32_t idx : snapshot.dirty) {
+      p_drawn[idx] = snapshot.tiles[idx];
+    }
+    matches = matches && p_drawn == snapshot.tiles;
+
+    if (snapshot.collapsed) {
+      return matches;
+    }
+  }
+
+  return false;
+}
+
+void test() {
+  Solver solver(40, 40);
+
+  solver.add_tile("blank", "tiles/blank.png");
+  solver.add_tile("up", "tiles/up.png");
+  solver.set_seed(5);
+  solver.reset();
+
+  /// A viewer that only redraws dirty spots must end up with the solved grid
+
+  SolverThread worker(&solver, 0);
+  std::vector<uint32_t> drawn(40 * 40, wfc::NO_TILE);
+  test_case(follow(worker, drawn));
+
+  /// A reset command clears the grid and the solver starts over
+
+  worker.reset();
+  bool cleared = false;
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+  while (!cleared && std::chrono::steady_clock::now() < deadline) {
+    if (worker.update()) {
+      const Snapshot& snapshot = worker.get_snapshot();
+      for (uint32_t idx : snapshot.dirty) {
+        drawn[idx] = snapshot.tiles[idx];
+      }
+      cleared = !snapshot.collapsed;
+    }
+  }
+  test_case(cleared);
+  test_case(follow(worker, drawn));
+
+  /// Once stopped the solver holds the last published state
+
+  worker.stop();
+  bool same = solver.is_collapsed();
+  for (size_t idx = 0; same && idx < drawn.size(); ++idx) {
+    same = solver.get_tile(idx) && solver.get_tile(idx)->get_id() == drawn[idx];
+  }
+  test_case(same);
+
+  test_results();
+}
+
+int main(void) {
+  test();
+  return 0;
+}
@@ -0,0 +1,212 @@
+#include "wfc_symmetry.h"
+#include "wfc_parser.h"
+#include "wfc_test.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+using wfc::Directions;
+using wfc::Symmetry;
+
+const uint32_t ON = 0xffffffff;
+const uint32_t OFF = 0xff000000;
+
+/*
+ * Build a 3x3 image from a picture of its lines, '#' for lit pixels
+ */
+std::vector<uint32_t> image(const char* p_lines) {
+  std::vector<uint32_t> pixels;
+  for (const char* c = p_lines; *c; ++c) {
+    pixels.push_back(*c == '#' ? ON : OFF);
+  }
+  return pixels;
+}
+
+/*
+ * Transform a 3x3 image
+ */
+std::vector<uint32_t> transform(const std::vector<uint32_t>& p_pixels, size_t p_transform) {
+  size_t width, height;
+  std::vector<uint8_t> bytes = wfc::transform_image(reinterpret_cast<const uint8_t*>(p_pixels.data()), 3, 3, 3 * 4,
+                                                    p_transform, width, height);
+  const uint32_t* pixels = reinterpret_cast<const uint32_t*>(bytes.data());
+  return std::vector<uint32_t>(pixels, pixels + width * height);
+}
+
+/*
+ * Check that turning or mirroring the image of every variant gives the image of the variant
+ * rotate_variant and reflect_variant name, and that the variants are distinct
+ */
+bool consistent(Symmetry p_symmetry, const std::vector<uint32_t>& p_base) {
+  size_t count = wfc::variant_count(p_symmetry);
+  for (size_t v = 0; v < count; ++v) {
+    std::vector<uint32_t> variant = transform(p_base, v);
+    if (transform(variant, 1) != transform(p_base, wfc::rotate_variant(p_symmetry, v)) ||
+        transform(variant, 4) != transform(p_base, wfc::reflect_variant(p_symmetry, v))) {
+      return false;
+    }
+    for (size_t other = 0; other < v; ++other) {
+      if (transform(p_base, other) == variant) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+/*
+ * Parse the tiles of a config written to a temporary file
+ */
+std::vector<wfc::TileInfo> parse(const std::string& p_tiles) {
+  std::filesystem::path path = std::filesystem::temp_directory_path() / "wfc_test_symmetry.json";
+  std::ofstream(path) << "{\"tiles\": " << p_tiles << "}";
+
+  wfc::Parser parser(path);
+  wfc::GroupInfo groups;
+  std::vector<wfc::TileInfo> tiles;
+  wfc::TileRegistry registry;
+  parser.parse_tiles(tiles, groups, registry);
+  std::filesystem::remove(path);
+  return tiles;
+}
+
+/*
+ * Get the sorted ids of parsed tiles by name
+ */
+std::vector<uint32_t> ids(const std::vector<wfc::TileInfo>& p_tiles, const std::vector<std::string>& p_names) {
+  std::vector<uint32_t> result;
+  for (const wfc::TileInfo& tile : p_tiles) {
+    if (std::find(p_names.begin(), p_names.end(), tile.name) != p_names.end()) {
+      result.push_back(tile.id);
+    }
+  }
+  return result;
+}
+
+/*
+ * Find a parsed tile by name
+ */
+const wfc::TileInfo* find(const std::vector<wfc::TileInfo>& p_tiles, const std::string& p_name) {
+  for (const wfc::TileInfo& tile : p_tiles) {
+    if (tile.name == p_name) {
+      return &tile;
+    }
+  }
+  return nullptr;
+}
+
+void test() {
+
+  /// Turning a quarter clockwise moves the top left pixel to the top right, mirroring to the top left
+
+  std::vector<uint32_t> corner = image("#.."
+                                       "..."
+                                       "...");
+  test_case(transform(corner, 1) == image("..#"
+                                          "..."
+                                          "...") &&
+            transform(corner, 2) == image("..."
+                                          "..."
+                                          "..#") &&
+            transform(corner, 5) == image("#.."
+                                          "..."
+                                          "..."));
+
+  /// Images that are not square swap their width and height when turned
+
+  std::vector<uint32_t> wide = {1, 2, 3, 4, 5, 6};
+  size_t width, height;
+  std::vector<uint8_t> bytes = wfc::transform_image(reinterpret_cast<const uint8_t*>(wide.data()), 3, 2, 3 * 4, 1,
+                                                    width, height);
+  const uint32_t* turned = reinterpret_cast<const uint32_t*>(bytes.data());
+  test_case(width == 2 && height == 3 && std::vector<uint32_t>(turned, turned + 6) == std::vector<uint32_t>{4, 1, 5, 2, 6, 3});
+
+  /// Directions turn and mirror with the image
+
+  test_case(wfc::transform_direction(Directions::NORTH, 1) == Directions::EAST &&
+            wfc::transform_direction(Directions::NORTH_WEST, 3) == Directions::SOUTH_WEST &&
+            wfc::transform_direction(Directions::EAST, 4) == Directions::WEST &&
+            wfc::transform_direction(Directions::NORTH, 5) == Directions::WEST);
+
+  /// The variants of every symmetry match turning and mirroring an image with that symmetry
+
+  test_case(consistent(Symmetry::X, image(".#."
+                                          "###"
+                                          ".#.")));
+  test_case(consistent(Symmetry::I, image(".#."
+                                          ".#."
+                                          ".#.")));
+  test_case(consistent(Symmetry::BACKSLASH, image("#.."
+                                                  ".#."
+                                                  "..#")));
+  test_case(consistent(Symmetry::T, image("..."
+                                          "###"
+                                          ".#.")));
+  test_case(consistent(Symmetry::L, image(".#."
+                                          "##."
+                                          "...")));
+  test_case(consistent(Symmetry::F, image("##."
+                                          ".#."
+                                          ".#.")));
+
+  /// Symmetric tiles are followed by their variants with turned rules
+
+  std::vector<wfc::TileInfo> tiles = parse(R"({
+    "line": {"path": "line.png", "symmetry": "I", "rules": {"north": ["corner", "line"]}},
+    "corner": {"path": "corner.png", "symmetry": "L", "rules": {"!west": ["corner#2"], "south": ["line#1"]}},
+    "blank": {"path": "blank.png", "rules": {}}
+  })");
+  test_case(tiles.size() == 7 && tiles[0].name == "blank" && tiles[1].name == "corner" &&
+            tiles[4].name == "corner#3" && tiles[4].transform == 3 && tiles[5].name == "line" &&
+            tiles[6].name == "line#1" && tiles[4].path == tiles[1].path && tiles[6].id == 6);
+
+  const wfc::TileInfo* line = find(tiles, "line#1");
+  test_case(line->rules.at(Directions::EAST) == ids(tiles, {"corner#1", "line#1"}) &&
+            line->rules.at(Directions::NORTH).empty());
+
+  const wfc::TileInfo* turned_corner = find(tiles, "corner#1");
+  test_case(turned_corner->rules.at(Directions::WEST) == ids(tiles, {"line"}));
+
+  /// Inverted rules are turned before they are resolved against every variant
+
+  std::vector<uint32_t> all_but_corner = ids(tiles, {"blank", "corner", "corner#1", "corner#2", "line", "line#1"});
+  test_case(turned_corner->rules.at(Directions::NORTH) == all_but_corner);
+
+  /// Sockets turn with the sides of a variant and mirror with it
+
+  tiles = parse(R"({
+    "flag": {"path": "flag.png", "symmetry": "F", "sockets": {"north": "pole", "east": "cloth>"}}
+  })");
+  const wfc::TileInfo* turned_flag = find(tiles, "flag#1");
+  const wfc::TileInfo* mirrored_flag = find(tiles, "flag#4");
+  test_case(tiles.size() == 8 && turned_flag->sockets.at(Directions::SOUTH) == "cloth>" &&
+            turned_flag->sockets.at(Directions::EAST) == "pole" &&
+            mirrored_flag->sockets.at(Directions::WEST) == "cloth<" &&
+            mirrored_flag->sockets.at(Directions::NORTH) == "pole" && turned_flag->rules.empty());
+
+  /// Unknown symmetries, rules naming unknown tiles and variants clashing with a tile are rejected
+
+  auto rejected = [](const std::string& p_tiles) {
+    try {
+      parse(p_tiles);
+    }
+    catch (const std::runtime_error&) {
+      return true;
+    }
+    return false;
+  };
+  test_case(rejected(R"({"line": {"path": "line.png", "symmetry": "Q", "rules": {}}})") &&
+            rejected(R"({"line": {"path": "line.png", "rules": {"north": ["line#1"]}}})") &&
+            rejected(R"({"line": {"path": "line.png", "symmetry": "I", "rules": {}},
+                         "line#1": {"path": "line.png", "rules": {}}})"));
+
+  test_results();
+}
+
+int main(void) {
+  test();
+  return 0;
+}